@@ -0,0 +1,155 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavfilter/avfilter.h>
+}
+
+#include <QGuiApplication>
+#include <QSurfaceFormat>
+
+#include "bench/benchmarkreport.h"
+#include "bench/benchmarksuite.h"
+#include "bench/syntheticproject.h"
+#include "common/commandlineparser.h"
+#include "common/debug.h"
+#include "core.h"
+
+int main(int argc, char *argv[])
+{
+  // Set up debug handler
+  qInstallMessageHandler(OLIVE_NAMESPACE::DebugHandler);
+
+  // Generate version string, results are tagged with it so they can be compared across builds
+  QString app_version = APPVERSION;
+#ifdef GITHASH
+  app_version.append("-");
+  app_version.append(GITHASH);
+#endif
+
+  // Use the same application metadata as the editor so the same config and cache are used
+  QCoreApplication::setOrganizationName("olivevideoeditor.org");
+  QCoreApplication::setOrganizationDomain("olivevideoeditor.org");
+  QCoreApplication::setApplicationName("Olive");
+
+  QCoreApplication::setApplicationVersion(app_version);
+
+  //
+  // Parse command line arguments
+  //
+
+  CommandLineParser parser;
+
+  const CommandLineParser::Option* help_option =
+      parser.AddOption({QStringLiteral("h"), QStringLiteral("-help")},
+                       QCoreApplication::translate("main", "Show this help text"));
+
+  const CommandLineParser::Option* quick_option =
+      parser.AddOption({QStringLiteral("q"), QStringLiteral("-quick")},
+                       QCoreApplication::translate("main", "Run a smaller workload for a quick sanity check"));
+
+  const CommandLineParser::PositionalArgument* output_argument =
+      parser.AddPositionalArgument(QStringLiteral("output"),
+                                   QCoreApplication::translate("main", "JSON file to write results to (default: olive-bench.json)"));
+
+  const CommandLineParser::PositionalArgument* media_argument =
+      parser.AddPositionalArgument(QStringLiteral("media"),
+                                   QCoreApplication::translate("main", "Media file to decode and use as a clip source"));
+
+  parser.Process(argc, argv);
+
+  if (help_option->IsSet()) {
+    parser.PrintHelp(argv[0]);
+    return 0;
+  }
+
+  // Set OpenGL display profile (3.2 Core)
+  QSurfaceFormat format;
+  format.setVersion(3, 2);
+  format.setDepthBufferSize(24);
+  format.setProfile(QSurfaceFormat::CoreProfile);
+  QSurfaceFormat::setDefaultFormat(format);
+
+  // The renderer needs OpenGL so this must be a GUI application, even though it never shows a
+  // window. On machines without a display, run with QT_QPA_PLATFORM=offscreen.
+  QGuiApplication a(argc, argv);
+
+  // Register FFmpeg codecs and filters (deprecated in 4.0+)
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+  av_register_all();
+#endif
+#if LIBAVFILTER_VERSION_INT < AV_VERSION_INT(7, 14, 100)
+  avfilter_register_all();
+#endif
+
+  OLIVE_NAMESPACE::Core::CoreParams startup_params;
+  startup_params.set_run_mode(OLIVE_NAMESPACE::Core::CoreParams::kHeadlessBenchmark);
+
+  OLIVE_NAMESPACE::Core c(startup_params);
+  c.Start();
+
+  int video_tracks, audio_tracks, clips_per_track, frame_count;
+
+  if (quick_option->IsSet()) {
+    video_tracks = 2;
+    audio_tracks = 2;
+    clips_per_track = 2;
+    frame_count = 30;
+  } else {
+    video_tracks = 4;
+    audio_tracks = 4;
+    clips_per_track = 10;
+    frame_count = 300;
+  }
+
+  OLIVE_NAMESPACE::BenchmarkReport report;
+
+  report.AddParameter(QStringLiteral("video_tracks"), video_tracks);
+  report.AddParameter(QStringLiteral("audio_tracks"), audio_tracks);
+  report.AddParameter(QStringLiteral("clips_per_track"), clips_per_track);
+  report.AddParameter(QStringLiteral("frames"), frame_count);
+  report.AddParameter(QStringLiteral("media"), media_argument->GetSetting());
+
+  {
+    OLIVE_NAMESPACE::SyntheticProject project(video_tracks, audio_tracks, clips_per_track, media_argument->GetSetting());
+
+    OLIVE_NAMESPACE::BenchmarkSuite::Render(&project, &report, frame_count);
+    OLIVE_NAMESPACE::BenchmarkSuite::Export(&project, &report, frame_count);
+    OLIVE_NAMESPACE::BenchmarkSuite::Decode(&project, &report, frame_count);
+    OLIVE_NAMESPACE::BenchmarkSuite::ColorConversion(&project, &report);
+  }
+
+  OLIVE_NAMESPACE::BenchmarkSuite::MemoryPoolContention(&report);
+  OLIVE_NAMESPACE::BenchmarkSuite::SampleBufferKernels(&report);
+
+  QString output_filename = output_argument->GetSetting();
+
+  if (output_filename.isEmpty()) {
+    output_filename = QStringLiteral("olive-bench.json");
+  }
+
+  bool saved = report.Save(output_filename);
+
+  // Clear core memory
+  c.Stop();
+
+  return saved ? 0 : 1;
+}
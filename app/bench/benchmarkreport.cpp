@@ -0,0 +1,91 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "benchmarkreport.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QThread>
+
+OLIVE_NAMESPACE_ENTER
+
+void BenchmarkReport::AddResult(const QString &group, const QString &name, double value, const QString &unit)
+{
+  QJsonObject o;
+  o.insert(QStringLiteral("group"), group);
+  o.insert(QStringLiteral("name"), name);
+  o.insert(QStringLiteral("value"), value);
+  o.insert(QStringLiteral("unit"), unit);
+  results_.append(o);
+
+  qInfo().noquote() << QStringLiteral("%1/%2:").arg(group, name) << value << unit;
+}
+
+void BenchmarkReport::AddSkipped(const QString &group, const QString &name, const QString &reason)
+{
+  QJsonObject o;
+  o.insert(QStringLiteral("group"), group);
+  o.insert(QStringLiteral("name"), name);
+  o.insert(QStringLiteral("skipped"), reason);
+  results_.append(o);
+
+  qInfo().noquote() << QStringLiteral("%1/%2: skipped (%3)").arg(group, name, reason);
+}
+
+void BenchmarkReport::AddParameter(const QString &name, const QVariant &value)
+{
+  parameters_.insert(name, QJsonValue::fromVariant(value));
+}
+
+bool BenchmarkReport::Save(const QString &filename) const
+{
+  QFile f(filename);
+
+  if (!f.open(QFile::WriteOnly)) {
+    qWarning() << "Failed to open" << filename << "for writing";
+    return false;
+  }
+
+  // Enough about the machine and build to tell whether two result files are comparable
+  QJsonObject environment;
+  environment.insert(QStringLiteral("version"), QCoreApplication::applicationVersion());
+  environment.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+  environment.insert(QStringLiteral("os"), QSysInfo::prettyProductName());
+  environment.insert(QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture());
+  environment.insert(QStringLiteral("threads"), QThread::idealThreadCount());
+  environment.insert(QStringLiteral("date"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+
+  QJsonObject root;
+  root.insert(QStringLiteral("environment"), environment);
+  root.insert(QStringLiteral("parameters"), parameters_);
+  root.insert(QStringLiteral("results"), results_);
+
+  f.write(QJsonDocument(root).toJson());
+
+  f.close();
+
+  return true;
+}
+
+OLIVE_NAMESPACE_EXIT
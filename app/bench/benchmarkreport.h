@@ -0,0 +1,77 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QVariant>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Collects benchmark measurements and writes them out in a machine-readable form
+ *
+ * Every measurement belongs to a group (e.g. "render" or "cache") and has a name, a value and a
+ * unit. Benchmarks that couldn't run (e.g. because no media was provided) are recorded as skipped
+ * with a reason rather than silently left out, so that a missing number in a comparison is never
+ * mistaken for a regression.
+ */
+class BenchmarkReport
+{
+public:
+  BenchmarkReport() = default;
+
+  DISABLE_COPY_MOVE(BenchmarkReport)
+
+  /**
+   * @brief Record a measurement and print it to the console
+   */
+  void AddResult(const QString& group, const QString& name, double value, const QString& unit);
+
+  /**
+   * @brief Record that a benchmark didn't run and why
+   */
+  void AddSkipped(const QString& group, const QString& name, const QString& reason);
+
+  /**
+   * @brief Record a description of the input the benchmarks ran on (e.g. track count)
+   */
+  void AddParameter(const QString& name, const QVariant& value);
+
+  /**
+   * @brief Write all results to a JSON file
+   */
+  bool Save(const QString& filename) const;
+
+private:
+  QJsonObject parameters_;
+
+  QJsonArray results_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // BENCHMARKREPORT_H
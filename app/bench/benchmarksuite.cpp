@@ -0,0 +1,393 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "benchmarksuite.h"
+
+#include <cmath>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrent>
+#include <QtMath>
+
+#include "bench/renderbenchmarktask.h"
+#include "codec/decoder.h"
+#include "codec/samplebuffer.h"
+#include "common/channellayout.h"
+#include "common/memorypool.h"
+#include "common/timecodefunctions.h"
+#include "project/item/footage/videostream.h"
+#include "render/colormanager.h"
+#include "render/colorprocessor.h"
+#include "task/export/export.h"
+
+OLIVE_NAMESPACE_ENTER
+
+void BenchmarkSuite::Render(SyntheticProject *project, BenchmarkReport *report, int frame_count)
+{
+  RenderBenchmarkTask task(project->sequence()->viewer_output(), report, frame_count);
+
+  RunTask(&task);
+}
+
+void BenchmarkSuite::Export(SyntheticProject *project, BenchmarkReport *report, int frame_count)
+{
+  QTemporaryDir dir;
+
+  if (!dir.isValid()) {
+    report->AddSkipped(QStringLiteral("export"), QStringLiteral("fps"), QStringLiteral("couldn't create a temporary directory"));
+    return;
+  }
+
+  Sequence* sequence = project->sequence();
+  ColorManager* color_manager = project->project()->color_manager();
+
+  rational length = Timecode::timestamp_to_time(frame_count, sequence->video_params().time_base());
+  QString display = color_manager->GetDefaultDisplay();
+
+  ExportParams params;
+  params.SetFilename(dir.filePath(QStringLiteral("export.mov")));
+  params.SetExportLength(length);
+  params.set_custom_range(TimeRange(0, length));
+
+  // ProRes and PCM are built into every FFmpeg, so this doesn't depend on optional encoders
+  params.EnableVideo(sequence->video_params(), ExportCodec::kCodecProRes);
+  params.set_video_pix_fmt(QStringLiteral("yuv422p10le"));
+  params.set_color_transform(ColorTransform(display, color_manager->GetDefaultView(display), QString()));
+  params.EnableAudio(sequence->audio_params(), ExportCodec::kCodecPCM);
+
+  ExportTask task(sequence->viewer_output(), color_manager, params);
+
+  QElapsedTimer timer;
+  timer.start();
+
+  if (RunTask(&task)) {
+    double elapsed = timer.nsecsElapsed() * 1e-9;
+
+    report->AddResult(QStringLiteral("export"), QStringLiteral("fps"), frame_count / elapsed, QStringLiteral("frames/s"));
+  } else {
+    report->AddSkipped(QStringLiteral("export"), QStringLiteral("fps"), task.GetError());
+  }
+}
+
+void BenchmarkSuite::Decode(SyntheticProject *project, BenchmarkReport *report, int frame_count)
+{
+  QString skip_reason;
+  VideoStreamPtr stream;
+
+  if (!project->media()) {
+    skip_reason = QStringLiteral("no media provided");
+  } else {
+    stream = std::static_pointer_cast<VideoStream>(project->media()->get_first_stream_of_type(Stream::kVideo));
+
+    if (!stream) {
+      skip_reason = QStringLiteral("media has no video stream");
+    }
+  }
+
+  DecoderPtr decoder;
+
+  if (skip_reason.isEmpty()) {
+    decoder = Decoder::CreateFromID(project->media()->decoder());
+
+    if (!decoder) {
+      skip_reason = QStringLiteral("no decoder for media");
+    } else {
+      decoder->set_stream(stream);
+
+      if (!decoder->Open()) {
+        skip_reason = QStringLiteral("failed to open decoder");
+      }
+    }
+  }
+
+  if (!skip_reason.isEmpty()) {
+    report->AddSkipped(QStringLiteral("decode"), QStringLiteral("sequential_fps"), skip_reason);
+    report->AddSkipped(QStringLiteral("decode"), QStringLiteral("random_access_fps"), skip_reason);
+    return;
+  }
+
+  rational frame_timebase = stream->frame_rate().flipped();
+
+  int64_t stream_frames = Timecode::time_to_timestamp(Timecode::timestamp_to_time(stream->duration(),
+                                                                                  stream->timebase()),
+                                                      frame_timebase);
+
+  int count = static_cast<int>(qMin(static_cast<int64_t>(frame_count), stream_frames));
+
+  QElapsedTimer timer;
+  int decoded = 0;
+
+  // Playback order
+  timer.start();
+
+  for (int i=0;i<count;i++) {
+    if (decoder->RetrieveVideo(Timecode::timestamp_to_time(i, frame_timebase), 1)) {
+      decoded++;
+    }
+  }
+
+  report->AddResult(QStringLiteral("decode"), QStringLiteral("sequential_fps"), decoded / (timer.nsecsElapsed() * 1e-9), QStringLiteral("frames/s"));
+
+  // Jump around the whole stream the way scrubbing does, a large prime stride keeps the order
+  // repeatable without ever landing on neighbouring frames
+  decoded = 0;
+  timer.restart();
+
+  for (int i=0;i<count;i++) {
+    int64_t ts = (static_cast<int64_t>(i) * 7919) % stream_frames;
+
+    if (decoder->RetrieveVideo(Timecode::timestamp_to_time(ts, frame_timebase), 1)) {
+      decoded++;
+    }
+  }
+
+  report->AddResult(QStringLiteral("decode"), QStringLiteral("random_access_fps"), decoded / (timer.nsecsElapsed() * 1e-9), QStringLiteral("frames/s"));
+
+  decoder->Close();
+}
+
+void BenchmarkSuite::ColorConversion(SyntheticProject *project, BenchmarkReport *report)
+{
+  ColorManager* color_manager = project->project()->color_manager();
+
+  // The conversion every piece of footage goes through on its way into the reference space
+  ColorProcessorPtr processor = ColorProcessor::Create(color_manager,
+                                                       color_manager->GetDefaultInputColorSpace(),
+                                                       color_manager->GetReferenceColorSpace());
+
+  struct Resolution {
+    QString name;
+    int width;
+    int height;
+    int iterations;
+  };
+
+  const Resolution resolutions[] = {{QStringLiteral("4k"), 3840, 2160, 16},
+                                    {QStringLiteral("8k"), 7680, 4320, 4}};
+
+  for (const Resolution& r : resolutions) {
+    FramePtr frame = Frame::Create();
+    frame->set_video_params(VideoParams(r.width, r.height, PixelFormat::PIX_FMT_RGBA32F));
+    frame->allocate();
+
+    if (!frame->is_allocated()) {
+      report->AddSkipped(QStringLiteral("color"), QStringLiteral("convert_%1").arg(r.name), QStringLiteral("couldn't allocate frame"));
+      continue;
+    }
+
+    // Fill with a gradient so the transform has real values to work on
+    for (int y=0;y<r.height;y++) {
+      float* row = reinterpret_cast<float*>(frame->data() + y * frame->linesize_bytes());
+
+      for (int x=0;x<r.width;x++) {
+        float v = static_cast<float>(x) / r.width;
+
+        row[x*4] = v;
+        row[x*4+1] = 1.0f - v;
+        row[x*4+2] = static_cast<float>(y) / r.height;
+        row[x*4+3] = 1.0f;
+      }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i=0;i<r.iterations;i++) {
+      processor->ConvertFrame(frame);
+    }
+
+    double elapsed = timer.nsecsElapsed() * 1e-9;
+
+    report->AddResult(QStringLiteral("color"), QStringLiteral("convert_%1").arg(r.name), r.iterations / elapsed, QStringLiteral("fps"));
+    report->AddResult(QStringLiteral("color"), QStringLiteral("convert_%1_throughput").arg(r.name),
+                      static_cast<double>(r.width) * r.height * r.iterations / elapsed / 1000000.0,
+                      QStringLiteral("Mpixels/s"));
+  }
+}
+
+void BenchmarkSuite::MemoryPoolContention(BenchmarkReport *report)
+{
+  // Roughly the size of a small decoded plane
+  struct Element {
+    char data[4096];
+  };
+
+  const int kIterations = 20000;
+
+  // One thread for the uncontended baseline, then enough to oversubscribe most machines the way
+  // several decoders and render workers do
+  const int thread_counts[] = {1, 32};
+
+  for (int thread_count : thread_counts) {
+    MemoryPool<Element> pool(64);
+
+    QThreadPool threads;
+    threads.setMaxThreadCount(thread_count);
+
+    QVector< QFuture<void> > futures(thread_count);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i=0;i<thread_count;i++) {
+      futures[i] = QtConcurrent::run(&threads, [&pool](){
+        for (int j=0;j<kIterations;j++) {
+          // Hold two at once so elements are released out of order
+          MemoryPool<Element>::ElementPtr a = pool.Get();
+          MemoryPool<Element>::ElementPtr b = pool.Get();
+
+          a->data()->data[0] = 1;
+          b->data()->data[0] = 1;
+        }
+      });
+    }
+
+    for (QFuture<void>& f : futures) {
+      f.waitForFinished();
+    }
+
+    double elapsed = timer.nsecsElapsed() * 1e-9;
+
+    report->AddResult(QStringLiteral("memorypool"),
+                      QStringLiteral("get_release_%1_threads").arg(thread_count),
+                      (thread_count * kIterations * 2) / elapsed / 1000000.0,
+                      QStringLiteral("Mops/s"));
+  }
+}
+
+void BenchmarkSuite::SampleBufferKernels(BenchmarkReport *report)
+{
+  const int kIterations = 8;
+
+  AudioParams params(48000, AV_CH_LAYOUT_STEREO, SampleFormat::kInternalFormat);
+
+  // Ten seconds of a 440Hz sine, a real signal rather than silence so nothing can take a shortcut
+  SampleBufferPtr source = SampleBuffer::CreateAllocated(params, params.sample_rate() * 10);
+
+  for (int i=0;i<params.channel_count();i++) {
+    float* channel = source->channel_data(i);
+
+    for (int j=0;j<source->sample_count();j++) {
+      channel[j] = static_cast<float>(qSin(2.0 * M_PI * 440.0 * j / params.sample_rate()));
+    }
+  }
+
+  double msamples = static_cast<double>(source->sample_count()) * params.channel_count() * kIterations / 1000000.0;
+
+  QElapsedTimer timer;
+
+  timer.start();
+  for (int i=0;i<kIterations;i++) {
+    source->transform_volume((i%2) ? 2.0f : 0.5f);
+  }
+  report->AddResult(QStringLiteral("samplebuffer"), QStringLiteral("volume"), msamples / (timer.nsecsElapsed() * 1e-9), QStringLiteral("Msamples/s"));
+
+  timer.restart();
+  for (int i=0;i<kIterations;i++) {
+    source->reverse();
+  }
+  report->AddResult(QStringLiteral("samplebuffer"), QStringLiteral("reverse"), msamples / (timer.nsecsElapsed() * 1e-9), QStringLiteral("Msamples/s"));
+
+  const SampleBuffer::SpeedQuality qualities[] = {SampleBuffer::kSpeedQualityNearest,
+                                                  SampleBuffer::kSpeedQualityLinear,
+                                                  SampleBuffer::kSpeedQualityHigh};
+  const QString quality_names[] = {QStringLiteral("nearest"), QStringLiteral("linear"), QStringLiteral("high")};
+
+  QByteArray packed = source->toPackedData();
+
+  for (int i=0;i<3;i++) {
+    // speed() replaces the buffer's contents, so every iteration needs its own copy
+    QVector<SampleBufferPtr> copies(kIterations);
+    for (int j=0;j<kIterations;j++) {
+      copies[j] = SampleBuffer::CreateFromPackedData(params, packed);
+    }
+
+    timer.restart();
+    foreach (SampleBufferPtr b, copies) {
+      b->speed(1.5, qualities[i]);
+    }
+    report->AddResult(QStringLiteral("samplebuffer"), QStringLiteral("speed_%1").arg(quality_names[i]), msamples / (timer.nsecsElapsed() * 1e-9), QStringLiteral("Msamples/s"));
+  }
+
+  // Speeding up a 17-23kHz sweep by 1.5x moves all of it above the output's Nyquist frequency, so
+  // ideally nothing is left afterwards. Any energy that remains has folded back down as aliasing.
+  const double kSweepSpeed = 1.5;
+  const double kSweepStart = 17000.0;
+  const double kSweepEnd = 23000.0;
+
+  SampleBufferPtr sweep = SampleBuffer::CreateAllocated(params, params.sample_rate());
+
+  double phase = 0.0;
+  double input_energy = 0.0;
+
+  for (int j=0;j<sweep->sample_count();j++) {
+    double freq = kSweepStart + (kSweepEnd - kSweepStart) * j / sweep->sample_count();
+    float v = static_cast<float>(qSin(phase));
+
+    for (int i=0;i<params.channel_count();i++) {
+      sweep->channel_data(i)[j] = v;
+    }
+
+    input_energy += v * v;
+    phase += 2.0 * M_PI * freq / params.sample_rate();
+  }
+
+  input_energy /= sweep->sample_count();
+
+  QByteArray sweep_packed = sweep->toPackedData();
+
+  for (int i=0;i<3;i++) {
+    SampleBufferPtr b = SampleBuffer::CreateFromPackedData(params, sweep_packed);
+
+    b->speed(kSweepSpeed, qualities[i]);
+
+    const float* channel = b->channel_data(0);
+    double output_energy = 0.0;
+
+    for (int j=0;j<b->sample_count();j++) {
+      output_energy += channel[j] * channel[j];
+    }
+
+    output_energy /= b->sample_count();
+
+    // Relative to the sweep's own level, lower is better
+    double aliasing_db = 10.0 * std::log10(qMax(output_energy / input_energy, 1e-20));
+
+    report->AddResult(QStringLiteral("samplebuffer"), QStringLiteral("speed_%1_aliasing").arg(quality_names[i]), aliasing_db, QStringLiteral("dB"));
+  }
+}
+
+bool BenchmarkSuite::RunTask(Task *task)
+{
+  QFutureWatcher<bool> watcher;
+  QEventLoop loop;
+
+  QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+
+  watcher.setFuture(QtConcurrent::run(task, &Task::Start));
+
+  loop.exec();
+
+  return watcher.result();
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,84 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef BENCHMARKSUITE_H
+#define BENCHMARKSUITE_H
+
+#include "bench/benchmarkreport.h"
+#include "bench/syntheticproject.h"
+#include "task/task.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief The individual benchmarks run by olive-bench
+ *
+ * Each function records its measurements (or the reason it was skipped) in the report it's given.
+ * All of them must be called from the main thread.
+ */
+class BenchmarkSuite
+{
+public:
+  /**
+   * @brief Hash, frame, audio and disk cache benchmarks on a project's sequence
+   */
+  static void Render(SyntheticProject* project, BenchmarkReport* report, int frame_count);
+
+  /**
+   * @brief Export the beginning of a project's sequence through ExportTask
+   */
+  static void Export(SyntheticProject* project, BenchmarkReport* report, int frame_count);
+
+  /**
+   * @brief Sequential and random access decoding of a project's media
+   */
+  static void Decode(SyntheticProject* project, BenchmarkReport* report, int frame_count);
+
+  /**
+   * @brief ColorProcessor::ConvertFrame on 4K and 8K RGBA float frames using a project's color config
+   */
+  static void ColorConversion(SyntheticProject* project, BenchmarkReport* report);
+
+  /**
+   * @brief Many threads taking and returning elements from one MemoryPool at once
+   */
+  static void MemoryPoolContention(BenchmarkReport* report);
+
+  /**
+   * @brief Throughput of the SampleBuffer kernels used on every clip with speed or volume changes
+   *
+   * Also measures how much aliasing each speed quality lets through.
+   */
+  static void SampleBufferKernels(BenchmarkReport* report);
+
+private:
+  /**
+   * @brief Run a task on another thread while this one keeps processing events
+   *
+   * RenderTasks block on tickets that their backend only dispatches from the thread it was
+   * created on, so they can't simply be run where they're created.
+   */
+  static bool RunTask(Task* task);
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // BENCHMARKSUITE_H
@@ -0,0 +1,233 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "renderbenchmarktask.h"
+
+#include <algorithm>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "common/timecodefunctions.h"
+
+OLIVE_NAMESPACE_ENTER
+
+RenderBenchmarkTask::RenderBenchmarkTask(ViewerOutput *viewer, BenchmarkReport *report, int frame_count) :
+  RenderTask(viewer, viewer->video_params(), viewer->audio_params()),
+  report_(report),
+  frame_count_(frame_count)
+{
+  SetTitle(tr("Benchmarking render"));
+}
+
+bool RenderBenchmarkTask::Run()
+{
+  QVector<rational> times(frame_count_);
+
+  for (int i=0;i<frame_count_;i++) {
+    times[i] = Timecode::timestamp_to_time(i, video_params().time_base());
+  }
+
+  BenchmarkHash(times);
+
+  FramePtr frame = BenchmarkFrameLatency(times);
+
+  BenchmarkFrameThroughput(times);
+
+  BenchmarkAudio();
+
+  if (frame) {
+    BenchmarkFrameCache(frame);
+  } else {
+    report_->AddSkipped(QStringLiteral("cache"), QStringLiteral("save"), QStringLiteral("no frame was rendered"));
+    report_->AddSkipped(QStringLiteral("cache"), QStringLiteral("load"), QStringLiteral("no frame was rendered"));
+  }
+
+  return true;
+}
+
+QFuture<void> RenderBenchmarkTask::DownloadFrame(FramePtr frame, const QByteArray &hash)
+{
+  // Render() is never used by this task
+  Q_UNUSED(frame)
+  Q_UNUSED(hash)
+
+  return QFuture<void>();
+}
+
+void RenderBenchmarkTask::FrameDownloaded(const QByteArray &hash, const std::list<rational> &times, qint64 job_time)
+{
+  Q_UNUSED(hash)
+  Q_UNUSED(times)
+  Q_UNUSED(job_time)
+}
+
+void RenderBenchmarkTask::AudioDownloaded(const TimeRange &range, SampleBufferPtr samples, qint64 job_time)
+{
+  Q_UNUSED(range)
+  Q_UNUSED(samples)
+  Q_UNUSED(job_time)
+}
+
+void RenderBenchmarkTask::BenchmarkHash(const QVector<rational> &times)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  backend()->Hash(times)->WaitForFinished();
+
+  double elapsed = timer.nsecsElapsed() * 1e-9;
+
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("hash_throughput"), times.size() / elapsed, QStringLiteral("frames/s"));
+}
+
+FramePtr RenderBenchmarkTask::BenchmarkFrameLatency(const QVector<rational> &times)
+{
+  QElapsedTimer timer;
+  FramePtr frame;
+
+  // The first frame pays for shader compilation and decoder startup, so it's reported on its own
+  timer.start();
+  frame = backend()->RenderFrame(times.first())->Get().value<FramePtr>();
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("first_frame_latency"), timer.nsecsElapsed() * 1e-6, QStringLiteral("ms"));
+
+  QVector<double> latencies(times.size());
+
+  for (int i=0;i<times.size();i++) {
+    timer.restart();
+
+    frame = backend()->RenderFrame(times.at(i))->Get().value<FramePtr>();
+
+    latencies[i] = timer.nsecsElapsed() * 1e-6;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  double total = 0;
+  foreach (double l, latencies) {
+    total += l;
+  }
+
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("frame_latency_mean"), total / latencies.size(), QStringLiteral("ms"));
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("frame_latency_median"), latencies.at(latencies.size() / 2), QStringLiteral("ms"));
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("frame_latency_p95"), latencies.at((latencies.size() * 95) / 100), QStringLiteral("ms"));
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("frame_latency_max"), latencies.last(), QStringLiteral("ms"));
+
+  return frame;
+}
+
+void RenderBenchmarkTask::BenchmarkFrameThroughput(const QVector<rational> &times)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Queue everything at once so the backend can spread frames across its workers
+  QVector<RenderTicketPtr> tickets(times.size());
+
+  for (int i=0;i<times.size();i++) {
+    tickets[i] = backend()->RenderFrame(times.at(i));
+  }
+
+  foreach (RenderTicketPtr t, tickets) {
+    t->WaitForFinished();
+  }
+
+  double elapsed = timer.nsecsElapsed() * 1e-9;
+
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("frame_throughput"), times.size() / elapsed, QStringLiteral("frames/s"));
+}
+
+void RenderBenchmarkTask::BenchmarkAudio()
+{
+  TimeRange range(0, viewer()->GetLength());
+
+  std::list<TimeRange> chunks = RenderBackend::SplitRangeIntoChunks(range, audio_params(), audio_chunk_length());
+
+  QElapsedTimer timer;
+  timer.start();
+
+  QVector<RenderTicketPtr> tickets;
+  tickets.reserve(static_cast<int>(chunks.size()));
+
+  for (const TimeRange& r : chunks) {
+    tickets.append(backend()->RenderAudio(r));
+  }
+
+  foreach (RenderTicketPtr t, tickets) {
+    t->WaitForFinished();
+  }
+
+  double elapsed = timer.nsecsElapsed() * 1e-9;
+
+  // How many seconds of the mix are rendered per second of wall time
+  report_->AddResult(QStringLiteral("render"), QStringLiteral("audio_realtime_factor"), range.length().toDouble() / elapsed, QStringLiteral("x"));
+}
+
+void RenderBenchmarkTask::BenchmarkFrameCache(FramePtr frame)
+{
+  // Enough iterations to even out filesystem noise without taking long on slow disks
+  const int kIterations = 16;
+
+  QTemporaryDir dir;
+
+  if (!dir.isValid()) {
+    report_->AddSkipped(QStringLiteral("cache"), QStringLiteral("save"), QStringLiteral("couldn't create a temporary directory"));
+    report_->AddSkipped(QStringLiteral("cache"), QStringLiteral("load"), QStringLiteral("couldn't create a temporary directory"));
+    return;
+  }
+
+  FrameHashCache* cache = viewer()->video_frame_cache();
+  double frame_mb = static_cast<double>(frame->allocated_size()) / (1024.0 * 1024.0);
+
+  QStringList filenames;
+
+  for (int i=0;i<kIterations;i++) {
+    filenames.append(dir.filePath(QString::number(i).append(FrameHashCache::GetFormatExtension())));
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  foreach (const QString& fn, filenames) {
+    cache->SaveCacheFrame(fn, const_cast<char*>(frame->const_data()), frame->video_params(), frame->linesize_bytes());
+  }
+
+  double elapsed = timer.nsecsElapsed() * 1e-9;
+
+  report_->AddResult(QStringLiteral("cache"), QStringLiteral("save"), (frame_mb * kIterations) / elapsed, QStringLiteral("MB/s"));
+
+  timer.restart();
+
+  foreach (const QString& fn, filenames) {
+    FrameHashCache::LoadCacheFrame(fn);
+  }
+
+  elapsed = timer.nsecsElapsed() * 1e-9;
+
+  report_->AddResult(QStringLiteral("cache"), QStringLiteral("load"), (frame_mb * kIterations) / elapsed, QStringLiteral("MB/s"));
+
+  double file_mb = static_cast<double>(QFileInfo(filenames.first()).size()) / (1024.0 * 1024.0);
+
+  if (file_mb > 0) {
+    report_->AddResult(QStringLiteral("cache"), QStringLiteral("compression_ratio"), frame_mb / file_mb, QStringLiteral("x"));
+  }
+}
+
+OLIVE_NAMESPACE_EXIT
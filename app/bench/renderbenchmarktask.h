@@ -0,0 +1,72 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef RENDERBENCHMARKTASK_H
+#define RENDERBENCHMARKTASK_H
+
+#include "bench/benchmarkreport.h"
+#include "task/render/render.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Times the render backend on a viewer's graph
+ *
+ * Measures hash throughput, single frame latency (the way a viewer requests frames while
+ * scrubbing), queued frame throughput (the way RenderTask requests them), audio render speed and
+ * FrameHashCache save/load speed on the frames that were rendered.
+ *
+ * Like any RenderTask, Run() blocks on render tickets so it must run on a different thread from
+ * the one the task was created on, and that thread must be processing events.
+ */
+class RenderBenchmarkTask : public RenderTask
+{
+public:
+  RenderBenchmarkTask(ViewerOutput* viewer, BenchmarkReport* report, int frame_count);
+
+protected:
+  virtual bool Run() override;
+
+  virtual QFuture<void> DownloadFrame(FramePtr frame, const QByteArray &hash) override;
+
+  virtual void FrameDownloaded(const QByteArray& hash, const std::list<rational>& times, qint64 job_time) override;
+
+  virtual void AudioDownloaded(const TimeRange& range, SampleBufferPtr samples, qint64 job_time) override;
+
+private:
+  void BenchmarkHash(const QVector<rational>& times);
+
+  FramePtr BenchmarkFrameLatency(const QVector<rational>& times);
+
+  void BenchmarkFrameThroughput(const QVector<rational>& times);
+
+  void BenchmarkAudio();
+
+  void BenchmarkFrameCache(FramePtr frame);
+
+  BenchmarkReport* report_;
+
+  int frame_count_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // RENDERBENCHMARKTASK_H
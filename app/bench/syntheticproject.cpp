@@ -0,0 +1,185 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "syntheticproject.h"
+
+#include "codec/decoder.h"
+#include "common/channellayout.h"
+#include "node/audio/pan/pan.h"
+#include "node/audio/volume/volume.h"
+#include "node/block/clip/clip.h"
+#include "node/block/transition/crossdissolve/crossdissolvetransition.h"
+#include "node/filter/blur/blur.h"
+#include "node/generator/matrix/matrix.h"
+#include "node/generator/solid/solid.h"
+#include "node/input/media/audio/audio.h"
+#include "node/input/media/video/video.h"
+#include "node/math/math/math.h"
+
+OLIVE_NAMESPACE_ENTER
+
+const rational SyntheticProject::kClipLength = rational(2);
+const rational SyntheticProject::kTransitionLength = rational(1, 2);
+
+SyntheticProject::SyntheticProject(int video_tracks, int audio_tracks, int clips_per_track, const QString &media_filename)
+{
+  if (!media_filename.isEmpty()) {
+    media_ = Decoder::ProbeMedia(&project_, media_filename, nullptr);
+
+    if (media_) {
+      project_.root()->add_child(media_);
+    } else {
+      qWarning() << "Failed to probe" << media_filename;
+    }
+  }
+
+  sequence_ = std::make_shared<Sequence>();
+  sequence_->set_name(QStringLiteral("Benchmark"));
+
+  // Use fixed parameters rather than the user's defaults so results are comparable between machines
+  sequence_->set_video_params(VideoParams(1920, 1080, rational(1, 30), PixelFormat::PIX_FMT_RGBA16F));
+  sequence_->set_audio_params(AudioParams(48000, AV_CH_LAYOUT_STEREO, SampleFormat::kInternalFormat));
+
+  sequence_->add_default_nodes();
+
+  project_.root()->add_child(sequence_);
+
+  const int track_counts[] = {video_tracks, audio_tracks};
+  const Timeline::TrackType track_types[] = {Timeline::kTrackTypeVideo, Timeline::kTrackTypeAudio};
+
+  for (int i=0;i<2;i++) {
+    TrackList* list = sequence_->viewer_output()->track_list(track_types[i]);
+
+    for (int j=0;j<track_counts[i];j++) {
+      // add_default_nodes() has already created the first track of each type, every track after
+      // it is mixed in automatically by TrackList
+      TrackOutput* track = (j < list->GetTrackCount()) ? list->GetTrackAt(j) : list->AddTrack();
+
+      AddClips(track, j, clips_per_track);
+    }
+  }
+}
+
+void SyntheticProject::AddClips(TrackOutput *track, int track_index, int clip_count)
+{
+  Block* previous = nullptr;
+
+  for (int i=0;i<clip_count;i++) {
+    ClipBlock* clip = AddNode<ClipBlock>();
+    clip->set_length_and_media_out(kClipLength);
+
+    Node* source;
+
+    if (track->track_type() == Timeline::kTrackTypeVideo) {
+      source = CreateVideoSource(track_index, i);
+    } else {
+      source = CreateAudioSource(track_index);
+    }
+
+    NodeParam::ConnectEdge(source->output(), clip->texture_input());
+
+    if (previous) {
+      // Dual transition between this clip and the last one
+      CrossDissolveTransition* transition = AddNode<CrossDissolveTransition>();
+      transition->set_length_and_media_out(kTransitionLength);
+      transition->set_media_in(-kTransitionLength/2);
+
+      track->AppendBlock(transition);
+
+      NodeParam::ConnectEdge(previous->output(), transition->out_block_input());
+      NodeParam::ConnectEdge(clip->output(), transition->in_block_input());
+    }
+
+    track->AppendBlock(clip);
+
+    previous = clip;
+  }
+}
+
+Node *SyntheticProject::CreateVideoSource(int track_index, int clip_index)
+{
+  Node* source = nullptr;
+
+  if (media_) {
+    StreamPtr stream = media_->get_first_stream_of_type(Stream::kVideo);
+
+    if (stream) {
+      VideoInput* input = AddNode<VideoInput>();
+      input->SetStream(stream);
+      source = input;
+    }
+  }
+
+  if (!source) {
+    source = AddNode<SolidGenerator>();
+  }
+
+  // Blur radius ramps differently on every clip so that no two clips hash the same
+  BlurFilterNode* blur = AddNode<BlurFilterNode>();
+  NodeParam::ConnectEdge(source->output(), blur->GetInputWithID(QStringLiteral("tex_in")));
+  AddRamp(blur->GetInputWithID(QStringLiteral("radius_in")),
+          0.0f,
+          static_cast<float>(5 + track_index + clip_index));
+
+  MatrixGenerator* transform = AddNode<MatrixGenerator>();
+  AddRamp(transform->GetInputWithID(QStringLiteral("rot_in")), 0.0f, 90.0f);
+
+  // Multiplying a texture by a matrix transforms it
+  MathNode* apply = AddNode<MathNode>();
+  apply->SetOperation(MathNode::kOpMultiply);
+  NodeParam::ConnectEdge(blur->output(), apply->param_a_in());
+  NodeParam::ConnectEdge(transform->output(), apply->param_b_in());
+
+  return apply;
+}
+
+Node *SyntheticProject::CreateAudioSource(int track_index)
+{
+  VolumeNode* volume = AddNode<VolumeNode>();
+
+  if (media_) {
+    StreamPtr stream = media_->get_first_stream_of_type(Stream::kAudio);
+
+    if (stream) {
+      AudioInput* input = AddNode<AudioInput>();
+      input->SetStream(stream);
+      NodeParam::ConnectEdge(input->output(), volume->samples_input());
+    }
+  }
+
+  // Fade each clip in
+  AddRamp(volume->GetInputWithID(QStringLiteral("volume_in")), 0.0f, 1.0f);
+
+  // Spread tracks across the stereo field
+  PanNode* pan = AddNode<PanNode>();
+  NodeParam::ConnectEdge(volume->output(), pan->GetInputWithID(QStringLiteral("samples_in")));
+  pan->GetInputWithID(QStringLiteral("panning_in"))->set_standard_value((track_index % 2) ? 0.5f : -0.5f);
+
+  return pan;
+}
+
+void SyntheticProject::AddRamp(NodeInput *input, const QVariant &start, const QVariant &end)
+{
+  input->set_is_keyframing(true);
+  input->insert_keyframe(NodeKeyframe::Create(0, start, NodeKeyframe::kLinear, 0));
+  input->insert_keyframe(NodeKeyframe::Create(kClipLength, end, NodeKeyframe::kLinear, 0));
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,105 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef SYNTHETICPROJECT_H
+#define SYNTHETICPROJECT_H
+
+#include "project/item/footage/footage.h"
+#include "project/item/sequence/sequence.h"
+#include "project/project.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief A generated project used as a repeatable benchmark workload
+ *
+ * Builds a sequence with a fixed number of video and audio tracks, each filled with clips joined
+ * by cross dissolves. Every video clip runs through a keyframed blur and a keyframed transform,
+ * every audio clip through a keyframed volume and a pan, and the tracks are mixed together by the
+ * nodes TrackList creates for them. The resulting graph stresses hashing, the shader pipeline and
+ * audio mixing the same way a real edit does.
+ *
+ * If media is provided, clips source it through VideoInput and AudioInput nodes. Otherwise video
+ * clips use solid generators and audio clips are left unconnected, so the workload still runs on
+ * machines without any sample footage.
+ */
+class SyntheticProject
+{
+public:
+  SyntheticProject(int video_tracks, int audio_tracks, int clips_per_track, const QString& media_filename = QString());
+
+  DISABLE_COPY_MOVE(SyntheticProject)
+
+  Project* project()
+  {
+    return &project_;
+  }
+
+  Sequence* sequence() const
+  {
+    return sequence_.get();
+  }
+
+  /**
+   * @brief Probed media or nullptr if none was provided or it couldn't be probed
+   */
+  FootagePtr media() const
+  {
+    return media_;
+  }
+
+  /**
+   * @brief Length of every clip in the sequence
+   */
+  static const rational kClipLength;
+
+  /**
+   * @brief Length of the transitions between clips
+   */
+  static const rational kTransitionLength;
+
+private:
+  void AddClips(TrackOutput* track, int track_index, int clip_count);
+
+  Node* CreateVideoSource(int track_index, int clip_index);
+
+  Node* CreateAudioSource(int track_index);
+
+  template <typename T>
+  T* AddNode()
+  {
+    T* n = new T();
+    sequence_->AddNode(n);
+    return n;
+  }
+
+  static void AddRamp(NodeInput* input, const QVariant& start, const QVariant& end);
+
+  Project project_;
+
+  SequencePtr sequence_;
+
+  FootagePtr media_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // SYNTHETICPROJECT_H
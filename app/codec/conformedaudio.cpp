@@ -0,0 +1,235 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "conformedaudio.h"
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+#include <QDataStream>
+#include <QDebug>
+
+OLIVE_NAMESPACE_ENTER
+
+const quint32 ConformedAudioInput::kMagic = 0x4F434146; // "OCAF"
+const quint32 ConformedAudioInput::kVersion = 1;
+QHash<QString, std::weak_ptr<ConformedAudioInput> > ConformedAudioInput::instances_;
+QMutex ConformedAudioInput::instances_lock_;
+
+ConformedAudioOutput::ConformedAudioOutput(const QString &filename, const AudioParams &params) :
+  filename_(filename),
+  params_(params),
+  sample_count_(0)
+{
+}
+
+ConformedAudioOutput::~ConformedAudioOutput()
+{
+  if (!channel_files_.isEmpty()) {
+    close(false);
+  }
+}
+
+bool ConformedAudioOutput::open()
+{
+  // Remove any existing header first so the conform isn't seen as complete until we're done
+  QFile::remove(filename_);
+
+  for (int i=0; i<params_.channel_count(); i++) {
+    QFile* f = new QFile(ConformedAudioInput::GetChannelFilename(filename_, i));
+
+    channel_files_.append(f);
+
+    if (!f->open(QFile::WriteOnly)) {
+      qCritical() << "Failed to open conformed audio channel file" << f->fileName();
+      close(false);
+      return false;
+    }
+  }
+
+  sample_count_ = 0;
+
+  return true;
+}
+
+void ConformedAudioOutput::write(const float **data, int nb_samples)
+{
+  for (int i=0; i<channel_files_.size(); i++) {
+    channel_files_.at(i)->write(reinterpret_cast<const char*>(data[i]),
+                                qint64(nb_samples) * qint64(sizeof(float)));
+  }
+
+  sample_count_ += nb_samples;
+}
+
+void ConformedAudioOutput::close(bool success)
+{
+  foreach (QFile* f, channel_files_) {
+    f->close();
+
+    if (!success) {
+      f->remove();
+    }
+
+    delete f;
+  }
+
+  channel_files_.clear();
+
+  if (success) {
+    QFile header(filename_);
+
+    if (header.open(QFile::WriteOnly)) {
+      QDataStream s(&header);
+
+      s << ConformedAudioInput::kMagic
+        << ConformedAudioInput::kVersion
+        << qint32(params_.sample_rate())
+        << quint64(params_.channel_layout())
+        << qint32(params_.format())
+        << qint64(sample_count_);
+
+      header.close();
+    } else {
+      qCritical() << "Failed to write conformed audio header" << filename_;
+    }
+  }
+}
+
+ConformedAudioInput::ConformedAudioInput() :
+  sample_count_(0)
+{
+}
+
+ConformedAudioInput::~ConformedAudioInput()
+{
+  // Closing the files also unmaps them
+  qDeleteAll(channel_files_);
+}
+
+std::shared_ptr<ConformedAudioInput> ConformedAudioInput::Get(const QString &filename)
+{
+  QMutexLocker locker(&instances_lock_);
+
+  std::shared_ptr<ConformedAudioInput> input = instances_.value(filename).lock();
+
+  if (!input) {
+    input = std::make_shared<ConformedAudioInput>();
+
+    if (!input->Open(filename)) {
+      instances_.remove(filename);
+      return nullptr;
+    }
+
+    instances_.insert(filename, input);
+  }
+
+  return input;
+}
+
+SampleBufferPtr ConformedAudioInput::Read(const rational &time, const rational &length)
+{
+  // Convert in 64-bit, AudioParams::time_to_samples() returns an int which overflows on long media
+  qint64 start = qMax(qint64(0), av_rescale_rnd(time.numerator(), params_.sample_rate(), time.denominator(), AV_ROUND_DOWN));
+  qint64 count = qMin(av_rescale_rnd(length.numerator(), params_.sample_rate(), length.denominator(), AV_ROUND_DOWN),
+                      sample_count_ - start);
+
+  if (count <= 0) {
+    return nullptr;
+  }
+
+  QVector<const float*> data(channel_data_.size());
+
+  for (int i=0; i<data.size(); i++) {
+    data[i] = channel_data_.at(i) + start;
+  }
+
+  return SampleBuffer::CreateView(params_, static_cast<int>(count), data.data(), shared_from_this());
+}
+
+bool ConformedAudioInput::Open(const QString &filename)
+{
+  QFile header(filename);
+
+  if (!header.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream s(&header);
+
+  quint32 magic, version;
+  qint32 sample_rate, format;
+  quint64 channel_layout;
+
+  s >> magic >> version;
+
+  if (magic != kMagic || version != kVersion) {
+    return false;
+  }
+
+  s >> sample_rate >> channel_layout >> format >> sample_count_;
+
+  if (s.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  params_ = AudioParams(sample_rate, channel_layout, static_cast<SampleFormat::Format>(format));
+
+  if (!params_.is_valid() || params_.format() != SampleFormat::SAMPLE_FMT_FLT) {
+    return false;
+  }
+
+  if (!sample_count_) {
+    // Nothing to map, but still a valid conform
+    return true;
+  }
+
+  qint64 channel_sz = sample_count_ * qint64(sizeof(float));
+
+  for (int i=0; i<params_.channel_count(); i++) {
+    QFile* f = new QFile(GetChannelFilename(filename, i));
+
+    channel_files_.append(f);
+
+    if (!f->open(QFile::ReadOnly) || f->size() < channel_sz) {
+      qWarning() << "Conformed audio channel file is missing or incomplete" << f->fileName();
+      return false;
+    }
+
+    const float* data = reinterpret_cast<const float*>(f->map(0, channel_sz));
+
+    if (!data) {
+      qWarning() << "Failed to map conformed audio channel file" << f->fileName();
+      return false;
+    }
+
+    channel_data_.append(data);
+  }
+
+  return true;
+}
+
+QString ConformedAudioInput::GetChannelFilename(const QString &filename, int channel)
+{
+  return QStringLiteral("%1.%2").arg(filename, QString::number(channel));
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,139 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef CONFORMEDAUDIO_H
+#define CONFORMEDAUDIO_H
+
+#include <memory>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "codec/samplebuffer.h"
+#include "common/rational.h"
+#include "render/audioparams.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Writes a conformed audio stream to the disk cache
+ *
+ * Conformed audio is stored planar, one raw float file per channel alongside a small header file
+ * that's written last to mark the conform as complete. Being planar means ConformedAudioInput can
+ * hand out SampleBuffers that point straight into the files without deinterleaving or copying.
+ */
+class ConformedAudioOutput
+{
+public:
+  ConformedAudioOutput(const QString& filename, const AudioParams& params);
+
+  ~ConformedAudioOutput();
+
+  DISABLE_COPY_MOVE(ConformedAudioOutput)
+
+  bool open();
+
+  /**
+   * @brief Append planar float samples, one array per channel
+   */
+  void write(const float** data, int nb_samples);
+
+  /**
+   * @brief Close all files, writing the header if `success` is true or deleting them otherwise
+   */
+  void close(bool success);
+
+private:
+  QString filename_;
+
+  AudioParams params_;
+
+  QVector<QFile*> channel_files_;
+
+  qint64 sample_count_;
+
+};
+
+/**
+ * @brief Read-only, memory mapped view of a conformed audio stream written by ConformedAudioOutput
+ *
+ * One instance is shared per file between all threads (see Get()), and is kept alive by any
+ * SampleBuffers that reference it.
+ */
+class ConformedAudioInput : public std::enable_shared_from_this<ConformedAudioInput>
+{
+public:
+  ConformedAudioInput();
+
+  ~ConformedAudioInput();
+
+  DISABLE_COPY_MOVE(ConformedAudioInput)
+
+  /**
+   * @brief Get the shared input for this filename, opening it if it isn't already
+   *
+   * @return The input, or nullptr if the file doesn't exist or is incomplete.
+   */
+  static std::shared_ptr<ConformedAudioInput> Get(const QString& filename);
+
+  const AudioParams& params() const
+  {
+    return params_;
+  }
+
+  qint64 sample_count() const
+  {
+    return sample_count_;
+  }
+
+  /**
+   * @brief Create a SampleBuffer that references this range of samples without copying them
+   *
+   * Ranges past the end of the stream are clamped. Returns nullptr if the range is empty.
+   */
+  SampleBufferPtr Read(const rational& time, const rational& length);
+
+private:
+  bool Open(const QString& filename);
+
+  static QString GetChannelFilename(const QString& filename, int channel);
+
+  static const quint32 kMagic;
+  static const quint32 kVersion;
+
+  static QHash<QString, std::weak_ptr<ConformedAudioInput> > instances_;
+  static QMutex instances_lock_;
+
+  friend class ConformedAudioOutput;
+
+  AudioParams params_;
+
+  qint64 sample_count_;
+
+  QVector<QFile*> channel_files_;
+
+  QVector<const float*> channel_data_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // CONFORMEDAUDIO_H
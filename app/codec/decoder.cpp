@@ -24,9 +24,11 @@
 #include <QDebug>
 #include <QFileInfo>
 
+#include "codec/conformedaudio.h"
 #include "codec/ffmpeg/ffmpegcommon.h"
 #include "codec/ffmpeg/ffmpegdecoder.h"
 #include "codec/oiio/oiiodecoder.h"
+#include "codec/probecache.h"
 #include "codec/waveinput.h"
 #include "codec/waveoutput.h"
 #include "common/filefunctions.h"
@@ -112,6 +114,24 @@ FootagePtr Decoder::ProbeMedia(Project* project, const QString &filename, const
     return nullptr;
   }
 
+  QFileInfo file_info(filename);
+
+  // See if we've already probed this file before
+  FootagePtr cached = ProbeCache::Get(filename);
+
+  if (cached) {
+    cached->set_name(file_info.fileName());
+    cached->set_filename(filename);
+    cached->set_project(project);
+    cached->set_timestamp(file_info.lastModified().toMSecsSinceEpoch());
+
+    cached->SetValid();
+
+    MoveStreamsToMainThread(cached);
+
+    return cached;
+  }
+
   // Create list to iterate through
   QVector<DecoderPtr> decoder_list = ReceiveListOfAllDecoders();
 
@@ -127,7 +147,6 @@ FootagePtr Decoder::ProbeMedia(Project* project, const QString &filename, const
     FootagePtr footage = decoder->Probe(filename, cancelled);
 
     if (footage) {
-      QFileInfo file_info(filename);
       footage->set_name(file_info.fileName());
       footage->set_filename(filename);
 
@@ -137,7 +156,9 @@ FootagePtr Decoder::ProbeMedia(Project* project, const QString &filename, const
 
       footage->SetValid();
 
-      // FIXME: Cache the results so we don't have to probe if this media is added a second time
+      ProbeCache::Put(filename, footage);
+
+      MoveStreamsToMainThread(footage);
 
       return footage;
     }
@@ -147,6 +168,13 @@ FootagePtr Decoder::ProbeMedia(Project* project, const QString &filename, const
   return nullptr;
 }
 
+void Decoder::MoveStreamsToMainThread(FootagePtr footage)
+{
+  foreach (StreamPtr stream, footage->streams()) {
+    stream->moveToThread(qApp->thread());
+  }
+}
+
 DecoderPtr Decoder::CreateFromID(const QString &id)
 {
   if (id.isEmpty()) {
@@ -201,6 +229,12 @@ bool Decoder::HasConformedVersion(const AudioParams &params)
     return true;
   }
 
+  // See if a conform from a previous session is still in the cache
+  if (ConformedAudioInput::Get(GetConformedFilename(params))) {
+    audio_stream->append_conformed_version(params);
+    return true;
+  }
+
   // Get indexed WAV file
   WaveInput input(GetIndexFilename());
 
@@ -188,7 +188,9 @@ public:
    * functions until one indicates that it can decode this file. That Decoder will then dump information about the file
    * into the Footage object for use throughout the program.
    *
-   * Probing may be a lengthy process and it's recommended to run this in a separate thread.
+   * Probing may be a lengthy process and it's recommended to run this in a separate thread. The
+   * returned footage's streams are moved to the main thread regardless of which thread this was
+   * called from, since Qt can only push an object away from the thread it lives in.
    *
    * @param f
    *
@@ -258,6 +260,8 @@ protected:
   bool open_;
 
 private:
+  static void MoveStreamsToMainThread(FootagePtr footage);
+
   StreamPtr stream_;
 
 };
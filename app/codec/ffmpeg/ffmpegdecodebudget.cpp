@@ -0,0 +1,274 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "ffmpegdecodebudget.h"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+#include <QThread>
+
+#if defined(Q_OS_WINDOWS)
+#include <Windows.h>
+#elif defined(Q_OS_MAC)
+#include <mach/mach.h>
+#else
+#include <QFile>
+#include <unistd.h>
+#endif
+
+OLIVE_NAMESPACE_ENTER
+
+QHash<const void*, int> FFmpegDecodeBudget::thread_allocations_;
+QHash<const void*, FFmpegDecodeBudget::InstanceStatistics> FFmpegDecodeBudget::statistics_;
+QMutex FFmpegDecodeBudget::lock_;
+
+// Beyond this, FFmpeg's own threading stops scaling for most codecs
+const int FFmpegDecodeBudget::kMaxThreadsPerInstance = 16;
+
+// Frame pools may use up to 1/8 of available memory between them
+const int FFmpegDecodeBudget::kFramePoolMemoryDivisor = 8;
+
+FFmpegDecodeBudget::ThreadAllocation FFmpegDecodeBudget::AcquireThreads(const void *instance, const AVCodec *codec)
+{
+  QMutexLocker locker(&lock_);
+
+  ThreadAllocation a = {1, 0};
+
+  bool supports_frame = (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS);
+  bool supports_slice = (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS);
+
+  const AVCodecDescriptor* desc = avcodec_descriptor_get(codec->id);
+  bool intra_only = desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY);
+
+  if (supports_slice && (intra_only || !supports_frame)) {
+    a.thread_type = FF_THREAD_SLICE;
+  } else if (supports_frame) {
+    a.thread_type = FF_THREAD_FRAME;
+  }
+
+  if (a.thread_type) {
+    // Register with a placeholder so this instance is counted in the fair share
+    thread_allocations_.insert(instance, 0);
+
+    a.thread_count = GetTargetThreadCount(instance);
+
+    thread_allocations_.insert(instance, a.thread_count);
+  }
+
+  return a;
+}
+
+void FFmpegDecodeBudget::ReleaseThreads(const void *instance)
+{
+  QMutexLocker locker(&lock_);
+
+  thread_allocations_.remove(instance);
+}
+
+int FFmpegDecodeBudget::GetRebalancedThreadCount(const void *instance)
+{
+  QMutexLocker locker(&lock_);
+
+  if (!thread_allocations_.contains(instance)) {
+    // Instance doesn't use threading
+    return 0;
+  }
+
+  int target = GetTargetThreadCount(instance);
+
+  if (target == thread_allocations_.value(instance)) {
+    return 0;
+  }
+
+  return target;
+}
+
+void FFmpegDecodeBudget::UpdateThreads(const void *instance, int thread_count)
+{
+  QMutexLocker locker(&lock_);
+
+  if (thread_allocations_.contains(instance)) {
+    thread_allocations_.insert(instance, thread_count);
+  }
+}
+
+int FFmpegDecodeBudget::GetThreadCap()
+{
+  return QThread::idealThreadCount();
+}
+
+int FFmpegDecodeBudget::GetAllocatedThreads()
+{
+  int total = 0;
+
+  foreach (int t, thread_allocations_) {
+    total += t;
+  }
+
+  return total;
+}
+
+int FFmpegDecodeBudget::GetTargetThreadCount(const void *instance)
+{
+  // Assumes lock_ is held and instance is in thread_allocations_
+  int cap = GetThreadCap();
+
+  // Split the cap evenly between all threaded instances, but never take more than the other
+  // instances have left over. Instances holding more than their share will give it back when they
+  // rebalance, at which point the others can grow into it.
+  int fair_share = cap / thread_allocations_.size();
+  int others = GetAllocatedThreads() - thread_allocations_.value(instance);
+
+  return qBound(1, qMin(fair_share, cap - others), kMaxThreadsPerInstance);
+}
+
+int FFmpegDecodeBudget::GetFramePoolSize(int width, int height, AVPixelFormat format, int pool_count)
+{
+  // Frames are allocated as threads * threads at most, to scale from each thread sharing one set
+  // to all of them working individually
+  int thread_count = QThread::idealThreadCount();
+  int max_frame_count = thread_count * thread_count;
+
+  int frame_sz = av_image_get_buffer_size(format, width, height, 1);
+  if (frame_sz <= 0) {
+    return max_frame_count;
+  }
+
+  qint64 memory_budget = GetAvailableMemory() / kFramePoolMemoryDivisor / qMax(1, pool_count);
+  if (memory_budget <= 0) {
+    return max_frame_count;
+  }
+
+  // Always allow at least one frame per thread, otherwise threads will just end up waiting
+  return static_cast<int>(qBound(static_cast<qint64>(thread_count),
+                                 memory_budget / frame_sz,
+                                 static_cast<qint64>(max_frame_count)));
+}
+
+void FFmpegDecodeBudget::ReportFrameDecoded(const void *instance, const QString &name, qint64 nsecs, int queue_depth)
+{
+  QMutexLocker locker(&lock_);
+
+  InstanceStatistics& stats = statistics_[instance];
+
+  if (stats.name.isEmpty()) {
+    stats.name = name;
+    stats.average_nsecs = nsecs;
+  } else {
+    // Exponential moving average so the figure tracks recent performance
+    stats.average_nsecs = stats.average_nsecs * 0.9 + nsecs * 0.1;
+  }
+
+  stats.queue_depth = queue_depth;
+}
+
+void FFmpegDecodeBudget::RemoveInstance(const void *instance)
+{
+  QMutexLocker locker(&lock_);
+
+  statistics_.remove(instance);
+}
+
+QVector<FFmpegDecodeBudget::StreamStatistics> FFmpegDecodeBudget::GetStatistics()
+{
+  QMutexLocker locker(&lock_);
+
+  QVector<StreamStatistics> list;
+
+  foreach (const InstanceStatistics& i, statistics_) {
+    StreamStatistics* stream_stats = nullptr;
+
+    for (int j=0; j<list.size(); j++) {
+      if (list.at(j).name == i.name) {
+        stream_stats = &list[j];
+        break;
+      }
+    }
+
+    if (!stream_stats) {
+      list.append({i.name, 0, 0.0, 0});
+      stream_stats = &list.last();
+    }
+
+    // Instances of the same stream decode in parallel, so their rates add up
+    stream_stats->instance_count++;
+    stream_stats->queue_depth += i.queue_depth;
+
+    if (i.average_nsecs > 0) {
+      stream_stats->decode_fps += 1000000000.0 / i.average_nsecs;
+    }
+  }
+
+  return list;
+}
+
+qint64 FFmpegDecodeBudget::GetAvailableMemory()
+{
+#if defined(Q_OS_WINDOWS)
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+
+  if (GlobalMemoryStatusEx(&status)) {
+    return static_cast<qint64>(status.ullAvailPhys);
+  }
+#elif defined(Q_OS_MAC)
+  vm_statistics64_data_t vm_stats;
+  mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+
+  if (host_statistics64(mach_host_self(),
+                        HOST_VM_INFO64,
+                        reinterpret_cast<host_info64_t>(&vm_stats),
+                        &count) == KERN_SUCCESS) {
+    // Inactive pages can be reclaimed without swapping
+    return static_cast<qint64>(vm_stats.free_count + vm_stats.inactive_count) * static_cast<qint64>(vm_page_size);
+  }
+#else
+  // MemAvailable includes reclaimable cache, which free pages (below) don't
+  QFile meminfo(QStringLiteral("/proc/meminfo"));
+
+  if (meminfo.open(QFile::ReadOnly)) {
+    QList<QByteArray> lines = meminfo.readAll().split('\n');
+
+    foreach (const QByteArray& line, lines) {
+      if (line.startsWith("MemAvailable:")) {
+        // Reported in kB
+        qint64 kb = line.mid(13).trimmed().split(' ').first().toLongLong();
+
+        if (kb > 0) {
+          return kb * 1024;
+        }
+      }
+    }
+  }
+
+  long pages = sysconf(_SC_AVPHYS_PAGES);
+  long page_size = sysconf(_SC_PAGESIZE);
+
+  if (pages > 0 && page_size > 0) {
+    return static_cast<qint64>(pages) * static_cast<qint64>(page_size);
+  }
+#endif
+
+  return 0;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,149 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef FFMPEGDECODEBUDGET_H
+#define FFMPEGDECODEBUDGET_H
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Shares decoding threads and frame memory between all open FFmpegDecoderInstances
+ *
+ * Letting every instance use "threads=auto" means several instances of the same stream (plus
+ * every other stream on the timeline) each try to claim every core, and they all compete with
+ * the render workers. Instead, each instance acquires a share of a global thread cap when it
+ * opens and returns it when it closes. As instances open and close, the fair share changes and
+ * existing instances are asked to reopen their codecs with the new count (see
+ * GetRebalancedThreadCount()).
+ *
+ * This also collects per-stream decode statistics (shown in Help > Memory Statistics) so dense
+ * timelines can be tuned.
+ */
+class FFmpegDecodeBudget
+{
+public:
+  struct ThreadAllocation {
+    int thread_count;
+    int thread_type;
+  };
+
+  struct StreamStatistics {
+    QString name;
+    int instance_count;
+    double decode_fps;
+    int queue_depth;
+  };
+
+  /**
+   * @brief Choose a thread count and threading type for a new decoder of this codec
+   *
+   * Intra-only codecs (ProRes, DNxHD, etc.) prefer slice threading since it doesn't add latency
+   * when seeking around. Long-GOP codecs prefer frame threading for throughput.
+   *
+   * The thread count is the instance's fair share of the cap, limited to whatever the other
+   * instances haven't claimed so the total never exceeds the cap (except that every instance gets
+   * at least one thread).
+   *
+   * Must be balanced with a call to ReleaseThreads() once the decoder is closed.
+   */
+  static ThreadAllocation AcquireThreads(const void* instance, const AVCodec* codec);
+
+  static void ReleaseThreads(const void* instance);
+
+  /**
+   * @brief Check whether an instance's thread count no longer matches its fair share
+   *
+   * @return
+   *
+   * The thread count the instance should reopen its codec with, or 0 if it should keep its
+   * current one. Once the codec has been reopened, call UpdateThreads() with the new count.
+   */
+  static int GetRebalancedThreadCount(const void* instance);
+
+  static void UpdateThreads(const void* instance, int thread_count);
+
+  /**
+   * @brief Number of frames an FFmpegFramePool arena should hold for frames of this size
+   *
+   * Derived from the thread count and a single memory budget (a fraction of the memory currently
+   * available) split evenly between every live pool, so large frames (e.g. 8K) or many streams
+   * don't claim several gigabytes between them.
+   *
+   * @param pool_count
+   *
+   * Number of frame pools that will be alive once this one is created (including itself).
+   */
+  static int GetFramePoolSize(int width, int height, AVPixelFormat format, int pool_count);
+
+  /**
+   * @brief Record that a decoder instance decoded a frame
+   *
+   * @param instance
+   *
+   * An identifier for the instance (usually its `this` pointer).
+   *
+   * @param name
+   *
+   * Name of the stream the instance is decoding, used to group instances in GetStatistics().
+   */
+  static void ReportFrameDecoded(const void* instance, const QString& name, qint64 nsecs, int queue_depth);
+
+  static void RemoveInstance(const void* instance);
+
+  static QVector<StreamStatistics> GetStatistics();
+
+private:
+  static qint64 GetAvailableMemory();
+
+  static int GetThreadCap();
+
+  static int GetAllocatedThreads();
+
+  static int GetTargetThreadCount(const void* instance);
+
+  struct InstanceStatistics {
+    QString name;
+    double average_nsecs;
+    int queue_depth;
+  };
+
+  // Thread counts of instances that use threading, keyed by instance
+  static QHash<const void*, int> thread_allocations_;
+  static QHash<const void*, InstanceStatistics> statistics_;
+  static QMutex lock_;
+
+  static const int kMaxThreadsPerInstance;
+  static const int kFramePoolMemoryDivisor;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // FFMPEGDECODEBUDGET_H
@@ -29,6 +29,7 @@ extern "C" {
 
 #include <OpenImageIO/imagebuf.h>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QString>
@@ -36,12 +37,13 @@ extern "C" {
 #include <QThread>
 #include <QtConcurrent/QtConcurrent>
 
-#include "codec/waveinput.h"
+#include "codec/conformedaudio.h"
 #include "common/define.h"
 #include "common/filefunctions.h"
 #include "common/functiontimer.h"
 #include "common/timecodefunctions.h"
 #include "ffmpegcommon.h"
+#include "ffmpegdecodebudget.h"
 #include "render/framehashcache.h"
 #include "render/diskmanager.h"
 #include "render/pixelformat.h"
@@ -56,9 +58,15 @@ QHash< FFmpegDecoder::FFmpegFramePoolKey, FFmpegDecoder::FFmpegFramePoolValue >
 //        this a dynamic value somehow or a configurable value?
 const int FFmpegDecoderInstance::kMaxFrameLife = 2000;
 
+// Bands smaller than this aren't worth the overhead of dispatching to another thread
+const int FFmpegDecoder::kMinimumScaleSliceHeight = 64;
+
 FFmpegDecoder::FFmpegDecoder() :
-  scale_ctx_(nullptr),
-  scale_divider_(0)
+  scale_divider_(0),
+  audio_instance_(nullptr),
+  audio_resampler_(nullptr),
+  audio_position_(-1),
+  audio_carry_offset_(0)
 {
 }
 
@@ -107,11 +115,11 @@ bool FFmpegDecoder::Open()
     FFmpegFramePoolValue& frame_pool = frame_pool_map_[key];
 
     if (!frame_pool.pool) {
-      // Frames are allocated as threads * threads, to scale from each thread sharing one set
-      // to all of them working individually
-      int thread_count = QThread::idealThreadCount();
-      int max_memory_frame_count = thread_count * thread_count;
-      frame_pool.pool = new FFmpegFramePool(max_memory_frame_count);
+      // Map already contains the new pool, so its size is the number of pools that will be alive
+      frame_pool.pool = new FFmpegFramePool(FFmpegDecodeBudget::GetFramePoolSize(vs->width(),
+                                                                             vs->height(),
+                                                                             src_pix_fmt_,
+                                                                             frame_pool_map_.size()));
     }
     frame_pool.handles++;
 
@@ -315,7 +323,16 @@ FramePtr FFmpegDecoder::RetrieveVideo(const rational &timecode, const int &divid
       working_instance->cache_lock()->unlock();
     }
 
-    // We found the frame, we'll return a copy
+    // We found the frame, if it's already in a format we can use, return it directly
+    if (return_frame) {
+      FramePtr view = PoolElementToNativeFrame(return_frame, divider, vs->width(), vs->height(), timecode);
+
+      if (view) {
+        return view;
+      }
+    }
+
+    // Otherwise we'll return a converted copy
     if (return_frame) {
       // Align buffer to data/linesize points that can be passed to sws_scale
       uint8_t* input_data[4];
@@ -353,25 +370,232 @@ SampleBufferPtr FFmpegDecoder::RetrieveAudio(const rational &timecode, const rat
     return nullptr;
   }
 
-  QString wav_fn = GetConformedFilename(params);
-  WaveInput input(wav_fn);
+  QString conformed_fn = GetConformedFilename(params);
+
+  // Shared between all decoders of this stream, so this doesn't touch the file system unless
+  // nothing has read this conform yet
+  std::shared_ptr<ConformedAudioInput> input = ConformedAudioInput::Get(conformed_fn);
+
+  if (input) {
+    return input->Read(timecode, length);
+  }
+
+  // No conform (yet), decode this range directly
+  return DecodeAudioRange(timecode, length, params);
+}
 
-  if (input.open()) {
-    const AudioParams& input_params = input.params();
+SampleBufferPtr FFmpegDecoder::DecodeAudioRange(const rational &timecode, const rational &length, const AudioParams &params)
+{
+  AudioParams out_params(params.sample_rate(), params.channel_layout(), SampleFormat::SAMPLE_FMT_FLT);
 
-    // Read bytes from wav
-    QByteArray packed_data = input.read(input_params.time_to_bytes(timecode), input_params.time_to_bytes(length));
-    input.close();
+  // Convert the range in 64-bit, AudioParams::time_to_samples() returns an int which overflows on
+  // long media
+  rational end_time = timecode + length;
+  qint64 start = av_rescale_rnd(timecode.numerator(), out_params.sample_rate(), timecode.denominator(), AV_ROUND_DOWN);
+  qint64 end = av_rescale_rnd(end_time.numerator(), out_params.sample_rate(), end_time.denominator(), AV_ROUND_DOWN);
 
-    // Create sample buffer
-    SampleBufferPtr sample_buffer = SampleBuffer::CreateFromPackedData(input_params, packed_data);
+  if (end <= start) {
+    return nullptr;
+  }
 
-    return sample_buffer;
+  if (end - start > INT_MAX) {
+    qWarning() << "Audio range too large to decode at once:" << (end - start) << "samples";
+    return nullptr;
   }
 
-  qCritical() << "Failed to open cached file" << wav_fn;
+  int count = static_cast<int>(end - start);
 
-  return nullptr;
+  if (!audio_instance_) {
+    audio_instance_ = new FFmpegDecoderInstance(stream()->footage()->filename().toUtf8(),
+                                                stream()->index());
+
+    if (!audio_instance_->IsValid()) {
+      FreeAudioDecoder();
+      return nullptr;
+    }
+  }
+
+  // Only seek if this request doesn't pick up where the last one left off
+  bool continues_previous = audio_resampler_
+      && audio_resampler_params_ == out_params
+      && audio_position_ >= 0
+      && start >= audio_position_
+      && start <= audio_position_ + (audio_carry_ ? audio_carry_->sample_count() - audio_carry_offset_ : 0);
+
+  if (!continues_previous && !SeekAudio(start, out_params)) {
+    return nullptr;
+  }
+
+  SampleBufferPtr output = SampleBuffer::CreateAllocated(out_params, count);
+
+  // Anything we can't decode (e.g. past the end of the file) is left silent
+  output->fill(0.0f);
+
+  AVStream* avstream = audio_instance_->stream();
+  int64_t start_pts = (avstream->start_time == AV_NOPTS_VALUE) ? 0 : avstream->start_time;
+
+  AVPacket* pkt = av_packet_alloc();
+  AVFrame* frame = av_frame_alloc();
+
+  int written = 0;
+
+  while (written < count) {
+    qint64 target = start + written;
+
+    if (audio_carry_ && audio_carry_offset_ < audio_carry_->sample_count()) {
+      int carry_count = audio_carry_->sample_count() - audio_carry_offset_;
+
+      if (audio_position_ > target) {
+        // Decoded audio starts after our target, leave the gap silent
+        written = static_cast<int>(qMin(qint64(count), audio_position_ - start));
+        continue;
+      }
+
+      // Discard samples before our target, then copy as many as we can use
+      int skip = static_cast<int>(qMin(qint64(carry_count), target - audio_position_));
+      int copy = qMin(carry_count - skip, count - written);
+
+      if (copy > 0) {
+        QVector<const float*> src(out_params.channel_count());
+
+        for (int i=0; i<src.size(); i++) {
+          src[i] = audio_carry_->const_data()[i] + audio_carry_offset_ + skip;
+        }
+
+        output->set(src.data(), written, copy);
+
+        written += copy;
+      }
+
+      audio_carry_offset_ += skip + copy;
+      audio_position_ += skip + copy;
+
+      continue;
+    }
+
+    int ret = audio_instance_->GetFrame(pkt, frame);
+
+    if (ret < 0) {
+      if (ret != AVERROR_EOF) {
+        char err_str[50];
+        av_strerror(ret, err_str, 50);
+        qWarning() << "Failed to decode audio:" << ret << err_str;
+      }
+
+      // Nothing more to decode, next request will need to seek again
+      audio_position_ = -1;
+      break;
+    }
+
+    if (audio_position_ < 0) {
+      // First frame after a seek, determine where in the stream we are
+      audio_position_ = qMax(qint64(0), av_rescale_q(frame->pts - start_pts,
+                                                      avstream->time_base,
+                                                      {1, out_params.sample_rate()}));
+    }
+
+    int nb_samples = swr_get_out_samples(audio_resampler_, frame->nb_samples);
+
+    if (nb_samples <= 0) {
+      continue;
+    }
+
+    SampleBufferPtr decoded = SampleBuffer::CreateAllocated(out_params, nb_samples);
+
+    nb_samples = swr_convert(audio_resampler_,
+                             reinterpret_cast<uint8_t**>(decoded->data()),
+                             nb_samples,
+                             const_cast<const uint8_t**>(frame->data),
+                             frame->nb_samples);
+
+    if (nb_samples < 0) {
+      char err_str[50];
+      av_strerror(nb_samples, err_str, 50);
+      qWarning() << "libswresample failed with error:" << nb_samples << err_str;
+      audio_position_ = -1;
+      break;
+    }
+
+    if (nb_samples == 0) {
+      continue;
+    }
+
+    // The resampler may buffer some samples internally, so only keep the ones it converted
+    if (nb_samples == decoded->sample_count()) {
+      audio_carry_ = decoded;
+    } else {
+      audio_carry_ = SampleBuffer::CreateAllocated(out_params, nb_samples);
+      audio_carry_->set(decoded->const_data(), 0, nb_samples);
+    }
+    audio_carry_offset_ = 0;
+  }
+
+  av_frame_free(&frame);
+  av_packet_free(&pkt);
+
+  return output;
+}
+
+bool FFmpegDecoder::SeekAudio(qint64 sample, const AudioParams &params)
+{
+  AVStream* avstream = audio_instance_->stream();
+
+  if (audio_resampler_) {
+    swr_free(&audio_resampler_);
+  }
+
+  uint64_t channel_layout = ValidateChannelLayout(avstream);
+  if (!channel_layout) {
+    qCritical() << "Failed to determine channel layout of audio file, could not decode";
+    return false;
+  }
+
+  audio_resampler_ = swr_alloc_set_opts(nullptr,
+                                        params.channel_layout(),
+                                        AV_SAMPLE_FMT_FLTP,
+                                        params.sample_rate(),
+                                        channel_layout,
+                                        static_cast<AVSampleFormat>(avstream->codecpar->format),
+                                        avstream->codecpar->sample_rate,
+                                        0,
+                                        nullptr);
+
+  if (!audio_resampler_ || swr_init(audio_resampler_) < 0) {
+    qCritical() << "Failed to create audio resampler";
+    swr_free(&audio_resampler_);
+    return false;
+  }
+
+  audio_resampler_params_ = params;
+
+  int64_t start_pts = (avstream->start_time == AV_NOPTS_VALUE) ? 0 : avstream->start_time;
+
+  // Rescale the 64-bit sample index straight into the stream's timebase, going through
+  // AudioParams::samples_to_time() would narrow it to an int and overflow on long media
+  audio_instance_->Seek(start_pts + av_rescale_q(sample,
+                                                 {1, params.sample_rate()},
+                                                 avstream->time_base));
+
+  // Position will be determined from the first frame we decode
+  audio_position_ = -1;
+  audio_carry_ = nullptr;
+  audio_carry_offset_ = 0;
+
+  return true;
+}
+
+void FFmpegDecoder::FreeAudioDecoder()
+{
+  if (audio_resampler_) {
+    swr_free(&audio_resampler_);
+  }
+
+  delete audio_instance_;
+  audio_instance_ = nullptr;
+
+  audio_position_ = -1;
+  audio_carry_ = nullptr;
+  audio_carry_offset_ = 0;
 }
 
 void FFmpegDecoder::Close()
@@ -686,12 +910,9 @@ bool FFmpegDecoder::ConformAudio(const QAtomicInt *cancelled, const AudioParams
   if (QFileInfo::exists(conformed_fn)) {
 
     // If we have one, and we can open it correctly, we can use it as-is
-    WaveInput input(conformed_fn);
-    if (input.open()) {
+    if (ConformedAudioInput::Get(conformed_fn)) {
       audio_stream->append_conformed_version(p);
 
-      input.close();
-
       return true;
     }
   }
@@ -707,10 +928,10 @@ bool FFmpegDecoder::ConformAudio(const QAtomicInt *cancelled, const AudioParams
     return false;
   }
 
-  // Create resampling context
+  // Create resampling context, conforms are always stored as planar float
   SwrContext* resampler = swr_alloc_set_opts(nullptr,
                                              p.channel_layout(),
-                                             FFmpegCommon::GetFFmpegSampleFormat(p.format()),
+                                             AV_SAMPLE_FMT_FLTP,
                                              p.sample_rate(),
                                              channel_layout,
                                              static_cast<AVSampleFormat>(index_instance.stream()->codecpar->format),
@@ -720,7 +941,8 @@ bool FFmpegDecoder::ConformAudio(const QAtomicInt *cancelled, const AudioParams
 
   swr_init(resampler);
 
-  WaveOutput wave_out(conformed_fn, p);
+  AudioParams conformed_params(p.sample_rate(), p.channel_layout(), SampleFormat::SAMPLE_FMT_FLT);
+  ConformedAudioOutput conform_out(conformed_fn, conformed_params);
 
   AVPacket* pkt = av_packet_alloc();
   AVFrame* frame = av_frame_alloc();
@@ -728,7 +950,7 @@ bool FFmpegDecoder::ConformAudio(const QAtomicInt *cancelled, const AudioParams
 
   bool success = false;
 
-  if (wave_out.open()) {
+  if (conform_out.open()) {
     while (true) {
       // Check if we have a `cancelled` ptr and its value
       if (cancelled && *cancelled) {
@@ -752,11 +974,11 @@ bool FFmpegDecoder::ConformAudio(const QAtomicInt *cancelled, const AudioParams
 
       // Allocate buffers
       int nb_samples = swr_get_out_samples(resampler, frame->nb_samples);
-      char* data = new char[p.samples_to_bytes(nb_samples)];
+      SampleBufferPtr planes = SampleBuffer::CreateAllocated(conformed_params, nb_samples);
 
       // Resample audio to our destination parameters
       nb_samples = swr_convert(resampler,
-                               reinterpret_cast<uint8_t**>(&data),
+                               reinterpret_cast<uint8_t**>(planes->data()),
                                nb_samples,
                                const_cast<const uint8_t**>(frame->data),
                                frame->nb_samples);
@@ -768,32 +990,23 @@ bool FFmpegDecoder::ConformAudio(const QAtomicInt *cancelled, const AudioParams
         break;
       }
 
-      // Write packed WAV data to the disk cache
-      wave_out.write(data, p.samples_to_bytes(nb_samples));
-
-      // If we allocated an output for the resampler, delete it here
-      if (data != reinterpret_cast<char*>(frame->data[0])) {
-        delete [] data;
-      }
+      // Write planar data to the disk cache
+      conform_out.write(planes->const_data(), nb_samples);
 
       SignalProcessingProgress(frame->pts);
     }
 
-    wave_out.close();
+    // Writes the header if we succeeded, or deletes the incomplete conform otherwise
+    conform_out.close(success);
 
     if (success) {
 
       // If our conform succeeded, add it
       audio_stream->append_conformed_version(p);
 
-    } else {
-
-      // Audio index didn't complete, delete it
-      QFile(conformed_fn).remove();
-
     }
   } else {
-    qWarning() << "Failed to open WAVE output for indexing";
+    qWarning() << "Failed to open conformed audio output for indexing";
   }
 
   swr_free(&resampler);
@@ -857,17 +1070,74 @@ FramePtr FFmpegDecoder::BuffersToNativeFrame(int divider, int width, int height,
   uint8_t* output_data = reinterpret_cast<uint8_t*>(copy->data());
   int output_linesize = copy->linesize_bytes();
 
-  sws_scale(scale_ctx_,
-            input_data,
-            input_linesize,
-            0,
-            VideoParams::GetScaledDimension(height, divider),
-            &output_data,
-            &output_linesize);
+  const AVPixFmtDescriptor* src_desc = av_pix_fmt_desc_get(src_pix_fmt_);
+
+  auto scale_slice = [&](const ScaleSlice& slice) {
+    const uint8_t* slice_input_data[4];
+
+    for (int i=0; i<4; i++) {
+      if (input_data[i]) {
+        // Chroma planes may be vertically subsampled, so their row offset needs to be scaled too
+        int plane_y = (i == 1 || i == 2) ? (slice.y >> src_desc->log2_chroma_h) : slice.y;
+
+        slice_input_data[i] = input_data[i] + plane_y * input_linesize[i];
+      } else {
+        slice_input_data[i] = nullptr;
+      }
+    }
+
+    uint8_t* slice_output_data = output_data + slice.y * output_linesize;
+
+    sws_scale(slice.context,
+              slice_input_data,
+              input_linesize,
+              0,
+              slice.height,
+              &slice_output_data,
+              &output_linesize);
+  };
+
+  if (scale_slices_.isEmpty()) {
+    qCritical() << "Failed to create scaling context for" << stream()->footage()->filename();
+    return nullptr;
+  }
+
+  if (scale_slices_.size() == 1) {
+    scale_slice(scale_slices_.first());
+  } else {
+    QtConcurrent::blockingMap(scale_slices_, scale_slice);
+  }
 
   return copy;
 }
 
+FramePtr FFmpegDecoder::PoolElementToNativeFrame(FFmpegFramePool::ElementPtr element, int divider, int width, int height, const rational &ts)
+{
+  if (src_pix_fmt_ != ideal_pix_fmt_) {
+    // Needs a pixel format conversion, which requires a copy anyway
+    return nullptr;
+  }
+
+  int divided_width = VideoParams::GetScaledDimension(width, divider);
+
+  // The pool packs rows tightly, which can only be uploaded if each row happens to be 4-byte aligned
+  if ((divided_width * PixelFormat::BytesPerPixel(native_pix_fmt_)) % 4 != 0) {
+    return nullptr;
+  }
+
+  FramePtr view = Frame::Create();
+  view->set_video_params(VideoParams(width,
+                                     height,
+                                     native_pix_fmt_,
+                                     std::static_pointer_cast<VideoStream>(stream())->pixel_aspect_ratio(),
+                                     std::static_pointer_cast<VideoStream>(stream())->interlacing(),
+                                     divider));
+  view->set_timestamp(ts);
+  view->set_external_data(reinterpret_cast<char*>(element->data()), divided_width, element);
+
+  return view;
+}
+
 int FFmpegDecoderInstance::GetFrame(AVPacket *pkt, AVFrame *frame)
 {
   bool eof = false;
@@ -935,6 +1205,45 @@ void FFmpegDecoderInstance::SetWorking(bool working)
   is_working_ = working;
 }
 
+void FFmpegDecoderInstance::RebalanceThreads()
+{
+  int thread_count = FFmpegDecodeBudget::GetRebalancedThreadCount(this);
+  if (!thread_count) {
+    return;
+  }
+
+  const AVCodec* codec = codec_ctx_->codec;
+
+  AVCodecContext* new_ctx = avcodec_alloc_context3(codec);
+  if (!new_ctx) {
+    return;
+  }
+
+  new_ctx->thread_count = thread_count;
+  new_ctx->thread_type = thread_allocation_.thread_type;
+
+  // avcodec_open2() consumes the options it uses, so give it a copy to keep ours intact
+  AVDictionary* open_opts = nullptr;
+  av_dict_copy(&open_opts, opts_, 0);
+
+  bool opened = (avcodec_parameters_to_context(new_ctx, avstream_->codecpar) >= 0
+                 && avcodec_open2(new_ctx, codec, &open_opts) >= 0);
+
+  av_dict_free(&open_opts);
+
+  if (!opened) {
+    // Keep using the existing context, we'll try again on the next seek
+    avcodec_free_context(&new_ctx);
+    return;
+  }
+
+  avcodec_free_context(&codec_ctx_);
+  codec_ctx_ = new_ctx;
+
+  thread_allocation_.thread_count = thread_count;
+  FFmpegDecodeBudget::UpdateThreads(this, thread_count);
+}
+
 void FFmpegDecoderInstance::Seek(int64_t timestamp)
 {
   avcodec_flush_buffers(codec_ctx_);
@@ -1028,6 +1337,8 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
   if (!CacheCouldContainTime(target_ts)) {
     ClearFrameCache();
 
+    RebalanceThreads();
+
     Seek(seek_ts);
     if (seek_ts == 0) {
       cache_at_zero_ = true;
@@ -1050,8 +1361,15 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
   while (true) {
 
     // Pull from the decoder
+    QElapsedTimer decode_timer;
+    decode_timer.start();
+
     ret = GetFrame(pkt, working_frame.frame());
 
+    if (ret >= 0) {
+      FFmpegDecodeBudget::ReportFrameDecoded(this, statistics_name_, decode_timer.nsecsElapsed(), cached_frames_.size());
+    }
+
     // Handle any errors that aren't EOF (EOF is handled later on)
     if (ret < 0 && ret != AVERROR_EOF) {
       cache_lock_.unlock();
@@ -1131,13 +1449,24 @@ FFmpegFramePool::ElementPtr FFmpegDecoderInstance::RetrieveFrame(const int64_t&
                              VideoParams::GetScaledDimension(working_frame.frame()->height, divider),
                              1);
 
-        sws_scale(scale_ctx_,
-                  working_frame.frame()->data,
-                  working_frame.frame()->linesize,
-                  0,
-                  working_frame.frame()->height,
-                  scale_data,
-                  scale_linesize);
+        if (divider == 1) {
+          // No scaling necessary, a straight copy is much faster than going through swscale
+          av_image_copy(scale_data,
+                        scale_linesize,
+                        const_cast<const uint8_t**>(working_frame.frame()->data),
+                        working_frame.frame()->linesize,
+                        static_cast<AVPixelFormat>(working_frame.frame()->format),
+                        working_frame.frame()->width,
+                        working_frame.frame()->height);
+        } else {
+          sws_scale(scale_ctx_,
+                    working_frame.frame()->data,
+                    working_frame.frame()->linesize,
+                    0,
+                    working_frame.frame()->height,
+                    scale_data,
+                    scale_linesize);
+        }
       }
 
       // Set timestamp so this frame can be identified later
@@ -1183,6 +1512,8 @@ void FFmpegDecoder::ClearResources()
 {
   FreeScaler();
 
+  FreeAudioDecoder();
+
   open_ = false;
 }
 
@@ -1193,32 +1524,52 @@ void FFmpegDecoder::InitScaler(int divider)
   int scaled_width = VideoParams::GetScaledDimension(vs->width(), divider);
   int scaled_height = VideoParams::GetScaledDimension(vs->height(), divider);
 
-  scale_ctx_ = sws_getContext(scaled_width,
-                              scaled_height,
-                              src_pix_fmt_,
-                              scaled_width,
-                              scaled_height,
-                              ideal_pix_fmt_,
-                              SWS_FAST_BILINEAR,
-                              nullptr,
-                              nullptr,
-                              nullptr);
+  const AVPixFmtDescriptor* src_desc = av_pix_fmt_desc_get(src_pix_fmt_);
 
-  if (scale_ctx_) {
-    scale_divider_ = divider;
-  } else {
-    scale_divider_ = 0;
+  // Determine how many bands to split the conversion into
+  int slice_count = 1;
+
+  if (!(src_desc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL))) {
+    slice_count = qBound(1, scaled_height / kMinimumScaleSliceHeight, QThread::idealThreadCount());
   }
+
+  // Bands must start on a row that exists in every plane, so align them to the chroma subsampling
+  int row_alignment = 1 << src_desc->log2_chroma_h;
+  int slice_height = qCeil(static_cast<double>(scaled_height) / static_cast<double>(slice_count * row_alignment)) * row_alignment;
+
+  for (int y=0; y<scaled_height; y+=slice_height) {
+    int this_slice_height = qMin(slice_height, scaled_height - y);
+
+    SwsContext* ctx = sws_getContext(scaled_width,
+                                     this_slice_height,
+                                     src_pix_fmt_,
+                                     scaled_width,
+                                     this_slice_height,
+                                     ideal_pix_fmt_,
+                                     SWS_FAST_BILINEAR,
+                                     nullptr,
+                                     nullptr,
+                                     nullptr);
+
+    if (!ctx) {
+      FreeScaler();
+      return;
+    }
+
+    scale_slices_.append({ctx, y, this_slice_height});
+  }
+
+  scale_divider_ = divider;
 }
 
 void FFmpegDecoder::FreeScaler()
 {
-  if (scale_ctx_) {
-    sws_freeContext(scale_ctx_);
-    scale_ctx_ = nullptr;
-
-    scale_divider_ = 0;
+  foreach (const ScaleSlice& slice, scale_slices_) {
+    sws_freeContext(slice.context);
   }
+  scale_slices_.clear();
+
+  scale_divider_ = 0;
 }
 
 void FFmpegDecoderInstance::InitScaler(int divider)
@@ -1380,7 +1731,9 @@ FFmpegDecoderInstance::FFmpegDecoderInstance(const char *filename, int stream_in
   is_working_(false),
   cache_at_zero_(false),
   cache_at_eof_(false),
-  clear_timer_(nullptr)
+  clear_timer_(nullptr),
+  thread_allocation_({0, 0}),
+  statistics_name_(QStringLiteral("%1:%2").arg(QString::fromUtf8(filename), QString::number(stream_index)))
 {
   // Open file in a format context
   int error_code = avformat_open_input(&fmt_ctx_, filename, nullptr, nullptr);
@@ -1433,16 +1786,20 @@ FFmpegDecoderInstance::FFmpegDecoderInstance(const char *filename, int stream_in
     return;
   }
 
-  // Set multithreading setting
-  error_code = av_dict_set(&opts_, "threads", "auto", 0);
-
-  // Handle failure to set multithreaded decoding
-  if (error_code < 0) {
-    qCritical() << "Failed to set codec options, performance may suffer";
+  // Set multithreading setting from the global budget rather than "auto" so several instances
+  // don't each try to claim every core
+  thread_allocation_ = FFmpegDecodeBudget::AcquireThreads(this, codec);
+  codec_ctx_->thread_count = thread_allocation_.thread_count;
+  if (thread_allocation_.thread_type) {
+    codec_ctx_->thread_type = thread_allocation_.thread_type;
   }
 
-  // Open codec
-  error_code = avcodec_open2(codec_ctx_, codec, &opts_);
+  // Open codec, with a copy of the options since they're needed again if the codec is reopened with
+  // a different thread count (see RebalanceThreads())
+  AVDictionary* open_opts = nullptr;
+  av_dict_copy(&open_opts, opts_, 0);
+  error_code = avcodec_open2(codec_ctx_, codec, &open_opts);
+  av_dict_free(&open_opts);
   if (error_code < 0) {
     char buf[50];
     av_strerror(error_code, buf, 50);
@@ -1506,6 +1863,9 @@ void FFmpegDecoderInstance::ClearResources()
     fmt_ctx_ = nullptr;
   }
 
+  FFmpegDecodeBudget::ReleaseThreads(this);
+  FFmpegDecodeBudget::RemoveInstance(this);
+
   FreeScaler();
 }
 
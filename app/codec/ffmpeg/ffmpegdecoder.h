@@ -36,6 +36,7 @@ extern "C" {
 #include "avframeptr.h"
 #include "codec/decoder.h"
 #include "codec/waveoutput.h"
+#include "ffmpegdecodebudget.h"
 #include "ffmpegframepool.h"
 #include "project/item/footage/videostream.h"
 
@@ -95,10 +96,18 @@ public:
   bool IsWorking();
   void SetWorking(bool working);
 
+  void Seek(int64_t timestamp);
+
 private:
   void ClearResources();
 
-  void Seek(int64_t timestamp);
+  /**
+   * @brief Reopen the codec if the decode budget's share for this instance has changed
+   *
+   * The thread count is fixed once the codec has been opened, so this must only be called when
+   * the decoder state can be discarded anyway (i.e. right before a seek).
+   */
+  void RebalanceThreads();
 
   void InitScaler(int divider);
   void FreeScaler();
@@ -127,6 +136,10 @@ private:
   bool cache_at_eof_;
 
   QTimer* clear_timer_;
+
+  FFmpegDecodeBudget::ThreadAllocation thread_allocation_;
+  QString statistics_name_;
+
   static const int kMaxFrameLife;
 
 private slots:
@@ -205,10 +218,45 @@ private:
 
   static bool StreamUsesMultipleInstances(StreamPtr stream);
 
+  /**
+   * @brief Decode and resample a range of audio straight from the file
+   *
+   * Used while the stream hasn't been conformed yet so playback can start immediately. Requests
+   * that continue on from the end of the previous one (i.e. during playback) carry on decoding
+   * without seeking.
+   */
+  SampleBufferPtr DecodeAudioRange(const rational& timecode, const rational& length, const AudioParams& params);
+
+  bool SeekAudio(qint64 sample, const AudioParams& params);
+
+  void FreeAudioDecoder();
+
   FramePtr BuffersToNativeFrame(int divider, int width, int height, const rational &ts, uint8_t **input_data, int* input_linesize);
 
-  SwsContext* scale_ctx_;
+  /**
+   * @brief Wraps a pooled frame as a Frame without copying it
+   *
+   * Only possible if the pooled frame is already in a native pixel format with a linesize that
+   * can be uploaded as-is, returns nullptr otherwise.
+   */
+  FramePtr PoolElementToNativeFrame(FFmpegFramePool::ElementPtr element, int divider, int width, int height, const rational &ts);
+
+  /**
+   * @brief A horizontal band of the frame converted by its own scaling context
+   *
+   * libswscale contexts can't be used from multiple threads at once, so to convert a frame in
+   * parallel we split it into bands that each have their own context.
+   */
+  struct ScaleSlice {
+    SwsContext* context;
+    int y;
+    int height;
+  };
+
+  QVector<ScaleSlice> scale_slices_;
   int scale_divider_;
+
+  static const int kMinimumScaleSliceHeight;
   AVPixelFormat src_pix_fmt_;
   AVPixelFormat ideal_pix_fmt_;
   PixelFormat::Format native_pix_fmt_;
@@ -218,6 +266,18 @@ private:
     int handles = 0;
   };
 
+  FFmpegDecoderInstance* audio_instance_;
+  SwrContext* audio_resampler_;
+  AudioParams audio_resampler_params_;
+
+  // Output sample index of the first sample in audio_carry_ (or of the next sample that will be
+  // decoded if the carry is empty), -1 if unknown until the next frame is decoded
+  qint64 audio_position_;
+
+  // Samples decoded past the end of the last request
+  SampleBufferPtr audio_carry_;
+  int audio_carry_offset_;
+
   static QHash< Stream*, QList<FFmpegDecoderInstance*> > instance_map_;
   static QHash< FFmpegFramePoolKey, FFmpegFramePoolValue > frame_pool_map_;
   static QMutex instance_map_lock_;
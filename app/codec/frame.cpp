@@ -20,6 +20,7 @@
 
 #include "frame.h"
 
+#include <cstring>
 #include <QDebug>
 #include <QtGlobal>
 #include <QtMath>
@@ -27,6 +28,8 @@
 OLIVE_NAMESPACE_ENTER
 
 Frame::Frame() :
+  blank_(false),
+  external_data_(nullptr),
   timestamp_(0)
 {
 }
@@ -43,10 +46,15 @@ const VideoParams &Frame::video_params() const
 
 void Frame::set_video_params(const VideoParams &params)
 {
+  // External memory dictates its own linesize, which still holds if the dimensions aren't changing
+  bool keep_linesize = is_external() && params.effective_width() == width();
+
   params_ = params;
 
-  // Align linesize to 32
-  linesize_ = qCeil(static_cast<double>(width()) / 32.0) * 32;
+  if (!keep_linesize) {
+    // Align linesize to 32
+    linesize_ = qCeil(static_cast<double>(width()) / 32.0) * 32;
+  }
 }
 
 int Frame::linesize_pixels() const
@@ -84,7 +92,7 @@ Color Frame::get_pixel(int x, int y) const
 
   int byte_offset = PixelFormat::GetBufferSize(video_params().format(), pixel_index, 1);
 
-  return Color(data_.data() + byte_offset, video_params().format());
+  return Color(const_data() + byte_offset, video_params().format());
 }
 
 bool Frame::contains_pixel(int x, int y) const
@@ -102,7 +110,7 @@ void Frame::set_pixel(int x, int y, const Color &c)
 
   int byte_offset = PixelFormat::GetBufferSize(video_params().format(), pixel_index, 1);
 
-  c.toData(data_.data() + byte_offset, video_params().format());
+  c.toData(data() + byte_offset, video_params().format());
 }
 
 const rational &Frame::timestamp() const
@@ -117,12 +125,37 @@ void Frame::set_timestamp(const rational &timestamp)
 
 char *Frame::data()
 {
-  return data_.data();
+  if (external_data_) {
+    return external_data_;
+  }
+
+  detach();
+
+  return data_ ? data_->data() : nullptr;
 }
 
 const char *Frame::const_data() const
 {
-  return data_.constData();
+  if (external_data_) {
+    return external_data_;
+  }
+
+  return data_ ? data_->data() : nullptr;
+}
+
+void Frame::set_external_data(char *data, int linesize, std::shared_ptr<void> owner)
+{
+  data_ = nullptr;
+  blank_ = false;
+
+  external_data_ = data;
+  external_owner_ = owner;
+  linesize_ = linesize;
+}
+
+bool Frame::is_external() const
+{
+  return external_data_;
 }
 
 void Frame::allocate()
@@ -133,22 +166,72 @@ void Frame::allocate()
     return;
   }
 
-  data_.resize(PixelFormat::GetBufferSize(params_.format(), linesize_, params_.height()));
+  if (external_data_) {
+    // We're allocating our own buffer now, so stop referencing the external one and restore the
+    // aligned linesize that set_video_params() calculated
+    external_data_ = nullptr;
+    external_owner_ = nullptr;
+    set_video_params(params_);
+  }
+
+  data_ = BufferPool::instance()->Get(PixelFormat::GetBufferSize(params_.format(), linesize_, params_.height()));
+  blank_ = false;
+}
+
+void Frame::allocate_blank()
+{
+  if (!params_.is_valid()) {
+    qWarning() << "Tried to allocate a frame with invalid parameters";
+    return;
+  }
+
+  if (external_data_) {
+    external_data_ = nullptr;
+    external_owner_ = nullptr;
+    set_video_params(params_);
+  }
+
+  data_ = BufferPool::instance()->GetZeroBuffer(PixelFormat::GetBufferSize(params_.format(), linesize_, params_.height()));
+  blank_ = true;
 }
 
 bool Frame::is_allocated() const
 {
-  return !data_.isEmpty();
+  return external_data_ || data_;
 }
 
 void Frame::destroy()
 {
-  data_.clear();
+  data_ = nullptr;
+  blank_ = false;
+
+  external_data_ = nullptr;
+  external_owner_ = nullptr;
 }
 
 int Frame::allocated_size() const
 {
-  return data_.size();
+  if (is_allocated()) {
+    return PixelFormat::GetBufferSize(params_.format(), linesize_, params_.height());
+  }
+
+  return 0;
+}
+
+void Frame::detach()
+{
+  if (!blank_) {
+    return;
+  }
+
+  int sz = allocated_size();
+
+  data_ = BufferPool::instance()->Get(sz);
+  blank_ = false;
+
+  if (data_) {
+    memset(data_->data(), 0, sz);
+  }
 }
 
 OLIVE_NAMESPACE_EXIT
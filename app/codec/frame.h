@@ -24,6 +24,7 @@
 #include <memory>
 #include <QVector>
 
+#include "common/bufferpool.h"
 #include "common/rational.h"
 #include "render/color.h"
 #include "render/pixelformat.h"
@@ -67,6 +68,8 @@ public:
 
   /**
    * @brief Get the data buffer of this frame
+   *
+   * If this frame is blank (see allocate_blank()), it's given a buffer of its own first.
    */
   char* data();
 
@@ -84,6 +87,30 @@ public:
    */
   void allocate();
 
+  /**
+   * @brief Point this frame at a zero-filled buffer shared with every other blank frame
+   *
+   * Cheaper than allocate() followed by clearing the buffer. The frame only gets memory of its own
+   * if data() is called on it, so blank frames that are only ever read cost nothing.
+   */
+  void allocate_blank();
+
+  /**
+   * @brief Point this frame at memory owned by something else instead of allocating its own
+   *
+   * No copy is made. `owner` is held for as long as the frame references the data so the memory
+   * stays valid (e.g. a pooled decoder frame). `linesize` is in pixels and replaces the aligned
+   * linesize set by set_video_params(), so this must be called after it.
+   *
+   * Frames created this way share their memory with the owner and must be treated as read-only.
+   */
+  void set_external_data(char* data, int linesize, std::shared_ptr<void> owner);
+
+  /**
+   * @brief Returns whether this frame references external memory (see set_external_data())
+   */
+  bool is_external() const;
+
   /**
    * @brief Return whether the frame is allocated or not
    */
@@ -102,9 +129,20 @@ public:
   int allocated_size() const;
 
 private:
+  /**
+   * @brief Give a blank frame its own copy of the data so it can be modified
+   */
+  void detach();
+
   VideoParams params_;
 
-  QByteArray data_;
+  BufferPool::BufferPtr data_;
+
+  bool blank_;
+
+  char* external_data_;
+
+  std::shared_ptr<void> external_owner_;
 
   rational timestamp_;
 
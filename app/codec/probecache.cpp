@@ -0,0 +1,184 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "probecache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include "codec/decoder.h"
+#include "common/filefunctions.h"
+#include "common/xmlutils.h"
+
+OLIVE_NAMESPACE_ENTER
+
+// Increment whenever Footage or Stream serialization changes to invalidate old entries
+const int ProbeCache::kVersion = 1;
+
+// Entries are tiny, but every file ever imported gets one so the folder would otherwise grow forever
+const int ProbeCache::kMaximumEntries = 4096;
+
+// Listing the folder isn't free, so only check its size every this many entries written
+const int ProbeCache::kPruneInterval = 64;
+
+QAtomicInt ProbeCache::put_count_ = 0;
+
+FootagePtr ProbeCache::Get(const QString &filename)
+{
+  QString entry_fn = GetEntryFilename(filename);
+
+  if (entry_fn.isEmpty()) {
+    return nullptr;
+  }
+
+  QFile entry(entry_fn);
+
+  if (!entry.open(QFile::ReadOnly)) {
+    return nullptr;
+  }
+
+  QXmlStreamReader reader(&entry);
+
+  FootagePtr footage;
+
+  while (XMLReadNextStartElement(&reader)) {
+    if (reader.name() == QStringLiteral("probe")) {
+      int version = 0;
+
+      XMLAttributeLoop((&reader), attr) {
+        if (attr.name() == QStringLiteral("version")) {
+          version = attr.value().toInt();
+        }
+      }
+
+      if (version != kVersion) {
+        break;
+      }
+
+      while (XMLReadNextStartElement(&reader)) {
+        if (reader.name() == QStringLiteral("footage")) {
+          XMLNodeData xml_node_data;
+
+          footage = std::make_shared<Footage>();
+          footage->Load(&reader, xml_node_data, nullptr);
+        } else {
+          reader.skipCurrentElement();
+        }
+      }
+    } else {
+      reader.skipCurrentElement();
+    }
+  }
+
+  if (reader.hasError()) {
+    qWarning() << "Failed to read probe cache entry for" << filename << reader.errorString();
+    return nullptr;
+  }
+
+  // Ensure the decoder this was probed with still exists
+  if (!footage || !Decoder::CreateFromID(footage->decoder())) {
+    return nullptr;
+  }
+
+  return footage;
+}
+
+void ProbeCache::Put(const QString &filename, FootagePtr footage)
+{
+  QString entry_fn = GetEntryFilename(filename);
+
+  if (entry_fn.isEmpty()) {
+    return;
+  }
+
+  QDir().mkpath(QFileInfo(entry_fn).path());
+
+  // Write atomically so a concurrent Get() never sees a partial entry
+  QSaveFile entry(entry_fn);
+
+  if (!entry.open(QFile::WriteOnly)) {
+    return;
+  }
+
+  QXmlStreamWriter writer(&entry);
+
+  writer.writeStartDocument();
+
+  writer.writeStartElement(QStringLiteral("probe"));
+  writer.writeAttribute(QStringLiteral("version"), QString::number(kVersion));
+
+    writer.writeStartElement(QStringLiteral("footage"));
+      footage->Save(&writer);
+    writer.writeEndElement(); // footage
+
+  writer.writeEndElement(); // probe
+
+  writer.writeEndDocument();
+
+  if (!entry.commit()) {
+    qWarning() << "Failed to write probe cache entry for" << filename;
+  }
+
+  if (put_count_.fetchAndAddRelaxed(1) % kPruneInterval == 0) {
+    Prune();
+  }
+}
+
+QString ProbeCache::GetCacheDirectory()
+{
+  return QDir(FileFunctions::GetConfigurationLocation()).filePath(QStringLiteral("probecache"));
+}
+
+QString ProbeCache::GetEntryFilename(const QString &filename)
+{
+  QFileInfo info(filename);
+
+  if (!info.exists()) {
+    return QString();
+  }
+
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+
+  hash.addData(info.absoluteFilePath().toUtf8());
+  hash.addData(QByteArray::number(info.size()));
+  hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+
+  return QDir(GetCacheDirectory()).filePath(QString(hash.result().toHex()));
+}
+
+void ProbeCache::Prune()
+{
+  // Oldest first
+  QFileInfoList entries = QDir(GetCacheDirectory()).entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+
+  // If several threads prune at once they may try to remove the same entries, which is harmless
+  for (int i=0; i<entries.size()-kMaximumEntries; i++) {
+    QFile::remove(entries.at(i).absoluteFilePath());
+  }
+}
+
+OLIVE_NAMESPACE_EXIT
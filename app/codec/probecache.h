@@ -0,0 +1,79 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROBECACHE_H
+#define PROBECACHE_H
+
+#include <QAtomicInt>
+#include <QString>
+
+#include "project/item/footage/footage.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Persistent cache of Decoder::ProbeMedia() results
+ *
+ * Probing is keyed by a file's absolute path, size and modification time, so a file that hasn't
+ * changed since it was last probed (e.g. re-importing a folder) is restored from disk rather than
+ * opened by every decoder again.
+ *
+ * Each entry is stored as its own small XML file, so it's safe to read and write entries from
+ * several probing threads at once. The oldest entries are removed once there are more than
+ * kMaximumEntries of them.
+ */
+class ProbeCache
+{
+public:
+  /**
+   * @brief Retrieve previously probed footage for this file
+   *
+   * @return A new Footage object, or nullptr if this file hasn't been probed (or has changed)
+   */
+  static FootagePtr Get(const QString& filename);
+
+  /**
+   * @brief Store the result of probing a file
+   */
+  static void Put(const QString& filename, FootagePtr footage);
+
+private:
+  static QString GetCacheDirectory();
+
+  static QString GetEntryFilename(const QString& filename);
+
+  /**
+   * @brief Remove the least recently written entries if there are more than kMaximumEntries
+   */
+  static void Prune();
+
+  static QAtomicInt put_count_;
+
+  static const int kVersion;
+
+  static const int kMaximumEntries;
+
+  static const int kPruneInterval;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // PROBECACHE_H
@@ -20,8 +20,14 @@
 
 #include "samplebuffer.h"
 
+#include <algorithm>
+#include <QtMath>
+
 OLIVE_NAMESPACE_ENTER
 
+const int SampleBuffer::kSincZeroCrossings = 16;
+const int SampleBuffer::kSincResolution = 512;
+
 SampleBuffer::SampleBuffer() :
   sample_count_per_channel_(0),
   data_(nullptr)
@@ -73,6 +79,42 @@ SampleBufferPtr SampleBuffer::CreateFromPackedData(const AudioParams &audio_para
   return buffer;
 }
 
+SampleBufferPtr SampleBuffer::CreateView(const AudioParams &audio_params, int samples_per_channel, const float **data, std::shared_ptr<void> owner)
+{
+  SampleBufferPtr buffer = Create();
+
+  buffer->set_audio_params(audio_params);
+  buffer->set_sample_count(samples_per_channel);
+
+  // Only the array of channel pointers belongs to the buffer, the samples belong to the owner
+  buffer->data_ = new float* [audio_params.channel_count()];
+
+  for (int i=0;i<audio_params.channel_count();i++) {
+    buffer->data_[i] = const_cast<float*>(data[i]);
+  }
+
+  buffer->view_owner_ = owner;
+
+  return buffer;
+}
+
+SampleBufferPtr SampleBuffer::CreateSilence(const AudioParams &audio_params, int samples_per_channel)
+{
+  BufferPool::BufferPtr zeroes = BufferPool::instance()->GetZeroBuffer(samples_per_channel * sizeof(float));
+
+  if (!zeroes) {
+    // Fall back to a buffer of our own
+    SampleBufferPtr buffer = CreateAllocated(audio_params, samples_per_channel);
+    buffer->fill(0.0f);
+    return buffer;
+  }
+
+  // Every channel can read from the same zeroes
+  QVector<const float*> channels(audio_params.channel_count(), reinterpret_cast<const float*>(zeroes->data()));
+
+  return CreateView(audio_params, samples_per_channel, channels.data(), zeroes);
+}
+
 const AudioParams &SampleBuffer::audio_params() const
 {
   return audio_params_;
@@ -105,6 +147,8 @@ void SampleBuffer::set_sample_count(const int &sample_count)
 
 float **SampleBuffer::data()
 {
+  detach();
+
   return data_;
 }
 
@@ -115,6 +159,8 @@ const float **SampleBuffer::const_data() const
 
 float *SampleBuffer::channel_data(int channel)
 {
+  detach();
+
   return data_[channel];
 }
 
@@ -140,12 +186,15 @@ void SampleBuffer::allocate()
     return;
   }
 
-  allocate_sample_buffer(&data_, audio_params_.channel_count(), sample_count_per_channel_);
+  allocate_sample_buffer(&data_, &buffer_, audio_params_.channel_count(), sample_count_per_channel_);
 }
 
 void SampleBuffer::destroy()
 {
-  destroy_sample_buffer(&data_, audio_params_.channel_count());
+  // For views, only the array of channel pointers is ours to free
+  destroy_sample_buffer(&data_, &buffer_);
+
+  view_owner_ = nullptr;
 }
 
 void SampleBuffer::reverse()
@@ -155,62 +204,150 @@ void SampleBuffer::reverse()
     return;
   }
 
-  int half_nb_sample = sample_count_per_channel_ / 2;
+  detach();
 
-  for (int i=0;i<half_nb_sample;i++) {
-    int opposite_ind = sample_count_per_channel_ - i - 1;
-
-    for (int j=0;j<audio_params_.channel_count();j++) {
-      std::swap(data_[j][i], data_[j][opposite_ind]);
-    }
+  // Channels are planar so each one can be reversed contiguously
+  for (int i=0;i<audio_params_.channel_count();i++) {
+    std::reverse(data_[i], data_[i] + sample_count_per_channel_);
   }
 }
 
-void SampleBuffer::speed(double speed)
+void SampleBuffer::speed(double speed, SpeedQuality quality)
 {
   if (!is_allocated()) {
     qWarning() << "Tried to speed an unallocated sample buffer";
     return;
   }
 
-  sample_count_per_channel_ = qRound(static_cast<double>(sample_count_per_channel_) / speed);
+  int input_count = sample_count_per_channel_;
+  int output_count = qMax(1, qRound(static_cast<double>(input_count) / speed));
+  int nb_channels = audio_params_.channel_count();
 
   float** input_data = data_;
   float** output_data;
+  BufferPool::BufferPtr output_buffer;
 
-  allocate_sample_buffer(&output_data, audio_params_.channel_count(), sample_count_per_channel_);
+  allocate_sample_buffer(&output_data, &output_buffer, nb_channels, output_count);
 
-  for (int i=0;i<sample_count_per_channel_;i++) {
-    int input_index = qFloor(static_cast<double>(i) * speed);
+  if (!output_data) {
+    return;
+  }
+
+  switch (quality) {
+  case kSpeedQualityNearest:
+    for (int i=0;i<output_count;i++) {
+      int input_index = qMin(qFloor(static_cast<double>(i) * speed), input_count - 1);
+
+      for (int j=0;j<nb_channels;j++) {
+        output_data[j][i] = input_data[j][input_index];
+      }
+    }
+    break;
+  case kSpeedQualityLinear:
+    for (int i=0;i<output_count;i++) {
+      double pos = static_cast<double>(i) * speed;
+      int a = qMin(qFloor(pos), input_count - 1);
+      int b = qMin(a + 1, input_count - 1);
+      float t = static_cast<float>(pos - a);
+
+      for (int j=0;j<nb_channels;j++) {
+        output_data[j][i] = input_data[j][a] + (input_data[j][b] - input_data[j][a]) * t;
+      }
+    }
+    break;
+  case kSpeedQualityHigh:
+  {
+    const QVector<float>& table = GetSincTable();
+
+    // When speeding up, stretch the kernel so it also filters out everything above the new
+    // Nyquist frequency, otherwise it would fold back down as aliasing
+    double scale = qMax(1.0, speed);
+    double cutoff = 1.0 / scale;
+    int half_width = qCeil(kSincZeroCrossings * scale);
+
+    QVector<float> weights(half_width * 2);
+
+    for (int i=0;i<output_count;i++) {
+      double center = static_cast<double>(i) * speed;
+      int base = qFloor(center);
+      double frac = center - base;
+
+      // Input samples (base - half_width, base + half_width] contribute to this output sample
+      int first = base - half_width + 1;
+
+      // Calculate weights once for all channels, normalizing them so DC passes at unity gain
+      // (which also keeps the edges of the buffer from fading out)
+      float weight_sum = 0.0f;
+      int first_valid = qMax(0, -first);
+      int last_valid = qMin(weights.size(), input_count - first);
+
+      for (int k=first_valid;k<last_valid;k++) {
+        double x = (static_cast<double>(first + k) - base - frac) * cutoff;
+        weights[k] = LookupSinc(table, qAbs(x));
+        weight_sum += weights[k];
+      }
 
-    for (int j=0;j<audio_params_.channel_count();j++) {
-      output_data[j][i] = input_data[j][input_index];
+      float normalize = qIsNull(weight_sum) ? 0.0f : 1.0f / weight_sum;
+
+      for (int j=0;j<nb_channels;j++) {
+        const float* in = input_data[j];
+        float acc = 0.0f;
+
+        for (int k=first_valid;k<last_valid;k++) {
+          acc += in[first + k] * weights.at(k);
+        }
+
+        output_data[j][i] = acc * normalize;
+      }
     }
+    break;
+  }
   }
 
-  destroy_sample_buffer(&input_data, audio_params_.channel_count());
+  destroy();
 
   data_ = output_data;
+  buffer_ = output_buffer;
+  sample_count_per_channel_ = output_count;
 }
 
 void SampleBuffer::transform_volume(float f)
 {
+  if (qFuzzyCompare(f, 1.0f)) {
+    return;
+  }
+
+  detach();
+
+  // Contiguous per-channel loops so the compiler can vectorize them
   for (int i=0;i<audio_params().channel_count();i++) {
+    float* channel = data_[i];
+
     for (int j=0;j<sample_count_per_channel_;j++) {
-      data_[i][j] *= f;
+      channel[j] *= f;
     }
   }
 }
 
 void SampleBuffer::transform_volume_for_channel(int channel, float volume)
 {
+  if (qFuzzyCompare(volume, 1.0f)) {
+    return;
+  }
+
+  detach();
+
+  float* samples = data_[channel];
+
   for (int i=0;i<sample_count_per_channel_;i++) {
-    data_[channel][i] *= volume;
+    samples[i] *= volume;
   }
 }
 
 void SampleBuffer::transform_volume_for_sample(int sample_index, float volume)
 {
+  detach();
+
   for (int i=0;i<audio_params().channel_count();i++) {
     data_[i][sample_index] *= volume;
   }
@@ -218,6 +355,8 @@ void SampleBuffer::transform_volume_for_sample(int sample_index, float volume)
 
 void SampleBuffer::transform_volume_for_sample_on_channel(int sample_index, int channel, float volume)
 {
+  detach();
+
   data_[channel][sample_index] *= volume;
 }
 
@@ -233,6 +372,8 @@ void SampleBuffer::fill(const float &f, int start_sample, int end_sample)
     return;
   }
 
+  detach();
+
   for (int i=0;i<audio_params().channel_count();i++) {
     for (int j=start_sample;j<end_sample;j++) {
       data_[i][j] = f;
@@ -247,6 +388,8 @@ void SampleBuffer::set(const float **data, int sample_offset, int sample_length)
     return;
   }
 
+  detach();
+
   for (int i=0;i<audio_params().channel_count();i++) {
     for (int j=0;j<sample_length;j++) {
       data_[i][j + sample_offset] = data[i][j];
@@ -282,27 +425,97 @@ QByteArray SampleBuffer::toPackedData() const
   return packed_data;
 }
 
-void SampleBuffer::allocate_sample_buffer(float ***data, int nb_channels, int nb_samples)
+void SampleBuffer::detach()
 {
-  Q_ASSERT(nb_samples > 0);
+  if (!view_owner_) {
+    return;
+  }
 
-  *data = new float* [nb_channels];
+  float** owned_data;
+  BufferPool::BufferPtr owned_buffer;
 
-  for (int i=0;i<nb_channels;i++) {
-    (*data)[i] = new float[nb_samples];
+  allocate_sample_buffer(&owned_data, &owned_buffer, audio_params_.channel_count(), sample_count_per_channel_);
+
+  if (!owned_data) {
+    return;
   }
+
+  for (int i=0;i<audio_params_.channel_count();i++) {
+    memcpy(owned_data[i], data_[i], sample_count_per_channel_ * sizeof(float));
+  }
+
+  destroy();
+
+  data_ = owned_data;
+  buffer_ = owned_buffer;
 }
 
-void SampleBuffer::destroy_sample_buffer(float ***data, int nb_channels)
+const QVector<float> &SampleBuffer::GetSincTable()
 {
-  if (*data) {
-    for (int i=0;i<nb_channels;i++) {
-      delete [] (*data)[i];
+  // Built once on first use, thread-safe as a function-local static
+  static const QVector<float> table = []{
+    int sz = kSincZeroCrossings * kSincResolution + 1;
+    QVector<float> t(sz);
+
+    for (int i=0;i<sz;i++) {
+      double x = static_cast<double>(i) / kSincResolution;
+      double sinc = (i == 0) ? 1.0 : qSin(M_PI * x) / (M_PI * x);
+
+      // Blackman window over the width of the kernel
+      double n = 0.5 + 0.5 * x / kSincZeroCrossings;
+      double window = 0.42 - 0.5 * qCos(2.0 * M_PI * n) + 0.08 * qCos(4.0 * M_PI * n);
+
+      t[i] = static_cast<float>(sinc * window);
     }
 
-    delete [] *data;
+    return t;
+  }();
+
+  return table;
+}
+
+float SampleBuffer::LookupSinc(const QVector<float> &table, double x)
+{
+  double pos = x * kSincResolution;
+  int index = qFloor(pos);
+
+  if (index >= table.size() - 1) {
+    return 0.0f;
+  }
+
+  float t = static_cast<float>(pos - index);
+
+  return table.at(index) + (table.at(index + 1) - table.at(index)) * t;
+}
+
+void SampleBuffer::allocate_sample_buffer(float ***data, BufferPool::BufferPtr *buffer, int nb_channels, int nb_samples)
+{
+  Q_ASSERT(nb_samples > 0);
+
+  // Pad each channel out to the pool's alignment so every channel is as aligned as the first
+  size_t channel_sz = (nb_samples * sizeof(float) + kMemoryPoolAlignment - 1) / kMemoryPoolAlignment * kMemoryPoolAlignment;
+
+  *buffer = BufferPool::instance()->Get(channel_sz * nb_channels);
+
+  if (!*buffer) {
+    qCritical() << "Failed to allocate sample buffer";
     *data = nullptr;
+    return;
+  }
+
+  *data = new float* [nb_channels];
+
+  for (int i=0;i<nb_channels;i++) {
+    (*data)[i] = reinterpret_cast<float*>((*buffer)->data() + i * channel_sz);
   }
 }
 
+void SampleBuffer::destroy_sample_buffer(float ***data, BufferPool::BufferPtr *buffer)
+{
+  delete [] *data;
+  *data = nullptr;
+
+  *buffer = nullptr;
+}
+
 OLIVE_NAMESPACE_EXIT
@@ -23,6 +23,7 @@
 
 #include <memory>
 
+#include "common/bufferpool.h"
 #include "render/audioparams.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -41,6 +42,20 @@ using SampleBufferPtr = std::shared_ptr<SampleBuffer>;
 class SampleBuffer
 {
 public:
+  /**
+   * @brief Interpolation used by speed()
+   */
+  enum SpeedQuality {
+    /// Picks the nearest input sample, fastest but aliases heavily
+    kSpeedQualityNearest,
+
+    /// Linear interpolation between the two nearest samples
+    kSpeedQualityLinear,
+
+    /// Band-limited windowed sinc interpolation, slowest but free of audible aliasing
+    kSpeedQualityHigh
+  };
+
   SampleBuffer();
 
   virtual ~SampleBuffer();
@@ -49,6 +64,23 @@ public:
   static SampleBufferPtr CreateAllocated(const AudioParams& audio_params, int samples_per_channel);
   static SampleBufferPtr CreateFromPackedData(const AudioParams& audio_params, const QByteArray& bytes);
 
+  /**
+   * @brief Create a buffer that references existing planar data rather than allocating its own
+   *
+   * `owner` is kept alive for as long as the buffer references the data. The data is treated as
+   * read-only: any function that modifies the buffer (including the non-const data accessors)
+   * will copy it into a buffer of its own first.
+   */
+  static SampleBufferPtr CreateView(const AudioParams& audio_params, int samples_per_channel,
+                                    const float** data, std::shared_ptr<void> owner);
+
+  /**
+   * @brief Create a silent buffer backed by memory shared with every other silent buffer
+   *
+   * Like CreateView(), the buffer only gets memory of its own once something modifies it.
+   */
+  static SampleBufferPtr CreateSilence(const AudioParams& audio_params, int samples_per_channel);
+
   DISABLE_COPY_MOVE(SampleBuffer)
 
   const AudioParams& audio_params() const;
@@ -65,8 +97,13 @@ public:
   void allocate();
   void destroy();
 
+  bool is_view() const
+  {
+    return static_cast<bool>(view_owner_);
+  }
+
   void reverse();
-  void speed(double speed);
+  void speed(double speed, SpeedQuality quality = kSpeedQualityHigh);
   void transform_volume(float f);
   void transform_volume_for_channel(int channel, float volume);
   void transform_volume_for_sample(int sample_index, float volume);
@@ -81,9 +118,25 @@ public:
   QByteArray toPackedData() const;
 
 private:
-  static void allocate_sample_buffer(float*** data, int nb_channels, int nb_samples);
+  /**
+   * @brief Allocate planar channels from a single pooled buffer, each channel starting on an aligned boundary
+   */
+  static void allocate_sample_buffer(float*** data, BufferPool::BufferPtr* buffer, int nb_channels, int nb_samples);
+
+  static void destroy_sample_buffer(float*** data, BufferPool::BufferPtr* buffer);
 
-  static void destroy_sample_buffer(float*** data, int nb_channels);
+  void detach();
+
+  /**
+   * @brief Windowed sinc kernel, sampled at kSincResolution points per zero crossing
+   */
+  static const QVector<float>& GetSincTable();
+
+  static float LookupSinc(const QVector<float>& table, double x);
+
+  static const int kSincZeroCrossings;
+
+  static const int kSincResolution;
 
   AudioParams audio_params_;
 
@@ -91,6 +144,10 @@ private:
 
   float** data_;
 
+  BufferPool::BufferPtr buffer_;
+
+  std::shared_ptr<void> view_owner_;
+
 };
 
 OLIVE_NAMESPACE_EXIT
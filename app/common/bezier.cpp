@@ -24,6 +24,10 @@
 
 OLIVE_NAMESPACE_ENTER
 
+const double Bezier::kCubicTolerance = 0.0001;
+const int Bezier::kCubicMaxNewtonIterations = 8;
+const int Bezier::kCubicMaxBisectIterations = 32;
+
 double Bezier::QuadraticXtoT(double x, double a, double b, double c)
 {
   return (a - b + qSqrt(a*x + c*x - 2*b*x + qPow(b, 2) - a*c))/(a - 2*b + c);
@@ -34,33 +38,84 @@ double Bezier::QuadraticTtoY(double a, double b, double c, double t)
   return qPow(1.0 - t, 2)*a + 2*(1.0 - t)*t*b + qPow(t, 2)*c;
 }
 
-double Bezier::CubicXtoT(double x_target, double a, double b, double c, double d)
+double Bezier::CubicXtoT(double x_target, double a, double b, double c, double d, double guess)
 {
-  double tolerance = 0.0001;
+  // Values outside the curve's range will never converge, so clamp them to the extremes
+  if (x_target <= a) {
+    return 0.0;
+  } else if (x_target >= d) {
+    return 1.0;
+  }
+
+  double t;
+
+  if (guess >= 0.0 && guess <= 1.0) {
+    t = guess;
+  } else {
+    // Linear estimate, exact if the control points are evenly spaced
+    t = (x_target - a) / (d - a);
+  }
+
+  // Newton-Raphson usually converges in a handful of iterations
+  for (int i=0; i<kCubicMaxNewtonIterations; i++) {
+    double x = CubicTtoY(a, b, c, d, t) - x_target;
+
+    if (qAbs(x) <= kCubicTolerance) {
+      return t;
+    }
+
+    double slope = CubicTtoYDerivative(a, b, c, d, t);
+
+    if (qAbs(slope) < 1e-6) {
+      // Flat tangent, Newton would overshoot so let bisection handle it
+      break;
+    }
+
+    t -= x / slope;
 
+    if (t < 0.0 || t > 1.0) {
+      // Diverged out of range, fall back to bisection
+      break;
+    }
+  }
+
+  // Fall back to bisection, which is guaranteed to converge since X is monotonic on a valid curve
   double lower = 0.0;
   double upper = 1.0;
 
-  double percent = 0.5;
-  double x = CubicTtoY(a, b, c, d, percent);
+  t = 0.5;
+
+  for (int i=0; i<kCubicMaxBisectIterations; i++) {
+    double x = CubicTtoY(a, b, c, d, t);
+
+    if (qAbs(x_target - x) <= kCubicTolerance) {
+      break;
+    }
 
-  while (qAbs(x_target - x) > tolerance) {
     if (x_target > x) {
-      lower = percent;
+      lower = t;
     } else {
-      upper = percent;
+      upper = t;
     }
 
-    percent = (upper + lower) / 2.0;
-    x = CubicTtoY(a, b, c, d, percent);
+    t = (upper + lower) / 2.0;
   }
 
-  return percent;
+  return t;
 }
 
 double Bezier::CubicTtoY(double a, double b, double c, double d, double t)
 {
-  return qPow(1.0 - t, 3)*a + 3*qPow(1.0 - t, 2)*t*b + 3*(1.0 - t)*qPow(t, 2)*c + qPow(t, 3)*d;
+  double inv_t = 1.0 - t;
+
+  return inv_t*inv_t*inv_t*a + 3*inv_t*inv_t*t*b + 3*inv_t*t*t*c + t*t*t*d;
+}
+
+double Bezier::CubicTtoYDerivative(double a, double b, double c, double d, double t)
+{
+  double inv_t = 1.0 - t;
+
+  return 3*inv_t*inv_t*(b - a) + 6*inv_t*t*(c - b) + 3*t*t*(d - c);
 }
 
 OLIVE_NAMESPACE_EXIT
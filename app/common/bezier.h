@@ -32,9 +32,32 @@ public:
 
   static double QuadraticTtoY(double a, double b, double c, double t);
 
-  static double CubicXtoT(double x_target, double a, double b, double c, double d);
+  /**
+   * @brief Find the T at which a cubic bezier reaches x_target
+   *
+   * Uses Newton-Raphson iteration from a linear first guess, falling back to bisection if Newton
+   * fails to converge. Both stages are bounded so this always returns in constant time.
+   *
+   * If `guess` is between 0.0 and 1.0, it's used as the starting point instead of the linear
+   * estimate. This is useful when solving for many nearby values in order (e.g. dense sampling),
+   * since the previous result is usually only a step or two away from the next one.
+   */
+  static double CubicXtoT(double x_target, double a, double b, double c, double d, double guess = -1.0);
 
   static double CubicTtoY(double a, double b, double c, double d, double t);
+
+  /**
+   * @brief Derivative of CubicTtoY() with respect to T
+   */
+  static double CubicTtoYDerivative(double a, double b, double c, double d, double t);
+
+private:
+  static const double kCubicTolerance;
+
+  static const int kCubicMaxNewtonIterations;
+
+  static const int kCubicMaxBisectIterations;
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,184 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+
+#include "bufferpool.h"
+
+#include <cstring>
+
+OLIVE_NAMESPACE_ENTER
+
+// Anything smaller than this isn't worth splitting into its own size class
+const size_t BufferPool::kMinimumSizeClass = 4096;
+
+// Roughly how much memory each arena covers, large size classes get fewer buffers per arena
+const size_t BufferPool::kArenaTargetSize = 64 * 1024 * 1024;
+
+const int BufferPool::kMaximumBuffersPerArena = 64;
+
+// Spare arenas across all size classes are limited to this, so each resolution and format that
+// was ever rendered doesn't leave a full arena behind forever
+const size_t BufferPool::kMaximumSpareSize = 256 * 1024 * 1024;
+
+BufferPool::BufferPool() :
+  zero_buffer_size_(0),
+  spare_size_(0)
+{
+}
+
+BufferPool::~BufferPool()
+{
+  zero_buffer_ = nullptr;
+
+  qDeleteAll(pools_);
+}
+
+BufferPool *BufferPool::instance()
+{
+  // Constructed on first use and destroyed at exit, after anything that might still be holding a buffer
+  static BufferPool pool;
+  return &pool;
+}
+
+BufferPool::BufferPtr BufferPool::Get(size_t size)
+{
+  size_t size_class = GetSizeClass(size);
+
+  SizeClassPool* pool;
+
+  {
+    QMutexLocker locker(&lock_);
+
+    pool = pools_.value(size_class);
+
+    if (!pool) {
+      int buffers_per_arena = qBound(1,
+                                     static_cast<int>(kArenaTargetSize / size_class),
+                                     kMaximumBuffersPerArena);
+
+      pool = new SizeClassPool(this, size_class, buffers_per_arena);
+
+      // Keep one empty arena around so a buffer that's freed and immediately requested again
+      // doesn't cause an arena to be freed and reallocated (subject to kMaximumSpareSize)
+      pool->SetSpareArenaLimit(1);
+
+      // Large size classes only fit one buffer per arena, so arenas are created and freed with
+      // every frame and logging it would flood the output
+      pool->SetLoggingEnabled(false);
+
+      pools_.insert(size_class, pool);
+    }
+  }
+
+  return pool->Get();
+}
+
+BufferPool::BufferPtr BufferPool::GetZeroBuffer(size_t size)
+{
+  QMutexLocker locker(&zero_buffer_lock_);
+
+  if (!zero_buffer_ || zero_buffer_size_ < size) {
+    // Anyone still using the old buffer keeps it alive through their own reference
+    size_t size_class = GetSizeClass(size);
+
+    zero_buffer_ = Get(size_class);
+
+    if (!zero_buffer_) {
+      zero_buffer_size_ = 0;
+      return nullptr;
+    }
+
+    memset(zero_buffer_->data(), 0, size_class);
+    zero_buffer_size_ = size_class;
+  }
+
+  return zero_buffer_;
+}
+
+QVector<BufferPool::Statistics> BufferPool::GetStatistics()
+{
+  QMutexLocker locker(&lock_);
+
+  QVector<Statistics> stats;
+  stats.reserve(pools_.size());
+
+  for (QMap<size_t, SizeClassPool*>::const_iterator i=pools_.constBegin(); i!=pools_.constEnd(); i++) {
+    Statistics s;
+
+    s.buffer_size = i.key();
+    s.used = i.value()->GetUsageCount();
+    s.capacity = i.value()->GetCapacity();
+    s.allocated_size = i.value()->GetAllocatedSize();
+
+    stats.append(s);
+  }
+
+  return stats;
+}
+
+size_t BufferPool::GetSizeClass(size_t size)
+{
+  if (size <= kMinimumSizeClass) {
+    return kMinimumSizeClass;
+  }
+
+  // Size classes are spaced a quarter of a power of two apart, so no more than 25% of a buffer
+  // is ever wasted by rounding up
+  size_t power = kMinimumSizeClass;
+  while (power * 2 <= size) {
+    power *= 2;
+  }
+
+  size_t step = power / 4;
+
+  return (size + step - 1) / step * step;
+}
+
+BufferPool::SizeClassPool::SizeClassPool(BufferPool *parent, size_t element_size, int element_count) :
+  MemoryPool(element_count),
+  parent_(parent),
+  element_size_(element_size)
+{
+}
+
+size_t BufferPool::SizeClassPool::GetElementSize()
+{
+  return element_size_;
+}
+
+bool BufferPool::SizeClassPool::CanKeepSpareArena(size_t size)
+{
+  size_t current = parent_->spare_size_.load();
+
+  do {
+    if (current + size > kMaximumSpareSize) {
+      return false;
+    }
+  } while (!parent_->spare_size_.compare_exchange_weak(current, current + size));
+
+  return true;
+}
+
+void BufferPool::SizeClassPool::SpareArenaReleased(size_t size)
+{
+  parent_->spare_size_ -= size;
+}
+
+OLIVE_NAMESPACE_EXIT
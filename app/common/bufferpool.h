@@ -0,0 +1,139 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <atomic>
+#include <QMap>
+
+#include "common/memorypool.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Application-wide pool of aligned buffers for frame and sample data
+ *
+ * Rendering allocates and frees multi-megabyte buffers constantly, and most of them are one of a handful of sizes
+ * (the sequence's frame size in each pixel format, one chunk of audio, etc.) Requests are rounded up to a size class
+ * and served from a MemoryPool for that class, so a freed frame buffer is simply handed to the next frame of the same
+ * size instead of going back through the general allocator.
+ *
+ * All buffers are aligned to kMemoryPoolAlignment. Thread-safe.
+ */
+class BufferPool
+{
+public:
+  using BufferPtr = MemoryPool<char>::ElementPtr;
+
+  struct Statistics {
+    /// Size of each buffer in this size class
+    size_t buffer_size;
+
+    /// Number of buffers currently in use
+    int used;
+
+    /// Number of buffers that can be handed out before another arena is needed
+    int capacity;
+
+    /// Total bytes allocated for this size class
+    size_t allocated_size;
+  };
+
+  static BufferPool* instance();
+
+  DISABLE_COPY_MOVE(BufferPool)
+
+  /**
+   * @brief Retrieve a buffer of at least `size` bytes
+   *
+   * Contents are uninitialized. Returns nullptr if the allocation fails.
+   */
+  BufferPtr Get(size_t size);
+
+  /**
+   * @brief Retrieve a zero-filled buffer of at least `size` bytes that is shared by all callers
+   *
+   * The buffer must never be written to. Used for blank frames and silence, which can then be passed around without
+   * each one allocating and clearing its own memory.
+   */
+  BufferPtr GetZeroBuffer(size_t size);
+
+  /**
+   * @brief Returns statistics for each size class, ordered by buffer size
+   */
+  QVector<Statistics> GetStatistics();
+
+  /**
+   * @brief Returns the size class that a request for `size` bytes will be rounded up to
+   */
+  static size_t GetSizeClass(size_t size);
+
+private:
+  BufferPool();
+
+  ~BufferPool();
+
+  class SizeClassPool : public MemoryPool<char>
+  {
+  public:
+    SizeClassPool(BufferPool* parent, size_t element_size, int element_count);
+
+  protected:
+    virtual size_t GetElementSize() override;
+
+    virtual bool CanKeepSpareArena(size_t size) override;
+
+    virtual void SpareArenaReleased(size_t size) override;
+
+  private:
+    BufferPool* parent_;
+
+    size_t element_size_;
+
+  };
+
+  QMap<size_t, SizeClassPool*> pools_;
+
+  QMutex lock_;
+
+  BufferPtr zero_buffer_;
+
+  size_t zero_buffer_size_;
+
+  QMutex zero_buffer_lock_;
+
+  /// Total size of the empty arenas kept as spares across every size class
+  std::atomic<size_t> spare_size_;
+
+  static const size_t kMinimumSizeClass;
+
+  static const size_t kArenaTargetSize;
+
+  static const int kMaximumBuffersPerArena;
+
+  static const size_t kMaximumSpareSize;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // BUFFERPOOL_H
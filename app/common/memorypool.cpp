@@ -5,6 +5,8 @@ OLIVE_NAMESPACE_ENTER
 size_t memory_pool_consumption = 0;
 QMutex memory_pool_consumption_lock;
 
+const size_t kMemoryPoolAlignment = 64;
+
 bool MemoryPoolLimitReached()
 {
   QMutexLocker locker(&memory_pool_consumption_lock);
@@ -21,12 +21,16 @@
 #ifndef MEMORYPOOL_H
 #define MEMORYPOOL_H
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <QDateTime>
 #include <QDebug>
-#include <QLinkedList>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QVector>
 #include <stdint.h>
+#include <vector>
 
 #include "common/define.h"
 
@@ -36,6 +40,11 @@ extern size_t memory_pool_consumption;
 extern QMutex memory_pool_consumption_lock;
 bool MemoryPoolLimitReached();
 
+/**
+ * @brief Alignment of every arena and element in bytes, enough for a cache line or an AVX-512 load
+ */
+extern const size_t kMemoryPoolAlignment;
+
 template <typename T>
 /**
  * @brief MemoryPool base class
@@ -49,6 +58,8 @@ template <typename T>
  *
  * `Get()` will return an ElementPtr. The original desired data can be accessed through ElementPtr::data(). This data
  * will belong to the caller until ElementPtr goes out of scope and the memory is freed back into the pool.
+ *
+ * Every element starts on a kMemoryPoolAlignment boundary.
  */
 class MemoryPool
 {
@@ -61,6 +72,9 @@ public:
    */
   MemoryPool(int element_count) {
     element_count_ = element_count;
+    spare_arena_limit_ = 0;
+    logging_enabled_ = true;
+    arena_hint_ = 0;
     ignore_arena_empty_signal_ = false;
   }
 
@@ -71,22 +85,38 @@ public:
    */
   virtual ~MemoryPool() {
     Clear();
+
+    ignore_arena_empty_signal_ = true;
+    qDeleteAll(retired_arenas_);
   }
 
   DISABLE_COPY_MOVE(MemoryPool)
 
   /**
-   * @brief Clears all arenas, freeing all of their memory
+   * @brief Clears all arenas so that new elements are allocated from fresh ones
    *
-   * Note that this function is not safe, any elements that are still out there will be invalid
-   * and accessing them will cause a crash. You'll need to make sure all elements are already
-   * relinquished before then.
+   * Arenas with no elements in use are freed immediately. Arenas that still have elements out
+   * there are retired instead: they won't lend any more elements, but their memory stays valid
+   * until the last element is released, at which point they're freed.
    */
   void Clear()
   {
-    ignore_arena_empty_signal_ = true;
-    qDeleteAll(arenas_);
-    ignore_arena_empty_signal_ = false;
+    QWriteLocker locker(&lock_);
+
+    foreach (Arena* a, arenas_) {
+      if (a->GetUsageCount()) {
+        retired_arenas_.push_back(a);
+      } else {
+        if (a->IsSpare()) {
+          SpareArenaReleased(a->GetAllocatedSize());
+        }
+
+        delete a;
+      }
+    }
+
+    arenas_.clear();
+    arena_hint_ = 0;
   }
 
   /**
@@ -103,6 +133,80 @@ public:
     return arenas_.size();
   }
 
+  /**
+   * @brief Set how many arenas with no elements in use are kept around rather than freed
+   *
+   * Defaults to 0, freeing arenas as soon as they're empty. Pools that lend and release large elements in quick
+   * succession can keep one spare so they aren't constantly allocating and freeing the same memory.
+   */
+  void SetSpareArenaLimit(int limit) {
+    QWriteLocker locker(&lock_);
+    spare_arena_limit_ = limit;
+  }
+
+  /**
+   * @brief Set whether arenas being created and freed are logged
+   *
+   * Defaults to true. Pools whose arenas only hold a handful of large elements create and free
+   * arenas routinely, so logging it would just be noise.
+   */
+  void SetLoggingEnabled(bool e) {
+    logging_enabled_ = e;
+  }
+
+  /**
+   * @brief Returns the total size in bytes of all arenas in use by this pool
+   */
+  size_t GetAllocatedSize() {
+    QReadLocker locker(&lock_);
+
+    size_t sz = 0;
+
+    foreach (Arena* a, arenas_) {
+      sz += a->GetAllocatedSize();
+    }
+
+    foreach (Arena* a, retired_arenas_) {
+      sz += a->GetAllocatedSize();
+    }
+
+    return sz;
+  }
+
+  /**
+   * @brief Returns the number of elements that are currently lent out
+   */
+  int GetUsageCount() {
+    QReadLocker locker(&lock_);
+
+    int count = 0;
+
+    foreach (Arena* a, arenas_) {
+      count += a->GetUsageCount();
+    }
+
+    foreach (Arena* a, retired_arenas_) {
+      count += a->GetUsageCount();
+    }
+
+    return count;
+  }
+
+  /**
+   * @brief Returns the number of elements that could be lent out without allocating another arena
+   */
+  int GetCapacity() {
+    QReadLocker locker(&lock_);
+
+    int count = 0;
+
+    foreach (Arena* a, arenas_) {
+      count += a->GetElementCount();
+    }
+
+    return count;
+  }
+
   class Arena;
 
   /**
@@ -203,15 +307,20 @@ public:
       parent_ = parent;
       data_ = nullptr;
       allocated_sz_ = 0;
+      element_count_ = 0;
+      free_head_ = kEmptyIndex;
+      usage_count_ = 0;
+      spare_ = false;
     }
 
     ~Arena() {
-      std::list<Element*> copy = lent_elements_;
-      foreach (Element* e, copy) {
-        e->release();
+      for (int i=0;i<element_count_;i++) {
+        if (lent_elements_[i]) {
+          lent_elements_[i]->release();
+        }
       }
 
-      delete [] data_;
+      qFreeAligned(data_);
 
       memory_pool_consumption_lock.lock();
       memory_pool_consumption -= allocated_sz_;
@@ -222,48 +331,79 @@ public:
 
     /**
      * @brief Returns an element if there is free memory to do so
+     *
+     * Lock-free, pops the next free index off the arena's free list.
      */
     ElementPtr Get() {
-      QMutexLocker locker(&lock_);
+      uint64_t head = free_head_.load(std::memory_order_acquire);
+      uint32_t index;
 
-      for (int i=0;i<available_.size();i++) {
-        if (available_.at(i)) {
-          // This buffer is available
-          available_.replace(i, false);
+      do {
+        index = static_cast<uint32_t>(head);
 
-          ElementPtr e = std::make_shared<Element>(this,
-                                                   reinterpret_cast<T*>(data_ + i * element_sz_));
-          lent_elements_.push_back(e.get());
-
-          return e;
+        if (index == kEmptyIndex) {
+          return nullptr;
         }
+
+        // If another thread pops this index first, the tag in the head will have changed and the
+        // exchange will fail, so reading a stale next index here is harmless
+      } while (!free_head_.compare_exchange_weak(head,
+                                                 MakeHead(head, next_free_[index].load(std::memory_order_relaxed)),
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_acquire));
+
+      // Spares are only marked while the pool is write locked, and we're only here with at least
+      // a read lock, so nothing else can be changing this
+      if (usage_count_++ == 0 && spare_.exchange(false)) {
+        parent_->SpareArenaReleased(allocated_sz_);
       }
 
-      return nullptr;
+      ElementPtr e = std::make_shared<Element>(this,
+                                               reinterpret_cast<T*>(data_ + index * element_sz_));
+
+      // Only the thread that popped this index touches this slot until it's released
+      lent_elements_[index] = e.get();
+
+      return e;
     }
 
     /**
      * @brief Releases an element back into the pool for use elsewhere
      */
     void Release(Element* e) {
-      QMutexLocker locker(&lock_);
       quintptr diff = reinterpret_cast<quintptr>(e->data()) - reinterpret_cast<quintptr>(data_);
 
-      int index = diff / element_sz_;
+      uint32_t index = diff / element_sz_;
+
+      lent_elements_[index] = nullptr;
 
-      available_.replace(index, true);
+      uint64_t head = free_head_.load(std::memory_order_relaxed);
 
-      lent_elements_.remove(e);
+      do {
+        next_free_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+      } while (!free_head_.compare_exchange_weak(head,
+                                                 MakeHead(head, index),
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed));
 
-      if (lent_elements_.empty()) {
-        locker.unlock();
-        parent_->ArenaIsEmpty(this);
+      // Once the count hits zero, another thread may delete this arena at any moment
+      MemoryPool* parent = parent_;
+
+      if (--usage_count_ == 0) {
+        parent->ArenaIsEmpty(this);
       }
     }
 
     int GetUsageCount() {
-      QMutexLocker locker(&lock_);
-      return lent_elements_.size();
+      return usage_count_;
+    }
+
+    inline bool IsSpare() const {
+      return spare_;
+    }
+
+    inline void SetSpare(bool e) {
+      spare_ = e;
     }
 
     bool Allocate(size_t ele_sz, size_t nb_elements) {
@@ -271,13 +411,23 @@ public:
         return true;
       }
 
-      element_sz_ = ele_sz;
+      // Round the element size up so that every element, not just the first, is aligned
+      element_sz_ = (ele_sz + kMemoryPoolAlignment - 1) / kMemoryPoolAlignment * kMemoryPoolAlignment;
 
       allocated_sz_ = element_sz_ * nb_elements;
 
-      if ((data_ = new char[allocated_sz_])) {
-        available_.resize(nb_elements);
-        available_.fill(true);
+      if ((data_ = static_cast<char*>(qMallocAligned(allocated_sz_, kMemoryPoolAlignment)))) {
+        element_count_ = nb_elements;
+
+        // Chain every index into the free list in order
+        next_free_.reset(new std::atomic<uint32_t>[nb_elements]);
+        for (size_t i=0;i<nb_elements;i++) {
+          next_free_[i] = (i + 1 < nb_elements) ? static_cast<uint32_t>(i + 1) : kEmptyIndex;
+        }
+        free_head_ = 0;
+
+        lent_elements_.resize(nb_elements);
+        std::fill(lent_elements_.begin(), lent_elements_.end(), nullptr);
 
         memory_pool_consumption_lock.lock();
         memory_pool_consumption += allocated_sz_;
@@ -285,14 +435,18 @@ public:
 
         return true;
       } else {
-        available_.clear();
+        allocated_sz_ = 0;
 
         return false;
       }
     }
 
+    inline size_t GetAllocatedSize() const {
+      return allocated_sz_;
+    }
+
     inline int GetElementCount() const {
-      return available_.size();
+      return element_count_;
     }
 
     inline bool IsAllocated() const {
@@ -300,42 +454,74 @@ public:
     }
 
   private:
+    /**
+     * @brief Build a free list head from an index, bumping the tag of the previous head
+     *
+     * The low 32 bits hold the index of the first free element and the high 32 bits hold a tag
+     * that changes on every push and pop, so a head that was popped and pushed back between a
+     * thread's load and its compare-exchange (the ABA problem) doesn't compare equal.
+     */
+    static inline uint64_t MakeHead(uint64_t previous, uint32_t index) {
+      return (((previous >> 32) + 1) << 32) | index;
+    }
+
+    static const uint32_t kEmptyIndex = 0xFFFFFFFF;
+
     MemoryPool* parent_;
 
     char* data_;
 
     size_t allocated_sz_;
 
-    QVector<bool> available_;
-
-    QMutex lock_;
+    int element_count_;
 
     size_t element_sz_;
 
-    std::list<Element*> lent_elements_;
+    std::atomic<uint64_t> free_head_;
+
+    std::unique_ptr<std::atomic<uint32_t>[]> next_free_;
+
+    std::atomic_int usage_count_;
+
+    std::atomic_bool spare_;
+
+    std::vector<Element*> lent_elements_;
 
   };
 
   /**
    * @brief Retrieves an element from an available arena
+   *
+   * Threads only share a read lock while looking through arenas, taking an element from an arena
+   * is lock-free. The exclusive lock is only needed when a new arena has to be created.
    */
   ElementPtr Get() {
-    QMutexLocker locker(&lock_);
+    {
+      QReadLocker locker(&lock_);
 
-    // Attempt to get an element from an arena
-    foreach (Arena* a, arenas_) {
-      ElementPtr e = a->Get();
+      ElementPtr e = GetFromExistingArena();
 
       if (e) {
         return e;
       }
     }
 
+    QWriteLocker locker(&lock_);
+
+    // Another thread may have created an arena while we were waiting for the lock
+    ElementPtr e = GetFromExistingArena();
+
+    if (e) {
+      return e;
+    }
+
     // All arenas were empty, we'll need to create a new one
-    if (arenas_.empty()) {
-      qDebug() << "No arenas, creating new...";
-    } else {
-      qDebug() << "All arenas are full, creating new...";
+    if (logging_enabled_) {
+      if (arenas_.empty()) {
+        qDebug() << "No arenas, creating new...";
+      } else {
+        qDebug() << "All arenas are full, creating new...";
+      }
     }
 
     size_t ele_sz = GetElementSize();
@@ -357,21 +543,53 @@ public:
       return nullptr;
     }
 
-    arenas_.push_back(a);
+    arenas_.append(a);
+    arena_hint_ = arenas_.size() - 1;
     return a->Get();
   }
 
   void ArenaIsEmpty(Arena* a) {
-    // FIXME: Does this need to be mutexed?
     if (ignore_arena_empty_signal_) {
       return;
     }
 
-    QMutexLocker locker(&lock_);
+    QWriteLocker locker(&lock_);
+
+    // If the arena was briefly used again and emptied again, the first of these calls may have
+    // deleted it already, so don't touch it unless it's still ours
+    bool active = arenas_.contains(a);
+
+    if (!active && !retired_arenas_.contains(a)) {
+      return;
+    }
 
     if (!a->GetUsageCount()) {
-      qDebug() << "Removing an empty arena";
-      arenas_.remove(a);
+      if (a->IsSpare()) {
+        // Already kept as a spare by an earlier call
+        return;
+      }
+
+      if (spare_arena_limit_ > 0 && active) {
+        // Count the other empty arenas to see if we can keep this one as a spare
+        int spare_count = 0;
+
+        foreach (Arena* other, arenas_) {
+          if (other != a && !other->GetUsageCount()) {
+            spare_count++;
+          }
+        }
+
+        if (spare_count < spare_arena_limit_ && CanKeepSpareArena(a->GetAllocatedSize())) {
+          a->SetSpare(true);
+          return;
+        }
+      }
+
+      if (logging_enabled_) {
+        qDebug() << "Removing an empty arena";
+      }
+      arenas_.removeOne(a);
+      retired_arenas_.removeOne(a);
       delete a;
     }
   }
@@ -386,14 +604,64 @@ protected:
     return sizeof(T);
   }
 
+  /**
+   * @brief Called before keeping an empty arena of `size` bytes as a spare
+   *
+   * Override this to limit spares by something other than the per-pool count (e.g. a memory
+   * budget shared between several pools). Every call that returns true is balanced by a later
+   * call to SpareArenaReleased() once the spare is used again or freed.
+   */
+  virtual bool CanKeepSpareArena(size_t size) {
+    Q_UNUSED(size)
+    return true;
+  }
+
+  virtual void SpareArenaReleased(size_t size) {
+    Q_UNUSED(size)
+  }
+
 private:
+  /**
+   * @brief Try each arena in turn, starting from the last one that had an element to lend
+   *
+   * Must be called with lock_ held (read or write).
+   */
+  ElementPtr GetFromExistingArena() {
+    int count = arenas_.size();
+    int start = arena_hint_;
+
+    for (int i=0;i<count;i++) {
+      int index = (start + i) % count;
+
+      ElementPtr e = arenas_.at(index)->Get();
+
+      if (e) {
+        if (index != start) {
+          arena_hint_ = index;
+        }
+
+        return e;
+      }
+    }
+
+    return nullptr;
+  }
+
   int element_count_;
 
-  std::list<Arena*> arenas_;
+  int spare_arena_limit_;
+
+  std::atomic_bool logging_enabled_;
+
+  QVector<Arena*> arenas_;
+
+  QVector<Arena*> retired_arenas_;
+
+  std::atomic_int arena_hint_;
 
-  QMutex lock_;
+  QReadWriteLock lock_;
 
-  bool ignore_arena_empty_signal_;
+  std::atomic_bool ignore_arena_empty_signal_;
 
 };
 
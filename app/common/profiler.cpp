@@ -0,0 +1,250 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "profiler.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+OLIVE_NAMESPACE_ENTER
+
+// 16384 events of ~100 bytes each is about 1.6 MB per thread
+const int Profiler::kThreadBufferSize = 16384;
+
+std::atomic_bool Profiler::enabled_(false);
+QMutex Profiler::buffers_lock_;
+QVector<Profiler::ThreadBuffer*> Profiler::buffers_;
+QVector<Profiler::ThreadBuffer*> Profiler::free_buffers_;
+
+class Profiler::ThreadBuffer
+{
+public:
+  ThreadBuffer(int index) :
+    events_(new Event[kThreadBufferSize]),
+    written_(0),
+    cleared_(0),
+    index_(index)
+  {
+  }
+
+  // Only ever called by the thread that owns this buffer
+  void Append(const char* category, const char* name, const QByteArray& detail, quint64 id, qint64 start, qint64 end)
+  {
+    quint64 w = written_.load(std::memory_order_relaxed);
+
+    Event& e = events_[w % kThreadBufferSize];
+    e.category = category;
+    e.name = name;
+
+    size_t detail_len = qMin(static_cast<size_t>(detail.size()), sizeof(e.detail) - 1);
+    memcpy(e.detail, detail.constData(), detail_len);
+    e.detail[detail_len] = 0;
+
+    e.id = id;
+    e.start = start;
+    e.duration = end - start;
+    e.thread = index_;
+
+    written_.store(w + 1, std::memory_order_release);
+  }
+
+  void CollectInto(QVector<Event>& list) const
+  {
+    quint64 end = written_.load(std::memory_order_acquire);
+    quint64 start = qMax(cleared_.load(std::memory_order_relaxed),
+                         end > quint64(kThreadBufferSize) ? end - kThreadBufferSize : 0);
+
+    int first_new = list.size();
+
+    for (quint64 i=start; i<end; i++) {
+      list.append(events_[i % kThreadBufferSize]);
+    }
+
+    // The owning thread may have lapped us while we were copying, drop anything it could have overwritten.
+    // That includes event `now_written - kThreadBufferSize`, whose slot the owner may be writing right now.
+    quint64 now_written = written_.load(std::memory_order_acquire);
+
+    if (now_written >= quint64(kThreadBufferSize) && now_written - kThreadBufferSize >= start) {
+      int overwritten = static_cast<int>(qMin(now_written - kThreadBufferSize - start + 1, end - start));
+      list.remove(first_new, overwritten);
+    }
+  }
+
+  void Clear()
+  {
+    cleared_.store(written_.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+
+private:
+  std::unique_ptr<Event[]> events_;
+
+  std::atomic<quint64> written_;
+
+  std::atomic<quint64> cleared_;
+
+  int index_;
+
+};
+
+/**
+ * @brief Hands a thread's buffer back to the profiler when the thread exits
+ *
+ * Thread pools regularly retire and recreate threads, so buffers are recycled rather than leaked.
+ */
+class ThreadBufferHolder
+{
+public:
+  ThreadBufferHolder() :
+    buffer(nullptr)
+  {
+  }
+
+  ~ThreadBufferHolder()
+  {
+    if (buffer) {
+      Profiler::ReleaseThreadBuffer(buffer);
+    }
+  }
+
+  Profiler::ThreadBuffer* buffer;
+
+};
+
+void Profiler::SetEnabled(bool e)
+{
+  enabled_.store(e, std::memory_order_relaxed);
+}
+
+qint64 Profiler::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char *category, const char *name, const QByteArray &detail, quint64 id, qint64 start, qint64 end)
+{
+  static thread_local ThreadBufferHolder holder;
+
+  if (!holder.buffer) {
+    holder.buffer = AcquireThreadBuffer();
+  }
+
+  holder.buffer->Append(category, name, detail, id, start, end);
+}
+
+QVector<Profiler::Event> Profiler::Collect()
+{
+  QVector<Event> events;
+
+  QMutexLocker locker(&buffers_lock_);
+
+  foreach (ThreadBuffer* b, buffers_) {
+    b->CollectInto(events);
+  }
+
+  return events;
+}
+
+void Profiler::Clear()
+{
+  QMutexLocker locker(&buffers_lock_);
+
+  foreach (ThreadBuffer* b, buffers_) {
+    b->Clear();
+  }
+}
+
+bool Profiler::ExportChromeTrace(const QString &filename)
+{
+  QVector<Event> events = Collect();
+
+  QJsonArray trace_events;
+
+  foreach (const Event& e, events) {
+    QJsonObject args;
+
+    if (e.detail[0]) {
+      args.insert(QStringLiteral("detail"), QString::fromUtf8(e.detail));
+    }
+
+    if (e.id) {
+      args.insert(QStringLiteral("id"), QString::number(e.id, 16));
+    }
+
+    QJsonObject o;
+    o.insert(QStringLiteral("name"), QString::fromLatin1(e.name));
+    o.insert(QStringLiteral("cat"), QString::fromLatin1(e.category));
+    o.insert(QStringLiteral("ph"), QStringLiteral("X"));
+
+    // Chrome traces are in microseconds
+    o.insert(QStringLiteral("ts"), static_cast<double>(e.start) / 1000.0);
+    o.insert(QStringLiteral("dur"), static_cast<double>(e.duration) / 1000.0);
+
+    o.insert(QStringLiteral("pid"), 1);
+    o.insert(QStringLiteral("tid"), e.thread);
+    o.insert(QStringLiteral("args"), args);
+
+    trace_events.append(o);
+  }
+
+  QJsonObject root;
+  root.insert(QStringLiteral("traceEvents"), trace_events);
+  root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ns"));
+
+  QFile f(filename);
+
+  if (!f.open(QFile::WriteOnly)) {
+    qWarning() << "Failed to open" << filename << "for writing";
+    return false;
+  }
+
+  f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+  f.close();
+
+  return true;
+}
+
+Profiler::ThreadBuffer *Profiler::AcquireThreadBuffer()
+{
+  QMutexLocker locker(&buffers_lock_);
+
+  if (!free_buffers_.isEmpty()) {
+    return free_buffers_.takeLast();
+  }
+
+  ThreadBuffer* b = new ThreadBuffer(buffers_.size());
+  buffers_.append(b);
+  return b;
+}
+
+void Profiler::ReleaseThreadBuffer(Profiler::ThreadBuffer *buffer)
+{
+  QMutexLocker locker(&buffers_lock_);
+
+  // Its events stay collectable until another thread picks it up
+  free_buffers_.append(buffer);
+}
+
+OLIVE_NAMESPACE_EXIT
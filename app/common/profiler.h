@@ -0,0 +1,193 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Records timed scopes from any thread for finding out where render time goes
+ *
+ * Each thread writes into its own fixed-size ring buffer, so recording an event never takes a lock or allocates. When
+ * a buffer fills up, the oldest events are overwritten. Recording is off by default and costs one relaxed atomic load
+ * per scope while off.
+ *
+ * Use PROFILE_SCOPE or PROFILE_SCOPE_DETAIL rather than calling Record() directly.
+ */
+class Profiler
+{
+public:
+  struct Event {
+    const char* category;
+    const char* name;
+    char detail[64];
+    quint64 id;
+    qint64 start;
+    qint64 duration;
+    int thread;
+  };
+
+  static bool IsEnabled()
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static void SetEnabled(bool e);
+
+  /**
+   * @brief Monotonic time in nanoseconds
+   */
+  static qint64 Now();
+
+  /**
+   * @brief Add an event to the calling thread's buffer
+   *
+   * `category` and `name` must be string literals (or otherwise outlive the profiler). `detail` is truncated to fit
+   * in the event.
+   */
+  static void Record(const char* category, const char* name, const QByteArray& detail, quint64 id,
+                     qint64 start, qint64 end);
+
+  /**
+   * @brief Returns a snapshot of every thread's events since the last Clear()
+   */
+  static QVector<Event> Collect();
+
+  /**
+   * @brief Discard all recorded events
+   */
+  static void Clear();
+
+  /**
+   * @brief Writes the recorded events as a Chrome trace (viewable in chrome://tracing or Perfetto)
+   */
+  static bool ExportChromeTrace(const QString& filename);
+
+private:
+  class ThreadBuffer;
+
+  friend class ThreadBufferHolder;
+
+  static ThreadBuffer* AcquireThreadBuffer();
+
+  static void ReleaseThreadBuffer(ThreadBuffer* buffer);
+
+  static const int kThreadBufferSize;
+
+  static std::atomic_bool enabled_;
+
+  static QMutex buffers_lock_;
+
+  static QVector<ThreadBuffer*> buffers_;
+
+  static QVector<ThreadBuffer*> free_buffers_;
+
+};
+
+/**
+ * @brief Records the time between its construction and destruction if the profiler is enabled
+ */
+class ProfileScope
+{
+public:
+  ProfileScope(const char* category, const char* name, quint64 id = 0) :
+    category_(category),
+    name_(name),
+    id_(id),
+    start_(Profiler::IsEnabled() ? Profiler::Now() : -1)
+  {
+  }
+
+  ~ProfileScope()
+  {
+    if (start_ >= 0) {
+      Profiler::Record(category_, name_, detail_, id_, start_, Profiler::Now());
+    }
+  }
+
+  DISABLE_COPY_MOVE(ProfileScope)
+
+  bool IsActive() const
+  {
+    return start_ >= 0;
+  }
+
+  void SetDetail(const QByteArray& detail)
+  {
+    detail_ = detail;
+  }
+
+  void SetDetail(const QString& detail)
+  {
+    detail_ = detail.toUtf8();
+  }
+
+  /**
+   * @brief Set the detail returned by `f`, which is only called while the profiler is recording
+   */
+  template <typename F>
+  void SetDetailLazy(F f)
+  {
+    if (IsActive()) {
+      SetDetail(f());
+    }
+  }
+
+private:
+  const char* category_;
+
+  const char* name_;
+
+  QByteArray detail_;
+
+  quint64 id_;
+
+  qint64 start_;
+
+};
+
+// Scope variables are named after the line they're declared on so several can share a scope
+#define PROFILE_SCOPE_CONCAT_INTERNAL(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_INTERNAL(a, b)
+#define PROFILE_SCOPE_VARIABLE PROFILE_SCOPE_CONCAT(olive_profile_scope_, __LINE__)
+
+#define PROFILE_SCOPE(category, name) ProfileScope PROFILE_SCOPE_VARIABLE(category, name)
+
+// `detail` is only evaluated while the profiler is recording
+#define PROFILE_SCOPE_DETAIL(category, name, detail) \
+  ProfileScope PROFILE_SCOPE_VARIABLE(category, name); \
+  PROFILE_SCOPE_VARIABLE.SetDetailLazy([&]{ return (detail); })
+
+#define PROFILE_SCOPE_ID(category, name, id, detail) \
+  ProfileScope PROFILE_SCOPE_VARIABLE(category, name, id); \
+  PROFILE_SCOPE_VARIABLE.SetDetailLazy([&]{ return (detail); })
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // PROFILER_H
@@ -63,6 +63,9 @@ struct XMLNodeData {
   QList<BlockLink> block_links;
   QHash<quintptr, Item*> item_ptrs;
 
+  // Items that were loaded elsewhere (e.g. in parallel) and only need to be placed in the tree
+  QHash<quintptr, std::shared_ptr<Item> > preloaded_items;
+
 };
 
 void XMLConnectNodes(const XMLNodeData& xml_node_data, QUndoCommand* command = nullptr);
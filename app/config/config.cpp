@@ -27,6 +27,7 @@
 #include <QStandardPaths>
 #include <QXmlStreamWriter>
 
+#include "codec/samplebuffer.h"
 #include "common/autoscroll.h"
 #include "common/filefunctions.h"
 #include "common/xmlutils.h"
@@ -89,6 +90,7 @@ void Config::SetDefaults()
   SetEntryInternal(QStringLiteral("RectifiedWaveforms"), NodeParam::kBoolean, false);
   SetEntryInternal(QStringLiteral("DropWithoutSequenceBehavior"), NodeParam::kInt, ImportTool::kDWSAsk);
   SetEntryInternal(QStringLiteral("Loop"), NodeParam::kBoolean, false);
+  SetEntryInternal(QStringLiteral("BinaryProjects"), NodeParam::kBoolean, false);
 
   SetEntryInternal(QStringLiteral("AutoCacheInterval"), NodeParam::kInt, 250);
 
@@ -105,6 +107,8 @@ void Config::SetDefaults()
 
   SetEntryInternal(QStringLiteral("AudioOutput"), NodeParam::kString, QString());
   SetEntryInternal(QStringLiteral("AudioInput"), NodeParam::kString, QString());
+  SetEntryInternal(QStringLiteral("AudioSpeedQuality"), NodeParam::kInt, SampleBuffer::kSpeedQualityHigh);
+  SetEntryInternal(QStringLiteral("AudioChunkLength"), NodeParam::kRational, QVariant::fromValue(rational(2)));
 
   SetEntryInternal(QStringLiteral("DiskCacheBehind"), NodeParam::kRational, QVariant::fromValue(rational(1)));
   SetEntryInternal(QStringLiteral("DiskCacheAhead"), NodeParam::kRational, QVariant::fromValue(rational(5)));
@@ -50,10 +50,12 @@
 #include "panel/project/project.h"
 #include "panel/viewer/viewer.h"
 #include "render/backend/opengl/opengltexturecache.h"
+#include "render/backend/stillcache.h"
 #include "render/colormanager.h"
 #include "render/diskmanager.h"
 #include "render/pixelformat.h"
 #include "render/shaderinfo.h"
+#include "render/thumbnailcache.h"
 #ifdef USE_OTIO
 #include "task/project/loadotio/loadotio.h"
 #include "task/project/saveotio/saveotio.h"
@@ -138,6 +140,12 @@ void Core::Start()
   // Initialize OpenGL service
   OpenGLProxy::CreateInstance();
 
+  // Initialize shared still image cache
+  StillCache::CreateInstance();
+
+  // Initialize background thumbnail service
+  ThumbnailCache::CreateInstance();
+
   //
   // Start application
   //
@@ -158,6 +166,9 @@ void Core::Start()
   case CoreParams::kHeadlessPreCache:
     qInfo() << "Headless pre-cache is not fully implemented yet";
     break;
+  case CoreParams::kHeadlessBenchmark:
+    // Nothing to start, olive-bench drives everything from its own main()
+    break;
   }
 }
 
@@ -180,6 +191,12 @@ void Core::Stop()
     }
   }
 
+  // Waits for any thumbnail that's currently being decoded
+  ThumbnailCache::DestroyInstance();
+
+  // Holds textures, so must be destroyed before the OpenGL service
+  StillCache::DestroyInstance();
+
   OpenGLProxy::DestroyInstance();
 
   MenuShared::DestroyInstance();
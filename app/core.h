@@ -60,7 +60,8 @@ public:
     enum RunMode {
       kRunNormal,
       kHeadlessExport,
-      kHeadlessPreCache
+      kHeadlessPreCache,
+      kHeadlessBenchmark
     };
 
     bool fullscreen() const
@@ -24,6 +24,7 @@
 #include <QLabel>
 
 #include "audio/audiomanager.h"
+#include "codec/samplebuffer.h"
 #include "config/config.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -79,6 +80,30 @@ PreferencesAudioTab::PreferencesAudioTab()
 
   row++;
 
+  // Audio -> Speed Quality
+  audio_tab_layout->addWidget(new QLabel(tr("Speed Change Quality:")), row, 0);
+
+  speed_quality_combobox_ = new QComboBox();
+  speed_quality_combobox_->addItem(tr("Fast (Nearest)"), SampleBuffer::kSpeedQualityNearest);
+  speed_quality_combobox_->addItem(tr("Medium (Linear)"), SampleBuffer::kSpeedQualityLinear);
+  speed_quality_combobox_->addItem(tr("High (Sinc)"), SampleBuffer::kSpeedQualityHigh);
+  speed_quality_combobox_->setCurrentIndex(speed_quality_combobox_->findData(Config::Current()["AudioSpeedQuality"].toInt()));
+  audio_tab_layout->addWidget(speed_quality_combobox_, row, 1);
+
+  row++;
+
+  // Audio -> Render Chunk Length
+  audio_tab_layout->addWidget(new QLabel(tr("Render Chunk Length:")), row, 0);
+
+  chunk_length_slider_ = new FloatSlider();
+  chunk_length_slider_->SetFormat(tr("%1 seconds"));
+  chunk_length_slider_->SetMinimum(0.1);
+  chunk_length_slider_->SetMaximum(30.0);
+  chunk_length_slider_->SetValue(Config::Current()["AudioChunkLength"].value<rational>().toDouble());
+  audio_tab_layout->addWidget(chunk_length_slider_, row, 1);
+
+  row++;
+
   refresh_devices_btn_ = new QPushButton(tr("Refresh Devices"));
   audio_tab_layout->addWidget(refresh_devices_btn_, row, 1);
 
@@ -135,6 +160,9 @@ void PreferencesAudioTab::Accept()
       AudioManager::instance()->SetInputDevice(selected_input);
     }
   }
+
+  Config::Current()["AudioSpeedQuality"] = speed_quality_combobox_->currentData();
+  Config::Current()["AudioChunkLength"] = QVariant::fromValue(rational::fromDouble(chunk_length_slider_->GetValue()));
 }
 
 void PreferencesAudioTab::RefreshDevices()
@@ -26,6 +26,7 @@
 #include <QPushButton>
 
 #include "preferencestab.h"
+#include "widget/slider/floatslider.h"
 
 OLIVE_NAMESPACE_ENTER
 
@@ -58,6 +59,16 @@ private:
    */
   QComboBox* recording_combobox_;
 
+  /**
+   * @brief UI widget for selecting the quality of audio speed changes
+   */
+  QComboBox* speed_quality_combobox_;
+
+  /**
+   * @brief UI widget for setting how much audio is rendered in one go
+   */
+  FloatSlider* chunk_length_slider_;
+
   /**
    * @brief Button that triggers a refresh of the available audio devices
    */
@@ -99,6 +99,16 @@ PreferencesGeneralTab::PreferencesGeneralTab()
 
   row++;
 
+  general_layout->addWidget(new QLabel(tr("Save Projects in Binary Format:")), row, 0);
+
+  binary_projects_ = new QCheckBox();
+  binary_projects_->setToolTip(tr("Binary projects open and save faster, but can't be read by older "
+                                  "versions of Olive or edited by hand."));
+  binary_projects_->setChecked(Config::Current()["BinaryProjects"].toBool());
+  general_layout->addWidget(binary_projects_, row, 1);
+
+  row++;
+
   general_layout->addWidget(new QLabel(tr("Default Still Image Length:")), row, 0);
 
   default_still_length_ = new FloatSlider();
@@ -114,6 +124,8 @@ void PreferencesGeneralTab::Accept()
 {
   Config::Current()["RectifiedWaveforms"] = rectified_waveforms_->isChecked();
 
+  Config::Current()["BinaryProjects"] = binary_projects_->isChecked();
+
   Config::Current()["Autoscroll"] = autoscroll_method_->currentData();
 
   Config::Current()["DefaultStillLength"] = QVariant::fromValue(rational::fromDouble(default_still_length_->GetValue()));
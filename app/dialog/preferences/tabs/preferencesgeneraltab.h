@@ -46,6 +46,8 @@ private:
 
   QCheckBox* rectified_waveforms_;
 
+  QCheckBox* binary_projects_;
+
   FloatSlider* default_still_length_;
 
 };
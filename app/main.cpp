@@ -127,6 +127,9 @@ int main(int argc, char *argv[])
   format.setProfile(QSurfaceFormat::CoreProfile);
   QSurfaceFormat::setDefaultFormat(format);
 
+  // Share textures between all widget contexts so a frame uploaded by the viewer can be drawn by scopes as well
+  QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+
   // Enable application automatically using higher resolution images from icons
   QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 
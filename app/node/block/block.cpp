@@ -375,4 +375,10 @@ void Block::Hash(QCryptographicHash &, const rational &) const
   // A block does nothing by default, so we hash nothing
 }
 
+TimeRange Block::GetTimeInvariantRange(const rational &) const
+{
+  // Nothing is hashed so nothing can change
+  return TimeRange(RATIONAL_MIN, RATIONAL_MAX);
+}
+
 OLIVE_NAMESPACE_EXIT
@@ -85,6 +85,8 @@ public:
 
   virtual void Hash(QCryptographicHash &hash, const rational &time) const override;
 
+  virtual TimeRange GetTimeInvariantRange(const rational &time) const override;
+
 public slots:
 
 signals:
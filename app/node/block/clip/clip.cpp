@@ -120,4 +120,21 @@ void ClipBlock::Hash(QCryptographicHash &hash, const rational &time) const
   }
 }
 
+TimeRange ClipBlock::GetTimeInvariantRange(const rational &time) const
+{
+  if (!texture_input_->is_connected()) {
+    return Block::GetTimeInvariantRange(time);
+  }
+
+  rational t = InputTimeAdjustment(texture_input_, TimeRange(time, time)).in();
+
+  TimeRange range = OutputTimeAdjustment(texture_input_, texture_input_->get_connected_node()->GetTimeInvariantRange(t));
+
+  if (time < range.in() || time >= range.out()) {
+    return TimeRange(time, time);
+  }
+
+  return range;
+}
+
 OLIVE_NAMESPACE_EXIT
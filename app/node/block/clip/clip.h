@@ -56,6 +56,8 @@ public:
 
   virtual void Hash(QCryptographicHash &hash, const rational &time) const override;
 
+  virtual TimeRange GetTimeInvariantRange(const rational &time) const override;
+
 private:
   NodeInput* texture_input_;
 
@@ -152,6 +152,12 @@ void TransitionBlock::Hash(QCryptographicHash &hash, const rational &time) const
   hash.addData(reinterpret_cast<const char*>(&out_prog), sizeof(double));
 }
 
+TimeRange TransitionBlock::GetTimeInvariantRange(const rational &time) const
+{
+  // Transition progress is hashed and changes on every frame
+  return TimeRange(time, time);
+}
+
 double TransitionBlock::GetInternalTransitionTime(const double &time) const
 {
   return time - in().toDouble();
@@ -49,6 +49,8 @@ public:
 
   virtual void Hash(QCryptographicHash& hash, const rational &time) const override;
 
+  virtual TimeRange GetTimeInvariantRange(const rational &time) const override;
+
   virtual NodeValueTable Value(NodeValueDatabase &value) const override;
 
   static TransitionBlock* GetBlockInTransition(Block* block);
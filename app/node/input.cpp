@@ -20,6 +20,7 @@
 
 #include "input.h"
 
+#include <algorithm>
 #include <QMatrix4x4>
 #include <QVector2D>
 #include <QVector3D>
@@ -554,78 +555,159 @@ QVariant NodeInput::get_value_at_time_for_track(const rational& time, int track)
     }
 
     // If we're here, the time must be somewhere in between the keyframes
-    for (int i=0;i<key_track.size()-1;i++) {
-      NodeKeyframePtr before = key_track.at(i);
-      NodeKeyframePtr after = key_track.at(i+1);
+    int index = FindIndexOfKeyframeBeforeTime(key_track, time);
 
-      if (before->time() == time
-          || !type_can_be_interpolated(data_type())
-          || (before->time() < time && before->type() == NodeKeyframe::kHold)) {
-
-        // Time == keyframe time, so value is precise
-        return before->value();
+    return get_value_between_keyframes(key_track.at(index), key_track.at(index + 1), time);
+  }
 
-      } else if (after->time() == time) {
+  return standard_value_.at(track);
+}
 
-        // Time == keyframe time, so value is precise
-        return after->value();
+QVector<QVariant> NodeInput::get_values_at_times_for_track(const QVector<rational> &times, int track) const
+{
+  QVector<QVariant> values(times.size());
 
-      } else if (before->time() < time && after->time() > time) {
-        // We must interpolate between these keyframes
+  if (is_using_standard_value(track)) {
+    values.fill(standard_value_.at(track));
+    return values;
+  }
 
-        if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
-          // Perform a cubic bezier with two control points
+  const KeyframeTrack& key_track = keyframe_tracks_.at(track);
 
-          double t = Bezier::CubicXtoT(time.toDouble(),
-                                       before->time().toDouble(),
-                                       before->time().toDouble() + before->bezier_control_out().x(),
-                                       after->time().toDouble() + after->bezier_control_in().x(),
-                                       after->time().toDouble());
+  // Cursor into the keyframe track, this only ever needs to move forward for ascending times
+  int index = -1;
+  double last_bezier_t = -1.0;
 
-          double y = Bezier::CubicTtoY(before->value().toDouble(),
-                                       before->value().toDouble() + before->bezier_control_out().y(),
-                                       after->value().toDouble() + after->bezier_control_in().y(),
-                                       after->value().toDouble(),
-                                       t);
+  for (int i=0; i<times.size(); i++) {
+    const rational& time = times.at(i);
 
-          return y;
+    if (key_track.first()->time() >= time) {
+      values[i] = key_track.first()->value();
+      continue;
+    }
 
-        } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
-          // Perform a quadratic bezier with only one control point
+    if (key_track.last()->time() <= time) {
+      values[i] = key_track.last()->value();
+      continue;
+    }
 
-          QPointF control_point;
-          double control_point_time;
-          double control_point_value;
+    if (index == -1 || key_track.at(index)->time() > time) {
+      // First in-between time or times went backwards, re-seek the cursor
+      index = FindIndexOfKeyframeBeforeTime(key_track, time);
+      last_bezier_t = -1.0;
+    } else {
+      while (key_track.at(index + 1)->time() <= time) {
+        index++;
+        last_bezier_t = -1.0;
+      }
+    }
 
-          if (before->type() == NodeKeyframe::kBezier) {
-            control_point = before->bezier_control_out();
-            control_point_time = before->time().toDouble() + control_point.x();
-            control_point_value = before->value().toDouble() + control_point.y();
-          } else {
-            control_point = after->bezier_control_in();
-            control_point_time = after->time().toDouble() + control_point.x();
-            control_point_value = after->value().toDouble() + control_point.y();
-          }
+    values[i] = get_value_between_keyframes(key_track.at(index), key_track.at(index + 1), time, &last_bezier_t);
+  }
 
-          // Generate T from time values - used to determine bezier progress
-          double t = Bezier::QuadraticXtoT(time.toDouble(), before->time().toDouble(), control_point_time, after->time().toDouble());
+  return values;
+}
 
-          // Generate value using T
-          double y = Bezier::QuadraticTtoY(before->value().toDouble(), control_point_value, after->value().toDouble(), t);
+QVector<QVector<QVariant> > NodeInput::get_split_values_at_times(const QVector<rational> &times) const
+{
+  QVector<QVector<QVariant> > values(times.size());
 
-          return y;
+  for (int i=0; i<values.size(); i++) {
+    values[i].resize(get_number_of_keyframe_tracks());
+  }
 
-        } else {
-          // To have arrived here, the keyframes must both be linear
-          qreal period_progress = (time.toDouble() - before->time().toDouble()) / (after->time().toDouble() - before->time().toDouble());
+  for (int i=0; i<get_number_of_keyframe_tracks(); i++) {
+    QVector<QVariant> track_values = get_values_at_times_for_track(times, i);
 
-          return lerp(before->value().toDouble(), after->value().toDouble(), period_progress);
-        }
-      }
+    for (int j=0; j<track_values.size(); j++) {
+      values[j][i] = track_values.at(j);
     }
   }
 
-  return standard_value_.at(track);
+  return values;
+}
+
+QVector<QVariant> NodeInput::get_values_at_times(const QVector<rational> &times) const
+{
+  QVector<QVector<QVariant> > split_values = get_split_values_at_times(times);
+
+  QVector<QVariant> values(split_values.size());
+
+  for (int i=0; i<split_values.size(); i++) {
+    values[i] = combine_track_values_into_normal_value(split_values.at(i));
+  }
+
+  return values;
+}
+
+QVariant NodeInput::get_value_between_keyframes(const NodeKeyframePtr &before, const NodeKeyframePtr &after, const rational &time, double *bezier_t) const
+{
+  if (before->time() == time
+      || !type_can_be_interpolated(data_type())
+      || before->type() == NodeKeyframe::kHold) {
+
+    // Time == keyframe time, so value is precise
+    return before->value();
+
+  } else if (after->time() == time) {
+
+    // Time == keyframe time, so value is precise
+    return after->value();
+
+  } else if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
+    // Perform a cubic bezier with two control points
+
+    double t = Bezier::CubicXtoT(time.toDouble(),
+                                 before->time().toDouble(),
+                                 before->time().toDouble() + before->bezier_control_out().x(),
+                                 after->time().toDouble() + after->bezier_control_in().x(),
+                                 after->time().toDouble(),
+                                 bezier_t ? *bezier_t : -1.0);
+
+    if (bezier_t) {
+      // Store T so dense callers can use it as the starting point for the next solve
+      *bezier_t = t;
+    }
+
+    double y = Bezier::CubicTtoY(before->value().toDouble(),
+                                 before->value().toDouble() + before->bezier_control_out().y(),
+                                 after->value().toDouble() + after->bezier_control_in().y(),
+                                 after->value().toDouble(),
+                                 t);
+
+    return y;
+
+  } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
+    // Perform a quadratic bezier with only one control point
+
+    QPointF control_point;
+    double control_point_time;
+    double control_point_value;
+
+    if (before->type() == NodeKeyframe::kBezier) {
+      control_point = before->bezier_control_out();
+      control_point_time = before->time().toDouble() + control_point.x();
+      control_point_value = before->value().toDouble() + control_point.y();
+    } else {
+      control_point = after->bezier_control_in();
+      control_point_time = after->time().toDouble() + control_point.x();
+      control_point_value = after->value().toDouble() + control_point.y();
+    }
+
+    // Generate T from time values - used to determine bezier progress
+    double t = Bezier::QuadraticXtoT(time.toDouble(), before->time().toDouble(), control_point_time, after->time().toDouble());
+
+    // Generate value using T
+    double y = Bezier::QuadraticTtoY(before->value().toDouble(), control_point_value, after->value().toDouble(), t);
+
+    return y;
+
+  } else {
+    // To have arrived here, the keyframes must both be linear
+    qreal period_progress = (time.toDouble() - before->time().toDouble()) / (after->time().toDouble() - before->time().toDouble());
+
+    return lerp(before->value().toDouble(), after->value().toDouble(), period_progress);
+  }
 }
 
 QList<NodeKeyframePtr> NodeInput::get_keyframe_at_time(const rational &time) const
@@ -646,10 +728,11 @@ QList<NodeKeyframePtr> NodeInput::get_keyframe_at_time(const rational &time) con
 NodeKeyframePtr NodeInput::get_keyframe_at_time_on_track(const rational &time, int track) const
 {
   if (!is_using_standard_value(track)) {
-    foreach (NodeKeyframePtr key, keyframe_tracks_.at(track)) {
-      if (key->time() == time) {
-        return key;
-      }
+    const KeyframeTrack& key_track = keyframe_tracks_.at(track);
+    int index = FindIndexOfKeyframeBeforeTime(key_track, time);
+
+    if (index > -1 && key_track.at(index)->time() == time) {
+      return key_track.at(index);
     }
   }
 
@@ -672,24 +755,20 @@ NodeKeyframePtr NodeInput::get_closest_keyframe_to_time_on_track(const rational
     return key_track.last();
   }
 
-  for (int i=1;i<key_track.size();i++) {
-    NodeKeyframePtr prev_key = key_track.at(i-1);
-    NodeKeyframePtr next_key = key_track.at(i);
+  int index = FindIndexOfKeyframeBeforeTime(key_track, time);
 
-    if (prev_key->time() <= time && next_key->time() >= time) {
-      // Return whichever is closer
-      rational prev_diff = time - prev_key->time();
-      rational next_diff = next_key->time() - time;
+  NodeKeyframePtr prev_key = key_track.at(index);
+  NodeKeyframePtr next_key = key_track.at(index + 1);
 
-      if (next_diff < prev_diff) {
-        return next_key;
-      } else {
-        return prev_key;
-      }
-    }
-  }
+  // Return whichever is closer
+  rational prev_diff = time - prev_key->time();
+  rational next_diff = next_key->time() - time;
 
-  return nullptr;
+  if (next_diff < prev_diff) {
+    return next_key;
+  } else {
+    return prev_key;
+  }
 }
 
 NodeKeyframePtr NodeInput::get_closest_keyframe_before_time(const rational &time) const
@@ -905,6 +984,19 @@ void NodeInput::KeyframeBezierOutChanged()
   emit ValueChanged(TimeRange(start, end));
 }
 
+int NodeInput::FindIndexOfKeyframeBeforeTime(const KeyframeTrack &track, const rational &time)
+{
+  // Keyframes are always sorted by time, so we can binary search for the first one after this time
+  KeyframeTrack::const_iterator after = std::upper_bound(track.constBegin(),
+                                                         track.constEnd(),
+                                                         time,
+                                                         [](const rational& t, const NodeKeyframePtr& key) {
+    return t < key->time();
+  });
+
+  return static_cast<int>(after - track.constBegin()) - 1;
+}
+
 int NodeInput::FindIndexOfKeyframeFromRawPtr(NodeKeyframe *raw_ptr) const
 {
   const KeyframeTrack& track = keyframe_tracks_.at(raw_ptr->track());
@@ -983,6 +1075,47 @@ TimeRange NodeInput::get_range_around_index(int index, int track) const
   return TimeRange(range_begin, range_end);
 }
 
+bool NodeInput::get_range_affected_by_track_change(const KeyframeTrack &old_track, const KeyframeTrack &new_track, TimeRange *range)
+{
+  int common_size = qMin(old_track.size(), new_track.size());
+
+  // Skip keyframes that are identical at the start of both tracks
+  int first_diff = 0;
+  while (first_diff < common_size && keyframes_are_equal(old_track.at(first_diff), new_track.at(first_diff))) {
+    first_diff++;
+  }
+
+  if (first_diff == old_track.size() && first_diff == new_track.size()) {
+    // Tracks are identical
+    return false;
+  }
+
+  // Skip keyframes that are identical at the end of both tracks (without overlapping the start)
+  int common_tail = 0;
+  while (common_tail < common_size - first_diff
+         && keyframes_are_equal(old_track.at(old_track.size() - 1 - common_tail),
+                                new_track.at(new_track.size() - 1 - common_tail))) {
+    common_tail++;
+  }
+
+  // Values are interpolated from the neighboring keyframes, so the range extends to the nearest unchanged keys
+  rational range_begin = (first_diff > 0) ? old_track.at(first_diff - 1)->time() : RATIONAL_MIN;
+  rational range_end = (common_tail > 0) ? old_track.at(old_track.size() - common_tail)->time() : RATIONAL_MAX;
+
+  *range = TimeRange(range_begin, range_end);
+
+  return true;
+}
+
+bool NodeInput::keyframes_are_equal(const NodeKeyframePtr &a, const NodeKeyframePtr &b)
+{
+  return a->time() == b->time()
+      && a->type() == b->type()
+      && a->value() == b->value()
+      && a->bezier_control_in() == b->bezier_control_in()
+      && a->bezier_control_out() == b->bezier_control_out();
+}
+
 void NodeInput::emit_time_range(const TimeRange &range)
 {
   emit ValueChanged(range);
@@ -1034,6 +1167,44 @@ bool NodeInput::is_static() const
   return !(this->is_connected() || this->is_keyframing());
 }
 
+TimeRange NodeInput::get_time_invariant_range(const rational &time) const
+{
+  TimeRange range(RATIONAL_MIN, RATIONAL_MAX);
+
+  for (int i=0;i<keyframe_tracks_.size();i++) {
+    if (is_using_standard_value(i)) {
+      // Standard values never change over time
+      continue;
+    }
+
+    const KeyframeTrack& track = keyframe_tracks_.at(i);
+    int before_index = FindIndexOfKeyframeBeforeTime(track, time);
+
+    if (before_index == -1) {
+      // Before the first keyframe, the first keyframe's value is held
+      range = range.Intersected(TimeRange(RATIONAL_MIN, track.first()->time()));
+    } else if (before_index == track.size() - 1) {
+      // After the last keyframe, the last keyframe's value is held
+      range = range.Intersected(TimeRange(track.last()->time(), RATIONAL_MAX));
+    } else {
+      const NodeKeyframePtr& before = track.at(before_index);
+      const NodeKeyframePtr& after = track.at(before_index + 1);
+
+      if (before->type() == NodeKeyframe::kHold
+          || (before->type() == NodeKeyframe::kLinear
+              && after->type() == NodeKeyframe::kLinear
+              && before->value() == after->value())) {
+        // The value can't change between these keyframes
+        range = range.Intersected(TimeRange(before->time(), after->time()));
+      } else {
+        return TimeRange(time, time);
+      }
+    }
+  }
+
+  return range;
+}
+
 QVariant NodeInput::get_standard_value() const
 {
   return combine_track_values_into_normal_value(standard_value_);
@@ -1046,6 +1217,11 @@ const QVector<QVariant> &NodeInput::get_split_standard_value() const
 
 void NodeInput::set_standard_value(const QVariant &value, int track)
 {
+  if (standard_value_.at(track) == value) {
+    // Nothing has changed so there's nothing to invalidate
+    return;
+  }
+
   standard_value_.replace(track, value);
 
   if (is_using_standard_value(track)) {
@@ -1068,6 +1244,28 @@ void NodeInput::CopyValues(NodeInput *source, NodeInput *dest, bool include_conn
 {
   Q_ASSERT(source->id() == dest->id());
 
+  // Determine which times will actually change before overwriting anything, so we only invalidate those rather
+  // than the entire timeline
+  TimeRangeList affected_ranges;
+
+  for (int i=0;i<dest->standard_value_.size();i++) {
+    bool dest_uses_standard = dest->is_using_standard_value(i);
+    bool source_uses_standard = source->is_using_standard_value(i);
+
+    if (dest_uses_standard != source_uses_standard
+        || (dest_uses_standard && dest->standard_value_.at(i) != source->standard_value_.at(i))) {
+      // A standard value applies to all time
+      affected_ranges.InsertTimeRange(TimeRange(RATIONAL_MIN, RATIONAL_MAX));
+      break;
+    }
+
+    TimeRange track_range;
+    if (!dest_uses_standard
+        && get_range_affected_by_track_change(dest->keyframe_tracks_.at(i), source->keyframe_tracks_.at(i), &track_range)) {
+      affected_ranges.InsertTimeRange(track_range);
+    }
+  }
+
   // Copy standard value
   dest->standard_value_ = source->standard_value_;
 
@@ -1103,7 +1301,9 @@ void NodeInput::CopyValues(NodeInput *source, NodeInput *dest, bool include_conn
     }
   }
 
-  emit dest->ValueChanged(TimeRange(RATIONAL_MIN, RATIONAL_MAX));
+  foreach (const TimeRange& range, affected_ranges) {
+    emit dest->ValueChanged(range);
+  }
 }
 
 void NodeInput::set_property(const QString &key, const QVariant &value)
@@ -105,6 +105,26 @@ public:
    */
   QVariant get_value_at_time_for_track(const rational& time, int track) const;
 
+  /**
+   * @brief Calculate the stored value for a specific track at many times at once
+   *
+   * Equivalent to calling get_value_at_time_for_track() for each time, but walks the keyframe track
+   * with a cursor rather than searching it for every time, and seeds each bezier solve with the
+   * previous result. Intended for dense evaluation (e.g. once per audio sample during export).
+   * Times should be ascending for best performance, but any order will return correct values.
+   */
+  QVector<QVariant> get_values_at_times_for_track(const QVector<rational>& times, int track) const;
+
+  /**
+   * @brief Dense equivalent of get_split_values_at_time(), see get_values_at_times_for_track()
+   */
+  QVector<QVector<QVariant> > get_split_values_at_times(const QVector<rational>& times) const;
+
+  /**
+   * @brief Dense equivalent of get_value_at_time(), see get_values_at_times_for_track()
+   */
+  QVector<QVariant> get_values_at_times(const QVector<rational>& times) const;
+
   /**
    * @brief Retrieve a list of keyframe objects for all tracks at a given time
    *
@@ -207,6 +227,14 @@ public:
    */
   bool is_static() const;
 
+  /**
+   * @brief Get the range around a time over which this input's own (unconnected) value stays the same
+   *
+   * The returned range always contains `time`. Its out point is exclusive. If the value changes immediately
+   * after `time`, a range of zero length at `time` is returned.
+   */
+  TimeRange get_time_invariant_range(const rational& time) const;
+
   /**
    * @brief Get non-keyframed value
    */
@@ -334,6 +362,21 @@ private:
    */
   int FindIndexOfKeyframeFromRawPtr(NodeKeyframe* raw_ptr) const;
 
+  /**
+   * @brief Binary search for the index of the last keyframe at or before a given time
+   *
+   * Returns -1 if all keyframes in the track are after this time.
+   */
+  static int FindIndexOfKeyframeBeforeTime(const KeyframeTrack& track, const rational& time);
+
+  /**
+   * @brief Interpolate the value between two adjacent keyframes at a time between them
+   *
+   * If `bezier_t` is provided, it's used as the starting guess for a cubic bezier solve and
+   * receives the solved T afterwards.
+   */
+  QVariant get_value_between_keyframes(const NodeKeyframePtr& before, const NodeKeyframePtr& after, const rational& time, double* bezier_t = nullptr) const;
+
   /**
    * @brief Internal insert function, automatically does an insertion sort based on the keyframe's time
    */
@@ -354,6 +397,20 @@ private:
    */
   TimeRange get_range_around_index(int index, int track) const;
 
+  /**
+   * @brief Determine the time range whose values differ between two versions of a keyframe track
+   *
+   * Keyframes shared at the start and end of both tracks are skipped, so only the span between the last
+   * common keyframe before the change and the first common keyframe after it is returned. Returns false if
+   * the tracks are identical.
+   */
+  static bool get_range_affected_by_track_change(const KeyframeTrack& old_track, const KeyframeTrack& new_track, TimeRange* range);
+
+  /**
+   * @brief Returns whether two keyframes would produce identical values
+   */
+  static bool keyframes_are_equal(const NodeKeyframePtr& a, const NodeKeyframePtr& b);
+
   /**
    * @brief Convenience function - equivalent to calling `emit ValueChanged(range.in(), range.out())`
    */
@@ -71,4 +71,10 @@ void TimeInput::Hash(QCryptographicHash &hash, const rational &time) const
   hash.addData(NodeParam::ValueToBytes(NodeParam::kRational, QVariant::fromValue(time)));
 }
 
+TimeRange TimeInput::GetTimeInvariantRange(const rational &time) const
+{
+  // Time is hashed so this node is never invariant
+  return TimeRange(time, time);
+}
+
 OLIVE_NAMESPACE_EXIT
@@ -42,6 +42,8 @@ public:
 
   virtual void Hash(QCryptographicHash& hash, const rational& time) const override;
 
+  virtual TimeRange GetTimeInvariantRange(const rational& time) const override;
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -405,10 +405,15 @@ void Node::Hash(QCryptographicHash &hash, const rational& time) const
 
           // Pixel aspect ratio
           hash.addData(reinterpret_cast<const char*>(&image_stream->pixel_aspect_ratio()), sizeof(rational));
+
+          // Proxy, frames decoded from it don't look exactly like the original
+          hash.addData(image_stream->proxy_filename().toUtf8());
+          hash.addData(QString::number(image_stream->proxy_divider()).toUtf8());
         }
 
-        // Footage timestamp
-        if (stream->type() == Stream::kVideo) {
+        // Footage timestamp (a still image is the same at every time so there's no need to hash it)
+        if (stream->type() == Stream::kVideo
+            && std::static_pointer_cast<VideoStream>(stream)->video_type() != VideoStream::kVideoTypeStill) {
           VideoStreamPtr video_stream = std::static_pointer_cast<VideoStream>(stream);
 
           int64_t video_ts = Timecode::time_to_timestamp(input_time, video_stream->timebase());
@@ -424,6 +429,53 @@ void Node::Hash(QCryptographicHash &hash, const rational& time) const
   }
 }
 
+TimeRange Node::GetTimeInvariantRange(const rational &time) const
+{
+  TimeRange range(RATIONAL_MIN, RATIONAL_MAX);
+
+  QList<NodeInput*> inputs = GetInputsToHash();
+
+  foreach (NodeInput* input, inputs) {
+    rational input_time = InputTimeAdjustment(input, TimeRange(time, time)).in();
+
+    TimeRange input_range;
+
+    if (input->is_connected()) {
+      input_range = input->get_connected_node()->GetTimeInvariantRange(input_time);
+    } else {
+      input_range = input->get_time_invariant_range(input_time);
+    }
+
+    // Footage timestamps are hashed for every frame of a video, so only stills are invariant
+    if (input->data_type() == NodeParam::kFootage) {
+      StreamPtr stream = input->get_standard_value().value<StreamPtr>();
+
+      if (stream
+          && stream->type() == Stream::kVideo
+          && std::static_pointer_cast<VideoStream>(stream)->video_type() != VideoStream::kVideoTypeStill) {
+        return TimeRange(time, time);
+      }
+    }
+
+    // Convert back from the input's time to ours
+    input_range = OutputTimeAdjustment(input, input_range);
+
+    if (time < input_range.in() || time >= input_range.out()) {
+      // Time adjustment didn't map cleanly (e.g. a frame hold), so don't assume anything
+      return TimeRange(time, time);
+    }
+
+    range = range.Intersected(input_range);
+
+    if (range.in() == range.out()) {
+      // Can't get any smaller than this
+      break;
+    }
+  }
+
+  return range;
+}
+
 void Node::CopyInputs(Node *source, Node *destination, bool include_connections)
 {
   Q_ASSERT(source->id() == destination->id());
@@ -423,6 +423,16 @@ public:
 
   virtual void Hash(QCryptographicHash& hash, const rational &time) const;
 
+  /**
+   * @brief Get the range around a time over which Hash() will produce the same result
+   *
+   * This allows callers to hash a node once and reuse the result for every time inside the returned range
+   * instead of re-traversing the graph for each frame. The returned range always contains `time` and its out
+   * point is exclusive. The default implementation intersects the invariant ranges of every input returned by
+   * GetInputsToHash(), so any subclass that adds time-dependent data in Hash() must override this too.
+   */
+  virtual TimeRange GetTimeInvariantRange(const rational& time) const;
+
 protected:
   void AddInput(NodeInput* input);
 
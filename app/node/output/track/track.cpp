@@ -431,6 +431,28 @@ void TrackOutput::Hash(QCryptographicHash &hash, const rational &time) const
   }
 }
 
+TimeRange TrackOutput::GetTimeInvariantRange(const rational &time) const
+{
+  if (IsMuted()) {
+    // A muted track never hashes anything
+    return TimeRange(RATIONAL_MIN, RATIONAL_MAX);
+  }
+
+  Block* b = BlockAtTime(time);
+
+  if (b) {
+    // Limit to the block, since the block at time will change after its out point
+    return b->GetTimeInvariantRange(time).Intersected(TimeRange(b->in(), b->out()));
+  }
+
+  if (time >= track_length()) {
+    // Nothing is hashed past the end of the track
+    return TimeRange(track_length(), RATIONAL_MAX);
+  }
+
+  return TimeRange(time, time);
+}
+
 void TrackOutput::SetMuted(bool e)
 {
   muted_input_->set_standard_value(e);
@@ -212,6 +212,8 @@ public:
 
   virtual void Hash(QCryptographicHash& hash, const rational &time) const override;
 
+  virtual TimeRange GetTimeInvariantRange(const rational &time) const override;
+
   AudioVisualWaveform& waveform()
   {
     return waveform_;
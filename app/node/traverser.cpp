@@ -20,6 +20,7 @@
 
 #include "traverser.h"
 
+#include "common/profiler.h"
 #include "node.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -76,7 +77,13 @@ NodeValueTable NodeTraverser::GenerateTable(const Node *n, const TimeRange& rang
   NodeValueDatabase database = GenerateDatabase(n, range);
 
   // By this point, the node should have all the inputs it needs to render correctly
-  NodeValueTable table = n->Value(database);
+  NodeValueTable table;
+
+  {
+    PROFILE_SCOPE_DETAIL("node", "Value", n->GetLabel().isEmpty() ? n->ShortName() : n->GetLabel());
+
+    table = n->Value(database);
+  }
 
   PostProcessTable(n, range, table);
 
@@ -215,6 +222,8 @@ void NodeTraverser::PostProcessTable(const Node *node, const TimeRange &range, N
       StreamPtr stream = v.data().value<StreamPtr>();
 
       if (stream->footage()->IsValid()) {
+        PROFILE_SCOPE_DETAIL("node", "ProcessVideoFootage", stream->footage()->name());
+
         QVariant value = ProcessVideoFootage(stream, range.in());
 
         if (!value.isNull()) {
@@ -225,6 +234,8 @@ void NodeTraverser::PostProcessTable(const Node *node, const TimeRange &range, N
 
     // Run shaders
     foreach (const NodeValue& v, shader_jobs_to_run) {
+      PROFILE_SCOPE_DETAIL("node", "ProcessShader", node->GetLabel().isEmpty() ? node->ShortName() : node->GetLabel());
+
       QVariant value = ProcessShader(node, range, v.data().value<ShaderJob>());
 
       if (!value.isNull()) {
@@ -234,6 +245,8 @@ void NodeTraverser::PostProcessTable(const Node *node, const TimeRange &range, N
 
     // Run generate jobs
     foreach (const NodeValue& v, generate_jobs_to_run) {
+      PROFILE_SCOPE_DETAIL("node", "GenerateFrame", node->GetLabel().isEmpty() ? node->ShortName() : node->GetLabel());
+
       QVariant value = ProcessFrameGeneration(node, v.data().value<GenerateJob>());
 
       if (!value.isNull()) {
@@ -247,6 +260,8 @@ void NodeTraverser::PostProcessTable(const Node *node, const TimeRange &range, N
     StreamPtr stream = v.data().value<StreamPtr>();
 
     if (stream->footage()->IsValid()) {
+      PROFILE_SCOPE_DETAIL("node", "ProcessAudioFootage", stream->footage()->name());
+
       QVariant value = ProcessAudioFootage(v.data().value<StreamPtr>(), range);
 
       if (!value.isNull()) {
@@ -257,6 +272,8 @@ void NodeTraverser::PostProcessTable(const Node *node, const TimeRange &range, N
 
   // Run any accelerated shader jobs
   foreach (const NodeValue& v, sample_jobs_to_run) {
+    PROFILE_SCOPE_DETAIL("node", "ProcessSamples", node->GetLabel().isEmpty() ? node->ShortName() : node->GetLabel());
+
     QVariant value = ProcessSamples(node, range, v.data().value<SampleJob>());
 
     if (!value.isNull()) {
@@ -90,6 +90,12 @@ void ScopePanel::SetReferenceBuffer(Frame *frame)
   waveform_view_->SetBuffer(frame);
 }
 
+void ScopePanel::SetReferenceTexture(OpenGLTexture *texture)
+{
+  histogram_->SetTexture(texture);
+  waveform_view_->SetTexture(texture);
+}
+
 void ScopePanel::SetColorManager(ColorManager *manager)
 {
   histogram_->ConnectColorManager(manager);
@@ -52,6 +52,8 @@ public:
 public slots:
   void SetReferenceBuffer(Frame* frame);
 
+  void SetReferenceTexture(OLIVE_NAMESPACE::OpenGLTexture* texture);
+
   void SetColorManager(ColorManager* manager);
 
 protected:
@@ -68,6 +68,18 @@ void Folder::Load(QXmlStreamReader *reader, XMLNodeData& xml_node_data, const QA
     } else if (reader->name() == QStringLiteral("footage")) {
       child = std::make_shared<Footage>();
     } else if (reader->name() == QStringLiteral("sequence")) {
+      quintptr ptr = reader->attributes().value(QStringLiteral("ptr")).toULongLong();
+
+      if (xml_node_data.preloaded_items.contains(ptr)) {
+        // This sequence has already been loaded from its own section
+        child = xml_node_data.preloaded_items.value(ptr);
+        xml_node_data.item_ptrs.insert(ptr, child.get());
+
+        add_child(child);
+        reader->skipCurrentElement();
+        continue;
+      }
+
       child = std::make_shared<Sequence>();
     } else {
       reader->skipCurrentElement();
@@ -80,6 +92,11 @@ void Folder::Load(QXmlStreamReader *reader, XMLNodeData& xml_node_data, const QA
 }
 
 void Folder::Save(QXmlStreamWriter *writer) const
+{
+  Save(writer, true);
+}
+
+void Folder::Save(QXmlStreamWriter *writer, bool include_sequence_graphs) const
 {
   writer->writeAttribute(QStringLiteral("name"), name());
 
@@ -89,17 +106,24 @@ void Folder::Save(QXmlStreamWriter *writer) const
     switch (child->type()) {
     case Item::kFootage:
       writer->writeStartElement(QStringLiteral("footage"));
+      child->Save(writer);
       break;
     case Item::kSequence:
       writer->writeStartElement(QStringLiteral("sequence"));
+
+      if (include_sequence_graphs) {
+        child->Save(writer);
+      } else {
+        writer->writeAttribute(QStringLiteral("name"), child->name());
+        writer->writeAttribute(QStringLiteral("ptr"), QString::number(reinterpret_cast<quintptr>(static_cast<Sequence*>(child.get()))));
+      }
       break;
     case Item::kFolder:
       writer->writeStartElement(QStringLiteral("folder"));
+      std::static_pointer_cast<Folder>(child)->Save(writer, include_sequence_graphs);
       break;
     }
 
-    child->Save(writer);
-
     writer->writeEndElement(); // footage/folder/sequence
   }
 }
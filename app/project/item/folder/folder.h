@@ -48,6 +48,13 @@ public:
 
   virtual void Save(QXmlStreamWriter* writer) const override;
 
+  /**
+   * @brief Save the folder, optionally leaving out the node graphs of any sequences in it
+   *
+   * Without graphs, sequences are written with only enough to place them in the tree.
+   */
+  void Save(QXmlStreamWriter* writer, bool include_sequence_graphs) const;
+
 private:
 
 };
@@ -22,6 +22,7 @@
 
 #include <QFile>
 
+#include "codec/decoder.h"
 #include "common/timecodefunctions.h"
 #include "common/xmlutils.h"
 #include "footage.h"
@@ -35,7 +36,9 @@ VideoStream::VideoStream() :
   interlacing_(VideoParams::kInterlaceNone),
   video_type_(VideoStream::kVideoTypeVideo),
   pixel_aspect_ratio_(1),
-  start_time_(0)
+  start_time_(0),
+  proxy_divider_(0),
+  proxy_probed_(false)
 {
   set_type(Stream::kVideo);
 }
@@ -79,6 +82,83 @@ int64_t VideoStream::get_time_in_timebase_units(const rational &time) const
   return Timecode::time_to_timestamp(time, timebase()) + start_time();
 }
 
+void VideoStream::set_proxy(const QString &filename, int divider)
+{
+  {
+    QMutexLocker locker(proxy_access_lock());
+
+    proxy_filename_ = filename;
+    proxy_divider_ = filename.isEmpty() ? 0 : divider;
+
+    // Probe the new file next time it's needed
+    proxy_footage_ = nullptr;
+    proxy_probed_ = false;
+  }
+
+  // Frames already rendered from the original (or a previous proxy) no longer match
+  emit ParametersChanged();
+}
+
+QString VideoStream::proxy_filename()
+{
+  QMutexLocker locker(proxy_access_lock());
+
+  return proxy_filename_;
+}
+
+int VideoStream::proxy_divider()
+{
+  QMutexLocker locker(proxy_access_lock());
+
+  return proxy_divider_;
+}
+
+VideoStreamPtr VideoStream::proxy_stream()
+{
+  QMutexLocker locker(proxy_access_lock());
+
+  if (proxy_filename_.isEmpty()) {
+    return nullptr;
+  }
+
+  if (!proxy_probed_) {
+    // Only try once, if the proxy is missing we don't want to hit the disk on every frame
+    proxy_probed_ = true;
+
+    QString filename = proxy_filename_;
+
+    // Probing can take a while, so don't hold up every other thread asking for this stream's proxy
+    // in the meantime. They'll use the original until the probe finishes.
+    locker.unlock();
+
+    FootagePtr f = Decoder::ProbeMedia(footage()->project(), filename, nullptr);
+
+    locker.relock();
+
+    if (proxy_filename_ != filename || proxy_footage_) {
+      // The proxy was changed while we were probing, the new one will be probed on the next call
+    } else if (f && f->get_first_stream_of_type(Stream::kVideo)) {
+      VideoStreamPtr vs = std::static_pointer_cast<VideoStream>(f->get_first_stream_of_type(Stream::kVideo));
+
+      // The proxy was transcoded from this stream, so it should be interpreted the same way
+      vs->set_colorspace(colorspace(false));
+      vs->set_premultiplied_alpha(premultiplied_alpha_);
+      vs->set_interlacing(interlacing_);
+      vs->set_pixel_aspect_ratio(pixel_aspect_ratio_);
+
+      proxy_footage_ = f;
+    } else {
+      qWarning() << "Failed to open proxy" << filename << "for" << footage()->filename();
+    }
+  }
+
+  if (proxy_footage_) {
+    return std::static_pointer_cast<VideoStream>(proxy_footage_->get_first_stream_of_type(Stream::kVideo));
+  }
+
+  return nullptr;
+}
+
 QIcon VideoStream::icon() const
 {
   if (video_type_ == kVideoTypeStill) {
@@ -111,6 +191,14 @@ void VideoStream::LoadCustomParameters(QXmlStreamReader *reader)
       set_frame_rate(rational::fromString(reader->readElementText()));
     } else if (reader->name() == QStringLiteral("starttime")) {
       set_start_time(reader->readElementText().toLongLong());
+    } else if (reader->name() == QStringLiteral("proxy")) {
+      XMLAttributeLoop(reader, attr) {
+        if (attr.name() == QStringLiteral("divider")) {
+          proxy_divider_ = attr.value().toInt();
+        }
+      }
+
+      proxy_filename_ = reader->readElementText();
     } else {
       reader->skipCurrentElement();
     }
@@ -129,6 +217,13 @@ void VideoStream::SaveCustomParameters(QXmlStreamWriter *writer) const
   writer->writeTextElement(QStringLiteral("pixelaspect"), pixel_aspect_ratio_.toString());
   writer->writeTextElement(QStringLiteral("framerate"), frame_rate_.toString());
   writer->writeTextElement(QStringLiteral("starttime"), QString::number(start_time_));
+
+  if (!proxy_filename_.isEmpty()) {
+    writer->writeStartElement(QStringLiteral("proxy"));
+    writer->writeAttribute(QStringLiteral("divider"), QString::number(proxy_divider_));
+    writer->writeCharacters(proxy_filename_);
+    writer->writeEndElement(); // proxy
+  }
 }
 
 bool VideoStream::premultiplied_alpha() const
@@ -21,12 +21,17 @@
 #ifndef VIDEOSTREAM_H
 #define VIDEOSTREAM_H
 
+#include <memory>
+
 #include "render/pixelformat.h"
 #include "render/videoparams.h"
 #include "stream.h"
 
 OLIVE_NAMESPACE_ENTER
 
+class VideoStream;
+using VideoStreamPtr = std::shared_ptr<VideoStream>;
+
 /**
  * @brief A Stream derivative containing video-specific information
  */
@@ -134,6 +139,25 @@ public:
 
   int64_t get_time_in_timebase_units(const rational& time) const;
 
+  /**
+   * @brief Link a low resolution proxy of this stream
+   *
+   * `divider` is how many times smaller the proxy's dimensions are than this stream's. Pass an
+   * empty filename to remove the proxy. Thread-safe.
+   */
+  void set_proxy(const QString& filename, int divider);
+
+  QString proxy_filename();
+
+  int proxy_divider();
+
+  /**
+   * @brief Returns a stream that can be decoded in place of this one, or nullptr if there's no usable proxy
+   *
+   * The proxy file is probed the first time this is called after a proxy is linked. Thread-safe.
+   */
+  VideoStreamPtr proxy_stream();
+
   virtual QIcon icon() const override;
 
 public slots:
@@ -163,9 +187,15 @@ private:
 
   int64_t start_time_;
 
-};
+  QString proxy_filename_;
 
-using VideoStreamPtr = std::shared_ptr<VideoStream>;
+  int proxy_divider_;
+
+  std::shared_ptr<Footage> proxy_footage_;
+
+  bool proxy_probed_;
+
+};
 
 OLIVE_NAMESPACE_EXIT
 
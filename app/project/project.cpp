@@ -47,6 +47,11 @@ void Project::Load(QXmlStreamReader *reader, MainWindowLayoutInfo* layout, const
 {
   XMLNodeData xml_node_data;
 
+  Load(reader, xml_node_data, layout, cancelled);
+}
+
+void Project::Load(QXmlStreamReader *reader, XMLNodeData &xml_node_data, MainWindowLayoutInfo *layout, const QAtomicInt *cancelled)
+{
   while (XMLReadNextStartElement(reader)) {
     if (reader->name() == QStringLiteral("root")) {
 
@@ -93,12 +98,12 @@ void Project::Load(QXmlStreamReader *reader, MainWindowLayoutInfo* layout, const
   }
 }
 
-void Project::Save(QXmlStreamWriter *writer) const
+void Project::Save(QXmlStreamWriter *writer, bool include_sequence_graphs) const
 {
   writer->writeTextElement(QStringLiteral("cachepath"), cache_path(false));
 
   writer->writeStartElement(QStringLiteral("root"));
-  root_.Save(writer);
+  root_.Save(writer, include_sequence_graphs);
   writer->writeEndElement();
 
   writer->writeStartElement(QStringLiteral("colormanagement"));
@@ -49,7 +49,15 @@ public:
 
   void Load(QXmlStreamReader* reader, MainWindowLayoutInfo *layout, const QAtomicInt* cancelled);
 
-  void Save(QXmlStreamWriter* writer) const;
+  /**
+   * @brief Load using existing XML data, e.g. to place sequences that were loaded separately
+   */
+  void Load(QXmlStreamReader* reader, XMLNodeData& xml_node_data, MainWindowLayoutInfo *layout, const QAtomicInt* cancelled);
+
+  /**
+   * @brief Save the project, see Folder::Save() for `include_sequence_graphs`
+   */
+  void Save(QXmlStreamWriter* writer, bool include_sequence_graphs = true) const;
 
   Folder* root();
 
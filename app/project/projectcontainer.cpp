@@ -0,0 +1,165 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "projectcontainer.h"
+
+#include <QDataStream>
+#include <QFile>
+
+OLIVE_NAMESPACE_ENTER
+
+// "OVEB", followed by a version number
+const quint32 ProjectContainer::kMagic = 0x4F564542;
+const quint32 ProjectContainer::kVersion = 1;
+
+bool ProjectContainer::IsContainer(const QString &filename)
+{
+  QFile file(filename);
+
+  if (!file.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream ds(&file);
+  ds.setVersion(QDataStream::Qt_5_6);
+
+  quint32 magic;
+  ds >> magic;
+
+  return ds.status() == QDataStream::Ok && magic == kMagic;
+}
+
+QByteArray ProjectContainer::PackSection(const QByteArray &xml)
+{
+  return qCompress(xml);
+}
+
+bool ProjectContainer::Write(QIODevice *device, uint project_version, const QString &url,
+                             QVector<Section> sections, const QVector<QByteArray> &data)
+{
+  Q_ASSERT(sections.size() == data.size());
+
+  // Offsets are relative to the end of the table of contents until we know how big it is
+  qint64 offset = 0;
+
+  for (int i=0;i<sections.size();i++) {
+    sections[i].offset = offset;
+    sections[i].size = data.at(i).size();
+
+    offset += sections.at(i).size;
+  }
+
+  QDataStream ds(device);
+  ds.setVersion(QDataStream::Qt_5_6);
+
+  ds << kMagic << kVersion << quint32(project_version) << url << quint32(sections.size());
+
+  foreach (const Section& s, sections) {
+    ds << quint32(s.type) << s.id << s.offset << s.size;
+  }
+
+  foreach (const QByteArray& d, data) {
+    if (device->write(d) != d.size()) {
+      return false;
+    }
+  }
+
+  return ds.status() == QDataStream::Ok;
+}
+
+bool ProjectContainer::ReadHeader(QIODevice *device, Header *header)
+{
+  QDataStream ds(device);
+  ds.setVersion(QDataStream::Qt_5_6);
+
+  quint32 magic, version, project_version, section_count;
+  ds >> magic >> version;
+
+  if (ds.status() != QDataStream::Ok || magic != kMagic || version != kVersion) {
+    return false;
+  }
+
+  ds >> project_version >> header->url >> section_count;
+
+  if (ds.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  // Each table of contents entry is a quint32 type, a quint64 ID, and a qint64 offset and size.
+  // Check the count against what's left of the file before allocating, so a corrupt count can't
+  // make us allocate gigabytes.
+  const qint64 entry_size = sizeof(quint32) + sizeof(quint64) + sizeof(qint64) + sizeof(qint64);
+
+  if (qint64(section_count) > (device->size() - device->pos()) / entry_size) {
+    return false;
+  }
+
+  header->project_version = project_version;
+  header->sections.resize(section_count);
+
+  for (quint32 i=0;i<section_count;i++) {
+    Section& s = header->sections[i];
+    quint32 type;
+
+    ds >> type >> s.id >> s.offset >> s.size;
+
+    s.type = static_cast<SectionType>(type);
+  }
+
+  if (ds.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  // Make offsets absolute now that we're at the end of the table of contents
+  qint64 data_start = device->pos();
+  qint64 data_size = device->size() - data_start;
+
+  for (int i=0;i<header->sections.size();i++) {
+    Section& s = header->sections[i];
+
+    // Written this way so a corrupt offset or size can't overflow
+    if (s.offset < 0 || s.size < 0 || s.offset > data_size || s.size > data_size - s.offset) {
+      return false;
+    }
+
+    s.offset += data_start;
+  }
+
+  return true;
+}
+
+QByteArray ProjectContainer::ReadSection(const QString &filename, const Section &section)
+{
+  QFile file(filename);
+
+  if (!file.open(QFile::ReadOnly) || !file.seek(section.offset)) {
+    return QByteArray();
+  }
+
+  QByteArray packed = file.read(section.size);
+
+  if (packed.size() != section.size) {
+    return QByteArray();
+  }
+
+  return qUncompress(packed);
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,105 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROJECTCONTAINER_H
+#define PROJECTCONTAINER_H
+
+#include <QIODevice>
+#include <QVector>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Binary project file made of independently readable sections
+ *
+ * The file starts with a header and a table of contents, followed by each section's data. Each
+ * sequence's node graph is stored in its own section and the project's folder structure, footage
+ * and layout in another, so sequences can be serialized and parsed in parallel and any one section
+ * can be read without reading the rest of the file.
+ *
+ * Sections contain the same XML the regular project format uses, compressed with qCompress().
+ */
+class ProjectContainer
+{
+public:
+  enum SectionType {
+    kProjectSection,
+    kSequenceSection
+  };
+
+  struct Section {
+    SectionType type;
+
+    // For sequence sections, the "ptr" the sequence was saved with
+    quint64 id;
+
+    // Location of the section's data from the start of the file
+    qint64 offset;
+    qint64 size;
+  };
+
+  struct Header {
+    uint project_version;
+    QString url;
+    QVector<Section> sections;
+  };
+
+  /**
+   * @brief Returns true if this file is a binary project rather than an XML one
+   */
+  static bool IsContainer(const QString& filename);
+
+  /**
+   * @brief Compress a section's XML ready for Write()
+   *
+   * Thread-safe, so sections can be packed in parallel.
+   */
+  static QByteArray PackSection(const QByteArray& xml);
+
+  /**
+   * @brief Write a container with these sections, `data` being the packed data for each section
+   *
+   * The offset and size of each section are filled in here.
+   */
+  static bool Write(QIODevice* device, uint project_version, const QString& url,
+                    QVector<Section> sections, const QVector<QByteArray>& data);
+
+  static bool ReadHeader(QIODevice* device, Header* header);
+
+  /**
+   * @brief Read and uncompress a single section's XML
+   *
+   * Opens the file separately, so it's safe to read several sections from different threads at once.
+   * Returns an empty QByteArray on failure.
+   */
+  static QByteArray ReadSection(const QString& filename, const Section& section);
+
+private:
+  static const quint32 kMagic;
+
+  static const quint32 kVersion;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // PROJECTCONTAINER_H
@@ -26,6 +26,8 @@
 
 #include "core.h"
 #include "node/input/media/media.h"
+#include "project/item/footage/footage.h"
+#include "render/thumbnailcache.h"
 
 OLIVE_NAMESPACE_ENTER
 
@@ -142,6 +144,20 @@ QVariant ProjectViewModel::data(const QModelIndex &index, int role) const
   case Qt::DecorationRole:
     // If this is the first column, return the Item's icon
     if (column_type == kName) {
+      if (internal_item->type() == Item::kFootage && ThumbnailCache::instance()) {
+        // Show a poster frame for anything with video once one is available
+        Footage* footage = static_cast<Footage*>(internal_item);
+        StreamPtr video_stream = footage->IsValid() ? footage->get_first_stream_of_type(Stream::kVideo) : nullptr;
+
+        if (video_stream) {
+          QImage poster = ThumbnailCache::instance()->GetPosterFrame(std::static_pointer_cast<VideoStream>(video_stream));
+
+          if (!poster.isNull()) {
+            return QIcon(QPixmap::fromImage(poster));
+          }
+        }
+      }
+
       return internal_item->icon();
     }
     break;
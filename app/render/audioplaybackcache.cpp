@@ -20,9 +20,11 @@
 
 #include "audioplaybackcache.h"
 
+#include <algorithm>
 #include <QDir>
 #include <QFile>
 #include <QUuid>
+#include <QtConcurrent/QtConcurrent>
 
 #include "common/filefunctions.h"
 
@@ -30,6 +32,8 @@ OLIVE_NAMESPACE_ENTER
 
 const qint64 AudioPlaybackCache::kDefaultSegmentSize = 5242880;
 
+QAtomicInt AudioPlaybackCache::PlaybackDevice::total_xrun_count_;
+
 AudioPlaybackCache::AudioPlaybackCache(QObject* parent) :
   PlaybackCache(parent)
 {
@@ -90,8 +94,14 @@ void AudioPlaybackCache::WritePCM(const TimeRange &range, SampleBufferPtr sample
       rational this_segment_out = this_segment_in + params_.bytes_to_time((*it).size());
 
       if (r.in() < this_segment_out) {
+        // Silent segments get a file the first time anything is written to them
+        if (!(*it).file()) {
+          (*it).set_file(CreateSegmentFile((*it).size()));
+          (*it).set_file_offset(0);
+        }
+
         // We'll write at least something to this segment
-        QFile seg_file((*it).filename());
+        QFile seg_file((*it).file()->filename());
 
         if (seg_file.open(QFile::ReadWrite)) {
           // Calculate how much to write
@@ -112,7 +122,7 @@ void AudioPlaybackCache::WritePCM(const TimeRange &range, SampleBufferPtr sample
           qint64 possible_write_length = qMin(qMax(qint64(0), a.size() - src_offset), total_write_length);
 
           // Seek to our start offset
-          seg_file.seek(dst_offset);
+          seg_file.seek((*it).file_offset() + dst_offset);
 
           // If we have source bytes to write, write them here
           if (possible_write_length > 0) {
@@ -182,8 +192,8 @@ void AudioPlaybackCache::ShiftEvent(const rational &from_in_time, const rational
       insert_index = from_index + 1;
 
       if (from < from_end) {
-        // Split from segment into two
-        Segment second = CloneSegment(playlist_.at(from_index));
+        // Split from segment into two, both referencing the same file
+        Segment second = playlist_.at(from_index);
 
         TrimSegmentOut(&playlist_[from_index], from - from_start);
         TrimSegmentIn(&second, from_end - from);
@@ -198,8 +208,7 @@ void AudioPlaybackCache::ShiftEvent(const rational &from_in_time, const rational
     while (time_to_insert) {
       qint64 new_seg_sz = qMin(kDefaultSegmentSize, time_to_insert);
 
-      // Set offset to 0 for now and fill it in later
-      playlist_.insert(insert_index, CreateSegment(new_seg_sz, 0));
+      playlist_.insert(insert_index, CreateSilentSegment(new_seg_sz));
 
       time_to_insert -= new_seg_sz;
     }
@@ -215,7 +224,7 @@ void AudioPlaybackCache::ShiftEvent(const rational &from_in_time, const rational
       // Shift occurs in the same segment
       if (to > to_start && from < to_end) {
         // Split into two and process as normal
-        Segment second = CloneSegment(playlist_.at(to_index));
+        Segment second = playlist_.at(to_index);
         from_index++;
         playlist_.insert(from_index, second);
       } else if (to == to_start && from == to_end) {
@@ -252,6 +261,8 @@ void AudioPlaybackCache::ShiftEvent(const rational &from_in_time, const rational
 
     UpdateOffsetsFrom(to_index);
   }
+
+  CollectGarbage();
 }
 
 void AudioPlaybackCache::LengthChangedEvent(const rational& old, const rational& newlen)
@@ -277,34 +288,43 @@ void AudioPlaybackCache::LengthChangedEvent(const rational& old, const rational&
       RemoveSegmentFromArray(playlist_.size() - 1);
     }
   }
+
+  CollectGarbage();
 }
 
-AudioPlaybackCache::Segment AudioPlaybackCache::CloneSegment(const AudioPlaybackCache::Segment &s) const
+AudioPlaybackCache::Segment AudioPlaybackCache::CreateSegment(const qint64 &size, const qint64& offset)
 {
-  Segment new_seg = s;
-
-  // Copy data to a new file
-  QString new_filename = GenerateSegmentFilename();
-  QFile::copy(s.filename(), new_filename);
+  Segment s(size, CreateSegmentFile(size));
 
-  new_seg.set_filename(new_filename);
+  s.set_offset(offset);
 
-  return new_seg;
+  return s;
 }
 
-AudioPlaybackCache::Segment AudioPlaybackCache::CreateSegment(const qint64 &size, const qint64& offset) const
+AudioPlaybackCache::Segment AudioPlaybackCache::CreateSilentSegment(const qint64 &size)
 {
-  Segment s(size, GenerateSegmentFilename());
+  // Set offset to 0 for now, it's expected to be filled in later by UpdateOffsetsFrom()
+  Segment s(size, nullptr);
 
-  s.set_offset(offset);
+  s.set_offset(0);
 
-  // Create empty file
-  QFile f(s.filename());
+  return s;
+}
+
+AudioPlaybackCache::SegmentFilePtr AudioPlaybackCache::CreateSegmentFile(const qint64 &size)
+{
+  SegmentFilePtr file = std::make_shared<SegmentFile>(GenerateSegmentFilename());
+
+  // Create silent file at full size so it never has to grow while a PlaybackDevice has it mapped
+  QFile f(file->filename());
   if (f.open(QFile::WriteOnly)) {
+    f.resize(size);
     f.close();
   }
 
-  return s;
+  files_.append(file);
+
+  return file;
 }
 
 QString AudioPlaybackCache::GenerateSegmentFilename() const
@@ -321,24 +341,8 @@ QString AudioPlaybackCache::GenerateSegmentFilename() const
 
 void AudioPlaybackCache::TrimSegmentIn(AudioPlaybackCache::Segment *s, qint64 new_length)
 {
-  // Read filename
-  QFile f(s->filename());
-  if (f.open(QFile::ReadWrite)) {
-    // Read whole segment into memory
-    QByteArray data = f.readAll();
-
-    // Trim to new length
-    data = data.right(new_length);
-
-    // Seek to start and write
-    f.seek(0);
-
-    // Write trimmed data
-    f.write(data);
-
-    f.close();
-  }
-
+  // Skip over the start of the segment's data rather than rewriting its file
+  s->set_file_offset(s->file_offset() + s->size() - new_length);
   s->set_size(new_length);
 }
 
@@ -349,18 +353,41 @@ void AudioPlaybackCache::TrimSegmentOut(AudioPlaybackCache::Segment *s, qint64 n
 
 void AudioPlaybackCache::RemoveSegmentFromArray(int index)
 {
-  QFile::remove(playlist_.at(index).filename());
+  // Other segments may still reference this file, so it's left for CollectGarbage() to delete
   playlist_.removeAt(index);
 }
 
 void AudioPlaybackCache::ClearPlaylist()
 {
-  foreach (const Segment& s, playlist_) {
-    QFile::remove(s.filename());
+  foreach (SegmentFilePtr f, files_) {
+    QFile::remove(f->filename());
   }
+  files_.clear();
   playlist_.clear();
 }
 
+void AudioPlaybackCache::CollectGarbage()
+{
+  QStringList unreferenced;
+
+  for (int i=0; i<files_.size(); i++) {
+    // If we hold the only reference, neither the playlist nor any PlaybackDevice uses this file
+    if (files_.at(i).use_count() == 1) {
+      unreferenced.append(files_.at(i)->filename());
+      files_.removeAt(i);
+      i--;
+    }
+  }
+
+  if (!unreferenced.isEmpty()) {
+    QtConcurrent::run([unreferenced]{
+      foreach (const QString& fn, unreferenced) {
+        QFile::remove(fn);
+      }
+    });
+  }
+}
+
 void AudioPlaybackCache::UpdateOffsetsFrom(int index)
 {
   qint64 current_offset;
@@ -399,18 +426,33 @@ QList<TimeRange> AudioPlaybackCache::GetValidRanges(const TimeRange& range, cons
 
 AudioPlaybackCache::PlaybackDevice *AudioPlaybackCache::CreatePlaybackDevice(QObject* parent) const
 {
-  return new PlaybackDevice(playlist_, parent);
+  // Snapshot what isn't cached right now so the device can tell an underrun from real silence.
+  // Segment files are allocated at full size up front, so the mapped data alone can't tell us.
+  QVector<PlaybackDevice::ByteRange> unavailable;
+
+  foreach (const TimeRange& r, GetInvalidatedRanges()) {
+    unavailable.append({params_.time_to_bytes(r.in()), params_.time_to_bytes(r.out())});
+  }
+
+  std::sort(unavailable.begin(), unavailable.end(), [](const PlaybackDevice::ByteRange& a, const PlaybackDevice::ByteRange& b){
+    return a.in < b.in;
+  });
+
+  return new PlaybackDevice(playlist_, unavailable, parent);
 }
 
-AudioPlaybackCache::Segment::Segment(qint64 size, const QString &filename)
+AudioPlaybackCache::Segment::Segment(qint64 size, SegmentFilePtr file)
 {
   size_ = size;
-  filename_ = filename;
+  file_ = file;
+  offset_ = 0;
+  file_offset_ = 0;
 }
 
-AudioPlaybackCache::PlaybackDevice::PlaybackDevice(const AudioPlaybackCache::Playlist &playlist, QObject *parent) :
+AudioPlaybackCache::PlaybackDevice::PlaybackDevice(const AudioPlaybackCache::Playlist &playlist, const QVector<ByteRange> &unavailable, QObject *parent) :
   QIODevice(parent),
   playlist_(playlist),
+  unavailable_(unavailable),
   current_segment_(0),
   segment_read_index_(0)
 {
@@ -421,6 +463,68 @@ AudioPlaybackCache::PlaybackDevice::~PlaybackDevice()
   close();
 }
 
+bool AudioPlaybackCache::PlaybackDevice::open(QIODevice::OpenMode mode)
+{
+  // Map every segment up front so readData() never has to touch the file system
+  mapped_segments_.resize(playlist_.size());
+
+  for (int i=0; i<playlist_.size(); i++) {
+    const Segment& s = playlist_.at(i);
+    MappedSegment& m = mapped_segments_[i];
+
+    m.file = nullptr;
+    m.data = nullptr;
+    m.size = 0;
+    m.silent = !s.file();
+
+    if (m.silent) {
+      continue;
+    }
+
+    m.file = new QFile(s.file()->filename());
+
+    if (m.file->open(QFile::ReadOnly)) {
+      qint64 map_sz = qMin(m.file->size() - s.file_offset(), s.size());
+
+      if (map_sz > 0) {
+        m.data = reinterpret_cast<const char*>(m.file->map(s.file_offset(), map_sz));
+
+        if (m.data) {
+          m.size = map_sz;
+        } else {
+          qWarning() << "Failed to map audio segment" << m.file->fileName();
+        }
+      }
+
+      // The mapping stays valid after the file is closed, so don't hold a file descriptor open
+      // for every segment of a long sequence
+      m.file->close();
+    } else {
+      qWarning() << "Failed to open audio segment" << m.file->fileName();
+    }
+  }
+
+  // Reads are a straight copy from the maps, so QIODevice's own buffering would only add
+  // allocations on the audio thread
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void AudioPlaybackCache::PlaybackDevice::close()
+{
+  if (isOpen() && xrun_count() > 0) {
+    qWarning() << "Audio playback reached uncached audio" << xrun_count() << "times";
+  }
+
+  QIODevice::close();
+
+  foreach (const MappedSegment& m, mapped_segments_) {
+    // Destroying the file also unmaps it
+    delete m.file;
+  }
+
+  mapped_segments_.clear();
+}
+
 bool AudioPlaybackCache::PlaybackDevice::seek(qint64 pos)
 {
   // Default behavior
@@ -440,45 +544,70 @@ bool AudioPlaybackCache::PlaybackDevice::seek(qint64 pos)
   return true;
 }
 
+bool AudioPlaybackCache::PlaybackDevice::IsUnavailable(qint64 in, qint64 out) const
+{
+  foreach (const ByteRange& r, unavailable_) {
+    if (r.in >= out) {
+      // Sorted, so nothing after this can overlap either
+      break;
+    }
+
+    if (r.out > in) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 qint64 AudioPlaybackCache::PlaybackDevice::readData(char *data, qint64 maxSize)
 {
   qint64 read_size = 0;
+  bool underrun = false;
+
+  if (current_segment_ >= 0 && current_segment_ < playlist_.size()) {
+    qint64 read_start = playlist_.at(current_segment_).offset() + segment_read_index_;
+
+    underrun = IsUnavailable(read_start, read_start + maxSize);
+  }
 
   while (read_size < maxSize
          && current_segment_ >= 0
          && current_segment_ < playlist_.size()) {
-    const Segment& cs = playlist_.at(current_segment_);
-    qint64 current_segment_sz = cs.size();
-    QFile segment_file(cs.filename());
+    qint64 current_segment_sz = playlist_.at(current_segment_).size();
+    const MappedSegment& ms = mapped_segments_.at(current_segment_);
 
-    if (segment_file.open(QFile::ReadOnly)) {
-      // Seek to our stored index of this segment
-      segment_file.seek(segment_read_index_);
+    // Determine how many bytes to read
+    qint64 this_read_length = qMin(current_segment_sz - segment_read_index_,
+                                   maxSize - read_size);
 
-      // Determine how many bytes to read
-      qint64 this_read_length = qMin(current_segment_sz - segment_read_index_,
-                                     maxSize - read_size);
+    // Copy whatever is mapped, anything beyond that is unavailable and filled with silence
+    qint64 mapped_length = qBound(qint64(0), ms.size - segment_read_index_, this_read_length);
 
-      // Read those bytes
-      segment_file.read(data + read_size, this_read_length);
+    if (mapped_length > 0) {
+      memcpy(data + read_size, ms.data + segment_read_index_, mapped_length);
+    }
 
-      // Close the file
-      segment_file.close();
+    if (mapped_length < this_read_length) {
+      memset(data + read_size + mapped_length, 0, this_read_length - mapped_length);
+
+      // Segment failed to open or map
+      if (!ms.silent) {
+        underrun = true;
+      }
+    }
 
-      // Add to the read index
-      segment_read_index_ += this_read_length;
+    // Add to the read index
+    segment_read_index_ += this_read_length;
 
-      // Add to the read size
-      read_size += this_read_length;
+    // Add to the read size
+    read_size += this_read_length;
 
-      // If we've reached the end of this segment, tick the counter over to the next segment
-      if (segment_read_index_ == current_segment_sz) {
-        // Jump to the next file
-        segment_read_index_ = 0;
-        current_segment_++;
-      }
-    } else {
-      qWarning() << "Failed to read data from segment";
+    // If we've reached the end of this segment, tick the counter over to the next segment
+    if (segment_read_index_ == current_segment_sz) {
+      // Jump to the next file
+      segment_read_index_ = 0;
+      current_segment_++;
     }
   }
 
@@ -487,6 +616,11 @@ qint64 AudioPlaybackCache::PlaybackDevice::readData(char *data, qint64 maxSize)
     memset(data + read_size, 0, maxSize - read_size);
   }
 
+  if (underrun) {
+    xrun_count_.fetchAndAddRelaxed(1);
+    total_xrun_count_.fetchAndAddRelaxed(1);
+  }
+
   //return read_size;
   return maxSize;
 }
@@ -21,6 +21,10 @@
 #ifndef AUDIOPLAYBACKCACHE_H
 #define AUDIOPLAYBACKCACHE_H
 
+#include <memory>
+#include <QAtomicInt>
+#include <QFile>
+
 #include "common/timerange.h"
 #include "codec/samplebuffer.h"
 #include "render/playbackcache.h"
@@ -45,6 +49,12 @@ OLIVE_NAMESPACE_ENTER
  * operations like shifting much easier since segments can simply be removed from the playlist
  * rather than having to shift or re-render potentially hours of audio in every operation.
  *
+ * Segments are extents that reference a region of a file on disk, and several segments may share
+ * one file, so splitting and trimming segments during a shift only edits the playlist and never
+ * copies PCM data. Segments inserted by a shift reference no file at all and are silent until
+ * something is written to them. Files that no segment references anymore are deleted in the
+ * background.
+ *
  * Naturally, storing in segments means you can't simply play the PCM data like a file, so
  * AudioPlaybackCache also provides a playback device (accessible from CreatePlaybackDevice()) that
  * acts identically to a file-based IO device, transparently joining segments together and acting
@@ -71,11 +81,34 @@ public:
 
   QList<TimeRange> GetValidRanges(const TimeRange &range, const qint64 &job_time);
 
+  /**
+   * @brief A PCM file on disk that one or more Segments reference a region of
+   */
+  class SegmentFile
+  {
+  public:
+    SegmentFile(const QString& filename) :
+      filename_(filename)
+    {
+    }
+
+    const QString& filename() const
+    {
+      return filename_;
+    }
+
+  private:
+    QString filename_;
+
+  };
+
+  using SegmentFilePtr = std::shared_ptr<SegmentFile>;
+
   class Segment
   {
   public:
     Segment() = default;
-    Segment(qint64 size, const QString& filename);
+    Segment(qint64 size, SegmentFilePtr file);
 
     qint64 size() const
     {
@@ -97,14 +130,30 @@ public:
       offset_ = o;
     }
 
-    const QString& filename() const
+    /**
+     * @brief File this segment's data is stored in, or nullptr if this segment is silent
+     */
+    SegmentFilePtr file() const
     {
-      return filename_;
+      return file_;
+    }
+
+    void set_file(SegmentFilePtr file)
+    {
+      file_ = file;
     }
 
-    void set_filename(const QString& filename)
+    /**
+     * @brief Where this segment's data starts in its file
+     */
+    qint64 file_offset() const
     {
-      filename_ = filename;
+      return file_offset_;
+    }
+
+    void set_file_offset(qint64 o)
+    {
+      file_offset_ = o;
     }
 
     qint64 end() const
@@ -113,12 +162,14 @@ public:
     }
 
   private:
-    QString filename_;
+    SegmentFilePtr file_;
 
     qint64 size_;
 
     qint64 offset_;
 
+    qint64 file_offset_;
+
   };
 
   class Playlist : public QVector<Segment>
@@ -132,13 +183,39 @@ public:
 
   };
 
+  /**
+   * @brief QIODevice that reads the segments of a Playlist as if they were one contiguous file
+   *
+   * All segments are memory mapped when the device is opened, so readData() (which is called from
+   * the audio output thread) is just a memcpy and never makes a syscall or allocates memory.
+   */
   class PlaybackDevice : public QIODevice
   {
   public:
-    PlaybackDevice(const Playlist& playlist, QObject* parent = nullptr);
+    /**
+     * @brief A range of bytes in the playlist [in, out)
+     */
+    struct ByteRange {
+      qint64 in;
+      qint64 out;
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param unavailable
+     *
+     * Byte ranges that haven't been cached (yet), sorted by position. Reads that touch them are
+     * counted as underruns.
+     */
+    PlaybackDevice(const Playlist& playlist, const QVector<ByteRange>& unavailable, QObject* parent = nullptr);
 
     virtual ~PlaybackDevice() override;
 
+    virtual bool open(OpenMode mode) override;
+
+    virtual void close() override;
+
     virtual bool isSequential() const override
     {
       return false;
@@ -161,13 +238,46 @@ public:
       return -1;
     }
 
+    /**
+     * @brief Number of reads from this device that hit audio that wasn't cached
+     */
+    int xrun_count() const
+    {
+      return xrun_count_;
+    }
+
+    /**
+     * @brief Number of reads from all devices that hit audio that wasn't cached
+     */
+    static int GetTotalXrunCount()
+    {
+      return total_xrun_count_;
+    }
+
   private:
+    struct MappedSegment {
+      QFile* file;
+      const char* data;
+      qint64 size;
+      bool silent;
+    };
+
+    bool IsUnavailable(qint64 in, qint64 out) const;
+
     Playlist playlist_;
 
+    QVector<ByteRange> unavailable_;
+
+    QVector<MappedSegment> mapped_segments_;
+
     int current_segment_;
 
     qint64 segment_read_index_;
 
+    QAtomicInt xrun_count_;
+
+    static QAtomicInt total_xrun_count_;
+
   };
 
   /**
@@ -192,9 +302,11 @@ protected:
 private:
   static const qint64 kDefaultSegmentSize;
 
-  Segment CloneSegment(const Segment& s) const;
+  Segment CreateSegment(const qint64 &size, const qint64 &offset);
 
-  Segment CreateSegment(const qint64 &size, const qint64 &offset) const;
+  static Segment CreateSilentSegment(const qint64 &size);
+
+  SegmentFilePtr CreateSegmentFile(const qint64 &size);
 
   QString GenerateSegmentFilename() const;
 
@@ -208,8 +320,12 @@ private:
 
   void UpdateOffsetsFrom(int index);
 
+  void CollectGarbage();
+
   Playlist playlist_;
 
+  QList<SegmentFilePtr> files_;
+
   AudioParams params_;
 
 };
@@ -0,0 +1,99 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "autocacheplanner.h"
+
+#include <iterator>
+
+OLIVE_NAMESPACE_ENTER
+
+TimeRangeList AutoCachePlanner::SetWindow(const TimeRange &window, const rational &playhead)
+{
+  TimeRangeList uncovered = {window};
+  uncovered.RemoveTimeRange(window_);
+
+  window_ = window;
+  playhead_ = playhead;
+
+  // Drop anything that has left the window
+  frames_.erase(frames_.begin(), frames_.lower_bound(window_.in()));
+  frames_.erase(frames_.lower_bound(window_.out()), frames_.end());
+
+  return uncovered;
+}
+
+void AutoCachePlanner::Add(const rational &time)
+{
+  if (time >= window_.in() && time < window_.out()) {
+    frames_.insert(time);
+  }
+}
+
+void AutoCachePlanner::Remove(const rational &time)
+{
+  frames_.erase(time);
+}
+
+void AutoCachePlanner::Remove(const TimeRange &range)
+{
+  frames_.erase(frames_.lower_bound(range.in()), frames_.lower_bound(range.out()));
+}
+
+void AutoCachePlanner::Clear()
+{
+  frames_.clear();
+}
+
+bool AutoCachePlanner::IsEmpty() const
+{
+  return frames_.empty();
+}
+
+bool AutoCachePlanner::TakeNext(rational *time)
+{
+  if (frames_.empty()) {
+    return false;
+  }
+
+  // The closest frame is either the first one at or after the playhead or the last one before it
+  std::set<rational>::iterator ahead = frames_.lower_bound(playhead_);
+  std::set<rational>::iterator next;
+
+  if (ahead == frames_.end()) {
+    next = std::prev(ahead);
+  } else if (ahead == frames_.begin()) {
+    next = ahead;
+  } else {
+    std::set<rational>::iterator behind = std::prev(ahead);
+
+    if (playhead_ - *behind < *ahead - playhead_) {
+      next = behind;
+    } else {
+      next = ahead;
+    }
+  }
+
+  *time = *next;
+  frames_.erase(next);
+
+  return true;
+}
+
+OLIVE_NAMESPACE_EXIT
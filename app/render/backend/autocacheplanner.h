@@ -0,0 +1,100 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef AUTOCACHEPLANNER_H
+#define AUTOCACHEPLANNER_H
+
+#include <set>
+
+#include "common/timerange.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Persistent set of frames the autocache still wants to render
+ *
+ * The planner holds the frames inside the current autocache window that are invalidated and not
+ * yet handed to a worker. Rather than being rebuilt whenever something changes, it's updated with
+ * deltas: frames are added as they're hashed or as the window uncovers them, and removed as
+ * they're validated, invalidated again, or leave the window.
+ *
+ * Frames are taken in order of distance to the playhead, so moving the playhead re-prioritizes the
+ * remaining work without touching anything that's already queued or rendering.
+ */
+class AutoCachePlanner
+{
+public:
+  AutoCachePlanner() = default;
+
+  /**
+   * @brief Move the window frames are planned in and the point they're prioritized around
+   *
+   * Frames that are now outside the window are dropped.
+   *
+   * @return The parts of the new window that weren't covered by the old one, which the caller will
+   * need to add frames from.
+   */
+  TimeRangeList SetWindow(const TimeRange& window, const rational& playhead);
+
+  const TimeRange& window() const
+  {
+    return window_;
+  }
+
+  /**
+   * @brief Add a frame to the plan, frames outside of the window are ignored
+   */
+  void Add(const rational& time);
+
+  /**
+   * @brief Remove a frame from the plan, e.g. because it's been handed to a worker
+   */
+  void Remove(const rational& time);
+
+  /**
+   * @brief Remove every frame in a range from the plan
+   */
+  void Remove(const TimeRange& range);
+
+  void Clear();
+
+  bool IsEmpty() const;
+
+  /**
+   * @brief Remove the frame closest to the playhead from the plan and return it
+   *
+   * Frames ahead of the playhead win ties since that's the direction playback will go.
+   *
+   * @return False if there are no frames left.
+   */
+  bool TakeNext(rational* time);
+
+private:
+  std::set<rational> frames_;
+
+  TimeRange window_;
+
+  rational playhead_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // AUTOCACHEPLANNER_H
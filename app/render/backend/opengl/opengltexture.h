@@ -48,6 +48,11 @@ public:
 
   bool IsCreated() const;
 
+  QOpenGLContext* context() const
+  {
+    return created_ctx_;
+  }
+
   void Bind();
 
   void Release();
@@ -0,0 +1,227 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "opengluploadring.h"
+
+#include <QDebug>
+
+OLIVE_NAMESPACE_ENTER
+
+// Enough for the frame being displayed, the next one and one in flight from the decoder
+const int OpenGLUploadRing::kSlotCount = 3;
+
+OpenGLUploadRing::OpenGLUploadRing() :
+  ctx_(nullptr),
+  stage_counter_(0)
+{
+}
+
+OpenGLUploadRing::~OpenGLUploadRing()
+{
+  Destroy();
+}
+
+void OpenGLUploadRing::Create(QOpenGLContext *ctx)
+{
+  Destroy();
+
+  QMutexLocker locker(&lock_);
+
+  ctx_ = ctx;
+
+  slots_.resize(kSlotCount);
+
+  for (int i=0;i<slots_.size();i++) {
+    Slot& s = slots_[i];
+
+    s.buffer = QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer);
+    s.buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    s.buffer.create();
+    s.data = nullptr;
+    s.size = 0;
+    s.state = kSlotUnmapped;
+    s.staged_order = 0;
+  }
+}
+
+void OpenGLUploadRing::Destroy()
+{
+  QMutexLocker locker(&lock_);
+
+  if (!ctx_) {
+    return;
+  }
+
+  // Don't pull memory out from under a decode thread
+  for (int i=0;i<slots_.size();i++) {
+    while (slots_.at(i).state == kSlotFilling) {
+      fill_done_.wait(&lock_);
+    }
+  }
+
+  for (int i=0;i<slots_.size();i++) {
+    Slot& s = slots_[i];
+
+    if (s.data) {
+      s.buffer.bind();
+      s.buffer.unmap();
+      s.buffer.release();
+    }
+
+    s.buffer.destroy();
+  }
+
+  slots_.clear();
+
+  ctx_ = nullptr;
+}
+
+void OpenGLUploadRing::Prepare(int size)
+{
+  QMutexLocker locker(&lock_);
+
+  for (int i=0;i<slots_.size();i++) {
+    Slot& s = slots_[i];
+
+    if (s.state == kSlotStaged && s.frame.expired()) {
+      // Nothing will ever display this frame now, make the buffer available again
+      s.state = kSlotMapped;
+      s.frame.reset();
+    }
+
+    if (s.state == kSlotUnmapped
+        || (s.state == kSlotMapped && s.size < size)) {
+      MapSlot(s, size);
+    }
+  }
+}
+
+bool OpenGLUploadRing::Upload(OpenGLTexture *texture, Frame *frame)
+{
+  Slot* slot = nullptr;
+
+  {
+    QMutexLocker locker(&lock_);
+
+    for (int i=0;i<slots_.size();i++) {
+      Slot& s = slots_[i];
+
+      if (s.state == kSlotStaged && s.frame.lock().get() == frame) {
+        s.state = kSlotUploading;
+        slot = &s;
+        break;
+      }
+    }
+  }
+
+  if (!slot) {
+    return false;
+  }
+
+  // Unmap and transfer into the texture (with a buffer bound, the data pointer is an offset into it)
+  slot->buffer.bind();
+  slot->buffer.unmap();
+  slot->data = nullptr;
+
+  texture->Upload(nullptr, frame->linesize_pixels());
+
+  slot->buffer.release();
+
+  // Map it again straight away so it's ready for the decoder, orphaning the storage means this won't wait for
+  // the transfer above to finish
+  QMutexLocker locker(&lock_);
+
+  slot->frame.reset();
+  MapSlot(*slot, slot->size);
+
+  return true;
+}
+
+bool OpenGLUploadRing::Stage(FramePtr frame)
+{
+  Slot* slot = nullptr;
+
+  {
+    QMutexLocker locker(&lock_);
+
+    for (int i=0;i<slots_.size();i++) {
+      Slot& s = slots_[i];
+
+      if (s.size < frame->allocated_size()) {
+        continue;
+      }
+
+      if (s.state == kSlotMapped) {
+        slot = &s;
+        break;
+      }
+
+      if (s.state == kSlotStaged && (!slot || s.staged_order < slot->staged_order)) {
+        // If there are no free buffers, take the one staged longest ago. If it gets displayed later it'll just
+        // be uploaded directly instead.
+        slot = &s;
+      }
+    }
+
+    if (!slot) {
+      return false;
+    }
+
+    slot->state = kSlotFilling;
+    slot->frame.reset();
+  }
+
+  memcpy(slot->data, frame->const_data(), static_cast<size_t>(frame->allocated_size()));
+
+  QMutexLocker locker(&lock_);
+
+  slot->state = kSlotStaged;
+  slot->frame = frame;
+  slot->staged_order = ++stage_counter_;
+
+  fill_done_.wakeAll();
+
+  return true;
+}
+
+void OpenGLUploadRing::MapSlot(Slot &slot, int size)
+{
+  slot.buffer.bind();
+
+  if (slot.data) {
+    slot.buffer.unmap();
+  }
+
+  slot.buffer.allocate(size);
+  slot.data = slot.buffer.mapRange(0, size, QOpenGLBuffer::RangeWrite | QOpenGLBuffer::RangeInvalidateBuffer);
+
+  slot.buffer.release();
+
+  if (slot.data) {
+    slot.size = size;
+    slot.state = kSlotMapped;
+  } else {
+    qWarning() << "Failed to map pixel unpack buffer";
+    slot.size = 0;
+    slot.state = kSlotUnmapped;
+  }
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,113 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef OPENGLUPLOADRING_H
+#define OPENGLUPLOADRING_H
+
+#include <QMutex>
+#include <QOpenGLBuffer>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "codec/frame.h"
+#include "opengltexture.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief A small ring of mapped pixel unpack buffers for streaming frames into a texture
+ *
+ * The GUI thread keeps every free buffer mapped, so that a decode thread can copy a frame into one with Stage()
+ * without touching OpenGL. When that frame is later displayed, Upload() only has to unmap the buffer and
+ * issue an asynchronous texture transfer from it, which takes the full-frame memcpy off the GUI thread.
+ *
+ * Create(), Destroy(), Prepare() and Upload() must be called from the thread that owns the context (with it
+ * current). Stage() may be called from any thread.
+ */
+class OpenGLUploadRing
+{
+public:
+  OpenGLUploadRing();
+
+  ~OpenGLUploadRing();
+
+  DISABLE_COPY_MOVE(OpenGLUploadRing)
+
+  void Create(QOpenGLContext* ctx);
+
+  void Destroy();
+
+  /**
+   * @brief Ensure every free buffer is mapped and at least `size` bytes
+   */
+  void Prepare(int size);
+
+  /**
+   * @brief Upload a frame into a texture from the buffer it was staged in
+   *
+   * Returns false if the frame wasn't staged (or its buffer has since been reused), in which case the caller
+   * should upload it directly.
+   */
+  bool Upload(OpenGLTexture* texture, Frame* frame);
+
+  /**
+   * @brief Copy a frame into a free mapped buffer ahead of it being displayed
+   *
+   * Returns false if no buffer was available.
+   */
+  bool Stage(FramePtr frame);
+
+private:
+  enum SlotState {
+    kSlotUnmapped,
+    kSlotMapped,
+    kSlotFilling,
+    kSlotStaged,
+    kSlotUploading
+  };
+
+  struct Slot {
+    QOpenGLBuffer buffer;
+    void* data;
+    int size;
+    SlotState state;
+    std::weak_ptr<Frame> frame;
+    quint64 staged_order;
+  };
+
+  void MapSlot(Slot& slot, int size);
+
+  static const int kSlotCount;
+
+  QOpenGLContext* ctx_;
+
+  QVector<Slot> slots_;
+
+  QMutex lock_;
+
+  QWaitCondition fill_done_;
+
+  quint64 stage_counter_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // OPENGLUPLOADRING_H
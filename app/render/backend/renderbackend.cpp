@@ -26,6 +26,7 @@
 
 #include "config/config.h"
 #include "core.h"
+#include "render/diskmanager.h"
 #include "task/conform/conform.h"
 #include "task/taskmanager.h"
 #include "window/mainwindow/mainwindow.h"
@@ -37,6 +38,13 @@ QMutex RenderBackend::instance_lock_;
 RenderBackend* RenderBackend::active_instance_ = nullptr;
 QThreadPool RenderBackend::thread_pool_;
 
+// Below this, the overhead of another ticket outweighs hashing the frames on an existing worker
+const int RenderBackend::kMinimumHashChunkSize = 64;
+
+// Enough to keep every worker busy while the next frames are queued, but few enough that a moving playhead
+// re-prioritizes the rest of the plan almost immediately
+const int RenderBackend::kAutoCacheTicketsPerWorker = 2;
+
 RenderBackend::RenderBackend(QObject *parent) :
   QObject(parent),
   viewer_node_(nullptr),
@@ -45,7 +53,7 @@ RenderBackend::RenderBackend(QObject *parent) :
   autocache_paused_(false),
   generate_audio_previews_(false),
   render_mode_(RenderMode::kOnline),
-  autocache_has_changed_(false),
+  autocache_halted_(false),
   use_custom_autocache_range_(false),
   ignore_next_mouse_button_(false)
 {
@@ -91,10 +99,13 @@ void RenderBackend::SetViewerNode(ViewerOutput *viewer_node)
 
       // We need to wait for these since they work directly on the FrameHashCache. Most of the time
       // this is fine, but not if the FrameHashCache gets deleted after this function.
-      foreach (QFutureWatcher<void>* watcher, autocache_hash_process_tasks_) {
-        watcher->waitForFinished();
+      {
+        QMap<QFutureWatcher<void>*, QVector<rational> >::const_iterator i;
+        for (i=autocache_hash_process_tasks_.constBegin(); i!=autocache_hash_process_tasks_.constEnd(); i++) {
+          i.key()->waitForFinished();
+        }
+        autocache_hash_process_tasks_.clear();
       }
-      autocache_hash_process_tasks_.clear();
 
       // This can be cleared normally (frames will be discarded and need to be rendered again)
       autocache_video_tasks_.clear();
@@ -114,6 +125,9 @@ void RenderBackend::SetViewerNode(ViewerOutput *viewer_node)
 
       // No longer caching any hashes
       autocache_currently_caching_hashes_.clear();
+
+      // None of the planned frames belong to the new viewer
+      autocache_planner_.Clear();
     }
 
     // Delete all of our copied nodes
@@ -135,6 +149,16 @@ void RenderBackend::SetViewerNode(ViewerOutput *viewer_node)
                this,
                &RenderBackend::AutoCacheVideoInvalidated);
 
+    disconnect(old_viewer->video_frame_cache(),
+               &PlaybackCache::Validated,
+               this,
+               &RenderBackend::AutoCacheVideoValidated);
+
+    disconnect(old_viewer->video_frame_cache(),
+               &PlaybackCache::Shifted,
+               this,
+               &RenderBackend::AutoCacheVideoShifted);
+
     disconnect(old_viewer->audio_playback_cache(),
                &PlaybackCache::Invalidated,
                this,
@@ -172,10 +196,24 @@ void RenderBackend::SetViewerNode(ViewerOutput *viewer_node)
               this,
               &RenderBackend::AutoCacheVideoInvalidated);
 
+      connect(viewer_node_->video_frame_cache(),
+              &PlaybackCache::Validated,
+              this,
+              &RenderBackend::AutoCacheVideoValidated);
+
+      connect(viewer_node_->video_frame_cache(),
+              &PlaybackCache::Shifted,
+              this,
+              &RenderBackend::AutoCacheVideoShifted);
+
       connect(viewer_node_->audio_playback_cache(),
               &PlaybackCache::Invalidated,
               this,
               &RenderBackend::AutoCacheAudioInvalidated);
+
+      // Frames will be queued again the next time the autocache is asked to requeue
+      AutoCacheReplan();
+      autocache_halted_ = false;
     }
   }
 }
@@ -184,11 +222,19 @@ void RenderBackend::AutoCacheRange(const TimeRange &range)
 {
   Q_ASSERT(autocache_enabled_);
 
-  autocache_has_changed_ = true;
   use_custom_autocache_range_ = true;
-  custom_autocache_range_ = range;
 
-  AutoCacheRequeueFrames();
+  // Cache the range from start to finish
+  AutoCacheSetWindow(range, range.in());
+}
+
+void RenderBackend::SetAutoCachePlayhead(const rational &playhead)
+{
+  use_custom_autocache_range_ = false;
+
+  AutoCacheSetWindow(TimeRange(playhead - Config::Current()["DiskCacheBehind"].value<rational>(),
+                               playhead + Config::Current()["DiskCacheAhead"].value<rational>()),
+                     playhead);
 }
 
 RenderTicketPtr RenderBackend::Hash(const QVector<rational> &times, bool prioritize)
@@ -197,18 +243,88 @@ RenderTicketPtr RenderBackend::Hash(const QVector<rational> &times, bool priorit
 
   SetActiveInstance();
 
-  RenderTicketPtr ticket = std::make_shared<RenderTicket>(RenderTicket::kTypeHash,
+  int chunk_count = qMin(thread_pool_.maxThreadCount(),
+                         (times.size() + kMinimumHashChunkSize - 1) / kMinimumHashChunkSize);
+
+  if (chunk_count <= 1) {
+    RenderTicketPtr ticket = std::make_shared<RenderTicket>(RenderTicket::kTypeHash,
+                                                            QVariant::fromValue(times));
+
+    if (prioritize) {
+      render_queue_.push_front(ticket);
+    } else {
+      render_queue_.push_back(ticket);
+    }
+
+    QMetaObject::invokeMethod(this, "RunNextJob", Qt::QueuedConnection);
+
+    return ticket;
+  }
+
+  // Split the list into contiguous chunks so each worker can hash its own stretch of the timeline.
+  // The returned ticket finishes once every chunk has, with the results stitched back together in
+  // the original order.
+  RenderTicketPtr parent = std::make_shared<RenderTicket>(RenderTicket::kTypeHash,
                                                           QVariant::fromValue(times));
+  parent->SetJobTime();
+
+  std::shared_ptr<HashChunkState> state = std::make_shared<HashChunkState>();
+  state->hashes.resize(times.size());
+  state->remaining = chunk_count;
+  state->cancelled = false;
+
+  QVector<RenderTicketPtr> chunks(chunk_count);
+
+  for (int i=0;i<chunk_count;i++) {
+    int start = times.size() * i / chunk_count;
+    int end = times.size() * (i + 1) / chunk_count;
+
+    RenderTicketPtr chunk = std::make_shared<RenderTicket>(RenderTicket::kTypeHash,
+                                                           QVariant::fromValue(times.mid(start, end - start)));
+    RenderTicket* chunk_ptr = chunk.get();
+
+    // Direct connection since the chunk may finish on any worker thread, and the caller may be
+    // blocking on the parent ticket
+    connect(chunk_ptr, &RenderTicket::Finished, chunk_ptr, [chunk_ptr, state, parent, start](){
+      QMutexLocker locker(&state->lock);
+
+      if (chunk_ptr->WasCancelled()) {
+        state->cancelled = true;
+      } else {
+        QVector<QByteArray> chunk_hashes = chunk_ptr->Get().value<QVector<QByteArray> >();
+
+        std::copy(chunk_hashes.constBegin(), chunk_hashes.constEnd(), state->hashes.begin() + start);
+      }
+
+      state->remaining--;
+
+      if (state->remaining == 0) {
+        if (state->cancelled) {
+          parent->Cancel();
+        } else {
+          parent->Finish(QVariant::fromValue(state->hashes));
+        }
+      }
+    }, Qt::DirectConnection);
+
+    chunks[i] = chunk;
+  }
 
   if (prioritize) {
-    render_queue_.push_front(ticket);
+    for (int i=chunks.size()-1;i>=0;i--) {
+      render_queue_.push_front(chunks.at(i));
+    }
   } else {
-    render_queue_.push_back(ticket);
+    foreach (RenderTicketPtr chunk, chunks) {
+      render_queue_.push_back(chunk);
+    }
   }
 
-  QMetaObject::invokeMethod(this, "RunNextJob", Qt::QueuedConnection);
+  for (int i=0;i<chunk_count;i++) {
+    QMetaObject::invokeMethod(this, "RunNextJob", Qt::QueuedConnection);
+  }
 
-  return ticket;
+  return parent;
 }
 
 RenderTicketPtr RenderBackend::RenderFrame(const rational &time, bool prioritize, const QByteArray& hash)
@@ -268,19 +384,60 @@ void RenderBackend::IgnoreNextMouseButton()
   ignore_next_mouse_button_ = true;
 }
 
-std::list<TimeRange> RenderBackend::SplitRangeIntoChunks(const TimeRange &r)
+/**
+ * @brief Converts a time to a sample index exactly, rounding down or up if it falls between samples
+ */
+static int64_t TimeToSampleIndex(const rational& time, int sample_rate, bool round_up)
 {
-  // FIXME: Magic number
-  const int chunk_size = 2;
+  if (time.isNull()) {
+    return 0;
+  }
 
+  int64_t n = time.numerator() * sample_rate;
+  int64_t d = time.denominator();
+
+  int64_t index = n / d;
+
+  if (n % d) {
+    if (round_up && n > 0) {
+      index++;
+    } else if (!round_up && n < 0) {
+      index--;
+    }
+  }
+
+  return index;
+}
+
+std::list<TimeRange> RenderBackend::SplitRangeIntoChunks(const TimeRange &r, const AudioParams &params,
+                                                         const rational &chunk_length)
+{
   std::list<TimeRange> split_ranges;
 
-  int start_time = qFloor(r.in().toDouble() / static_cast<double>(chunk_size)) * chunk_size;
-  int end_time = qCeil(r.out().toDouble() / static_cast<double>(chunk_size)) * chunk_size;
+  if (!params.is_valid() || r.out() <= r.in()) {
+    return split_ranges;
+  }
+
+  int sample_rate = params.sample_rate();
+
+  int64_t chunk_samples = qMax(int64_t(1), TimeToSampleIndex(chunk_length, sample_rate, false));
 
-  for (int i=start_time; i<end_time; i+=chunk_size) {
-    split_ranges.push_back(TimeRange(qMax(r.in(), rational(i)),
-                                     qMin(r.out(), rational(i + chunk_size))));
+  // Work out which chunks the range touches in whole samples so no rounding can make two requests
+  // for the same time disagree on where its chunk starts
+  int64_t start_sample = TimeToSampleIndex(r.in(), sample_rate, false);
+  int64_t end_sample = TimeToSampleIndex(r.out(), sample_rate, true);
+
+  int64_t first_chunk = start_sample / chunk_samples;
+  if (start_sample % chunk_samples < 0) {
+    first_chunk--;
+  }
+
+  for (int64_t i=first_chunk; i*chunk_samples<end_sample; i++) {
+    rational chunk_in(i * chunk_samples, sample_rate);
+    rational chunk_out((i + 1) * chunk_samples, sample_rate);
+
+    split_ranges.push_back(TimeRange(qMax(r.in(), chunk_in),
+                                     qMin(r.out(), chunk_out)));
   }
 
   return split_ranges;
@@ -288,10 +445,11 @@ std::list<TimeRange> RenderBackend::SplitRangeIntoChunks(const TimeRange &r)
 
 void RenderBackend::ClearVideoQueue()
 {
-  ClearQueueOfType(RenderTicket::kTypeVideo);
-
-  autocache_has_changed_ = true;
+  // Stop queueing autocache frames until we're told to resume, cancelled frames go back in the plan
+  autocache_halted_ = true;
   use_custom_autocache_range_ = false;
+
+  ClearQueueOfType(RenderTicket::kTypeVideo);
 }
 
 void RenderBackend::ClearAudioQueue()
@@ -301,6 +459,9 @@ void RenderBackend::ClearAudioQueue()
 
 void RenderBackend::ClearQueue()
 {
+  // Prevent cancelled autocache frames from being replaced as we go
+  autocache_halted_ = true;
+
   foreach (RenderTicketPtr t, render_queue_) {
     t->Cancel();
   }
@@ -415,89 +576,115 @@ void RenderBackend::RunNextJob()
       connect(worker, &RenderWorker::WaveformGenerated, this, &RenderBackend::WorkerGeneratedWaveform);
       connect(worker, &RenderWorker::FinishedJob, this, &RenderBackend::WorkerFinished);
 
-      workers_.replace(i, {worker, false});
+      workers_.replace(i, {worker, false, RATIONAL_MIN});
     }
   }
 
   // Start popping jobs off the queue
-  for (int i=0;i<workers_.size();i++) {
-    if (!workers_.at(i).busy) {
-      // This worker is available, send it the job
-
-      RenderWorker* worker = workers_[i].worker;
-
-      workers_[i].busy = true;
-
-      worker->SetVideoParams(video_params_);
-      worker->SetAudioParams(audio_params_);
-      worker->SetForceDownloadResolution(video_force_download_resolution_);
-      worker->SetVideoDownloadMatrix(video_download_matrix_);
-      worker->SetRenderMode(render_mode_);
-      worker->SetPreviewGenerationEnabled(generate_audio_previews_);
-      worker->SetCopyMap(&copy_map_);
-      worker->SetCachePath(viewer_node_->video_frame_cache()->GetCacheDirectory());
-
-      // Move ticket from queue to running list
-      RenderTicketPtr ticket = render_queue_.front();
-      render_queue_.pop_front();
-      running_tickets_.push_back(ticket);
-
-      // Create watcher to remove from running list
-      RenderTicketWatcher* watcher = new RenderTicketWatcher();
-      connect(watcher, &RenderTicketWatcher::Finished, this, &RenderBackend::TicketFinished);
-      watcher->SetTicket(ticket);
-
-      // Set job time to now
-      ticket->SetJobTime();
-
-      switch (ticket->GetType()) {
-      case RenderTicket::kTypeHash:
-        Q_ASSERT(video_params_.is_valid());
-
-        QtConcurrent::run(&thread_pool_,
-                          worker,
-                          &RenderWorker::Hash,
-                          ticket,
-                          copied_viewer_node_,
-                          ticket->GetTime().value<QVector<rational> >());
-        break;
-      case RenderTicket::kTypeVideo:
-      {
-        Q_ASSERT(video_params_.is_valid());
+  while (!render_queue_.empty()) {
+    int worker_index = GetWorkerForTicket(render_queue_.front());
 
-        rational frame = ticket->GetTime().value<rational>();
+    if (worker_index == -1) {
+      // All workers are busy
+      break;
+    }
 
-        QtConcurrent::run(&thread_pool_,
-                          worker,
-                          &RenderWorker::RenderFrame,
-                          ticket,
-                          copied_viewer_node_,
-                          frame);
+    // This worker is available, send it the job
 
-        QByteArray frame_hash = ticket->property("hash").toByteArray();
-        if (!frame_hash.isEmpty()) {
-          autocache_currently_caching_hashes_.append(frame_hash);
-        }
-        break;
+    RenderWorker* worker = workers_[worker_index].worker;
+
+    workers_[worker_index].busy = true;
+
+    worker->SetVideoParams(video_params_);
+    worker->SetAudioParams(audio_params_);
+    // Config isn't safe to read from the workers' threads, so it's read here on the main thread
+    worker->SetAudioSpeedQuality(static_cast<SampleBuffer::SpeedQuality>(Config::Current()["AudioSpeedQuality"].toInt()));
+    worker->SetForceDownloadResolution(video_force_download_resolution_);
+    worker->SetVideoDownloadMatrix(video_download_matrix_);
+    worker->SetRenderMode(render_mode_);
+    worker->SetPreviewGenerationEnabled(generate_audio_previews_);
+    worker->SetCopyMap(&copy_map_);
+    worker->SetCachePath(viewer_node_->video_frame_cache()->GetCacheDirectory());
+
+    // Move ticket from queue to running list
+    RenderTicketPtr ticket = render_queue_.front();
+    render_queue_.pop_front();
+    running_tickets_.push_back(ticket);
+
+    // Create watcher to remove from running list
+    RenderTicketWatcher* watcher = new RenderTicketWatcher();
+    connect(watcher, &RenderTicketWatcher::Finished, this, &RenderBackend::TicketFinished);
+    watcher->SetTicket(ticket);
+
+    // Set job time to now
+    ticket->SetJobTime();
+
+    switch (ticket->GetType()) {
+    case RenderTicket::kTypeHash:
+      Q_ASSERT(video_params_.is_valid());
+
+      QtConcurrent::run(&thread_pool_,
+                        worker,
+                        &RenderWorker::Hash,
+                        ticket,
+                        copied_viewer_node_,
+                        ticket->GetTime().value<QVector<rational> >());
+      break;
+    case RenderTicket::kTypeVideo:
+    {
+      Q_ASSERT(video_params_.is_valid());
+
+      rational frame = ticket->GetTime().value<rational>();
+
+      QtConcurrent::run(&thread_pool_,
+                        worker,
+                        &RenderWorker::RenderFrame,
+                        ticket,
+                        copied_viewer_node_,
+                        frame);
+
+      QByteArray frame_hash = ticket->property("hash").toByteArray();
+      if (!frame_hash.isEmpty()) {
+        autocache_currently_caching_hashes_.insert(frame_hash);
       }
-      case RenderTicket::kTypeAudio:
-        Q_ASSERT(audio_params_.is_valid());
-
-        QtConcurrent::run(&thread_pool_,
-                          worker,
-                          &RenderWorker::RenderAudio,
-                          ticket,
-                          copied_viewer_node_,
-                          ticket->GetTime().value<TimeRange>());
-        break;
+      break;
+    }
+    case RenderTicket::kTypeAudio:
+      Q_ASSERT(audio_params_.is_valid());
+
+      workers_[worker_index].audio_out = ticket->GetTime().value<TimeRange>().out();
+
+      QtConcurrent::run(&thread_pool_,
+                        worker,
+                        &RenderWorker::RenderAudio,
+                        ticket,
+                        copied_viewer_node_,
+                        ticket->GetTime().value<TimeRange>());
+      break;
+    }
+  }
+}
+
+int RenderBackend::GetWorkerForTicket(RenderTicketPtr ticket) const
+{
+  int available = -1;
+
+  for (int i=0;i<workers_.size();i++) {
+    if (!workers_.at(i).busy) {
+      // Audio that follows on from what a worker rendered last goes back to that worker, its
+      // decoders are already positioned there and won't need to seek
+      if (ticket->GetType() == RenderTicket::kTypeAudio
+          && workers_.at(i).audio_out == ticket->GetTime().value<TimeRange>().in()) {
+        return i;
       }
 
-      if (render_queue_.empty()) {
-        // No more jobs, can exit here
-        break;
+      if (available == -1) {
+        available = i;
       }
     }
   }
+
+  return available;
 }
 
 void RenderBackend::TicketFinished()
@@ -530,19 +717,38 @@ void RenderBackend::WorkerGeneratedWaveform(RenderTicketPtr ticket, TrackOutput
 
 void RenderBackend::AutoCacheVideoInvalidated(const TimeRange &range)
 {
-  ClearVideoQueue();
+  QVector<rational> frames = viewer_node_->video_frame_cache()->GetFrameListFromTimeRange({range});
+
+  // These frames' hashes are gone so they can't be rendered until they've been hashed again. Only
+  // frames that haven't started are cancelled, the rest of the queue and plan is left alone.
+  if (!frames.isEmpty()) {
+    TimeRange stale_range(frames.first(), range.out());
+
+    autocache_planner_.Remove(stale_range);
+    AutoCacheCancelQueuedFrames(stale_range);
+  }
 
   // Hash these frames since that should be relatively quick.
   if (ignore_next_mouse_button_ || !(qApp->mouseButtons() & Qt::LeftButton)) {
     ignore_next_mouse_button_ = false;
     RenderTicketWatcher* watcher = new RenderTicketWatcher();
-    QVector<rational> frames = viewer_node_->video_frame_cache()->GetFrameListFromTimeRange({range});
     autocache_hash_tasks_.insert(watcher, frames);
     connect(watcher, &RenderTicketWatcher::Finished, this, &RenderBackend::AutoCacheHashesGenerated);
     watcher->SetTicket(Hash(frames));
   }
 }
 
+void RenderBackend::AutoCacheVideoValidated(const TimeRange &range)
+{
+  autocache_planner_.Remove(range);
+}
+
+void RenderBackend::AutoCacheVideoShifted()
+{
+  // Every planned time has potentially moved, this is rare enough to just start again
+  AutoCacheReplan();
+}
+
 void RenderBackend::AutoCacheAudioInvalidated(const TimeRange &range)
 {
   // Start a task to re-render the audio at this range
@@ -552,25 +758,39 @@ void RenderBackend::AutoCacheAudioInvalidated(const TimeRange &range)
   watcher->SetTicket(RenderAudio(range, true));
 }
 
-void RenderBackend::SetHashes(FrameHashCache* cache, const QVector<rational>& times, const QVector<QByteArray>& hashes, qint64 job_time)
+void RenderBackend::SetHashes(FrameHashCache* cache, DiskCacheFolder* folder, const QVector<rational>& times, const QVector<QByteArray>& hashes, qint64 job_time)
 {
-  std::vector<QByteArray> existing_hashes;
+  // Long stretches of the timeline usually share a hash, so only check each unique hash once
+  QVector<QByteArray> unique_hashes;
+  QHash<QByteArray, int> unique_index;
 
-  for (int i=0; i<times.size(); i++) {
-    // See if hash already exists in disk cache
-    const QByteArray& hash = hashes.at(i);
-    const rational& time = times.at(i);
+  unique_hashes.reserve(hashes.size());
 
-    // Check memory list since disk checking is slow
-    bool hash_exists = (std::find(existing_hashes.begin(), existing_hashes.end(), hash) != existing_hashes.end());
+  foreach (const QByteArray& hash, hashes) {
+    if (!unique_index.contains(hash)) {
+      unique_index.insert(hash, unique_hashes.size());
+      unique_hashes.append(hash);
+    }
+  }
 
-    if (!hash_exists) {
-      hash_exists = QFileInfo::exists(cache->CachePathName(hash));
+  QVector<bool> unique_exists;
 
-      if (hash_exists) {
-        existing_hashes.push_back(hash);
-      }
+  if (folder) {
+    // Query the disk cache's index in one go rather than hitting the filesystem for every frame
+    unique_exists = folder->ContainsHashes(unique_hashes);
+  } else {
+    unique_exists.resize(unique_hashes.size());
+
+    for (int i=0; i<unique_hashes.size(); i++) {
+      unique_exists[i] = QFileInfo::exists(cache->CachePathName(unique_hashes.at(i)));
     }
+  }
+
+  for (int i=0; i<times.size(); i++) {
+    const QByteArray& hash = hashes.at(i);
+    const rational& time = times.at(i);
+
+    bool hash_exists = unique_exists.at(unique_index.value(hash));
 
     QMetaObject::invokeMethod(cache, "SetHash", Qt::QueuedConnection,
                               OLIVE_NS_ARG(rational, time),
@@ -588,10 +808,11 @@ void RenderBackend::AutoCacheHashesGenerated()
     if (!watcher->WasCancelled()) {
       QFutureWatcher<void>* hw = new QFutureWatcher<void>();
       connect(hw, &QFutureWatcher<void>::finished, this, &RenderBackend::AutoCacheHashesProcessed);
-      autocache_hash_process_tasks_.append(hw);
+      autocache_hash_process_tasks_.insert(hw, autocache_hash_tasks_.value(watcher));
       hw->setFuture(QtConcurrent::run(this,
                                       &RenderBackend::SetHashes,
                                       viewer_node_->video_frame_cache(),
+                                      DiskManager::instance()->GetOpenFolder(viewer_node_->video_frame_cache()->GetCacheDirectory()),
                                       autocache_hash_tasks_.value(watcher),
                                       watcher->Get().value<QVector<QByteArray> >(),
                                       watcher->GetTicket()->GetJobTime()));
@@ -608,8 +829,16 @@ void RenderBackend::AutoCacheHashesProcessed()
   QFutureWatcher<void>* watcher = static_cast<QFutureWatcher<void>*>(sender());
 
   if (autocache_hash_process_tasks_.contains(watcher)) {
-    autocache_hash_process_tasks_.removeOne(watcher);
+    // Hashes that already existed on disk have been validated by now, plan the rest
+    QVector<rational> invalidated_frames;
 
+    foreach (const rational& t, autocache_hash_process_tasks_.take(watcher)) {
+      if (viewer_node_->video_frame_cache()->IsFrameInvalidated(t)) {
+        invalidated_frames.append(t);
+      }
+    }
+
+    AutoCachePlanFrames(invalidated_frames);
     AutoCacheRequeueFrames();
   }
 
@@ -638,9 +867,9 @@ void RenderBackend::AutoCacheVideoRendered()
   RenderTicketWatcher* watcher = static_cast<RenderTicketWatcher*>(sender());
 
   if (autocache_video_tasks_.contains(watcher)) {
-    if (!watcher->WasCancelled()) {
-      const QByteArray& hash = autocache_video_tasks_.value(watcher);
+    QByteArray hash = autocache_video_tasks_.take(watcher);
 
+    if (!watcher->WasCancelled()) {
       // Download frame in another thread
       QFutureWatcher<bool>* w = new QFutureWatcher<bool>();
       autocache_video_download_tasks_.insert(w, hash);
@@ -649,9 +878,22 @@ void RenderBackend::AutoCacheVideoRendered()
                                      &FrameHashCache::SaveCacheFrame,
                                      hash,
                                      watcher->Get().value<FramePtr>()));
+    } else if (viewer_node_) {
+      // This frame was dropped before it was rendered, so put every frame that was waiting on its hash
+      // back in the plan
+      QVector<rational> invalidated_frames;
+
+      foreach (const rational& t, viewer_node_->video_frame_cache()->GetFramesWithHash(hash)) {
+        if (viewer_node_->video_frame_cache()->IsFrameInvalidated(t)) {
+          invalidated_frames.append(t);
+        }
+      }
+
+      AutoCachePlanFrames(invalidated_frames);
     }
 
-    autocache_video_tasks_.remove(watcher);
+    // A slot has opened up
+    AutoCacheDispatchFrames();
   }
 
   delete watcher;
@@ -666,7 +908,7 @@ void RenderBackend::AutoCacheVideoDownloaded()
       if (watcher->result()) {
         const QByteArray& hash = autocache_video_download_tasks_.value(watcher);
 
-        autocache_currently_caching_hashes_.removeOne(hash);
+        autocache_currently_caching_hashes_.remove(hash);
 
         viewer_node_->video_frame_cache()->ValidateFramesWithHash(hash);
       } else {
@@ -841,47 +1083,93 @@ void RenderBackend::SetActiveInstance()
 
 void RenderBackend::AutoCacheRequeueFrames()
 {
-  if (viewer_node_
-      && viewer_node_->video_frame_cache()->HasInvalidatedRanges()
-      && autocache_hash_tasks_.isEmpty()
-      && autocache_hash_process_tasks_.isEmpty()
-      && autocache_has_changed_
-      && (!autocache_paused_ || use_custom_autocache_range_)) {
-    TimeRange using_range;
-
-    if (use_custom_autocache_range_) {
-      using_range = custom_autocache_range_;
-      use_custom_autocache_range_ = false;
-    } else {
-      using_range = autocache_range_;
+  autocache_halted_ = false;
+
+  AutoCacheDispatchFrames();
+}
+
+void RenderBackend::AutoCacheSetWindow(const TimeRange &window, const rational &playhead)
+{
+  TimeRangeList uncovered = autocache_planner_.SetWindow(window, playhead);
+
+  // Only the parts of the window that are new need looking at, everything else is already planned
+  if (viewer_node_ && autocache_enabled_) {
+    foreach (const TimeRange& r, uncovered) {
+      AutoCachePlanFrames(viewer_node_->video_frame_cache()->GetInvalidatedFrames(r));
     }
+  }
+
+  AutoCacheRequeueFrames();
+}
+
+void RenderBackend::AutoCachePlanFrames(const QVector<rational> &frames)
+{
+  foreach (const rational& t, frames) {
+    autocache_planner_.Add(t);
+  }
+}
 
-    QVector<rational> invalidated_ranges = viewer_node_->video_frame_cache()->GetInvalidatedFrames(using_range);
+void RenderBackend::AutoCacheReplan()
+{
+  autocache_planner_.Clear();
 
-    ClearVideoQueue();
+  if (viewer_node_) {
+    AutoCachePlanFrames(viewer_node_->video_frame_cache()->GetInvalidatedFrames(autocache_planner_.window()));
+  }
+}
 
-    // QMaps are automatically sorted by time which is always best for rendering
-    QList<QByteArray> queued_hashes;
+void RenderBackend::AutoCacheDispatchFrames()
+{
+  if (!viewer_node_
+      || !autocache_enabled_
+      || autocache_halted_
+      || (autocache_paused_ && !use_custom_autocache_range_)) {
+    return;
+  }
 
-    foreach (const rational& t, invalidated_ranges) {
-      const QByteArray& hash = viewer_node_->video_frame_cache()->GetHash(t);
+  FrameHashCache* cache = viewer_node_->video_frame_cache();
+  int max_tickets = thread_pool_.maxThreadCount() * kAutoCacheTicketsPerWorker;
+  rational t;
 
-      if (t >= using_range.in()
-          && t < using_range.out()
-          && !queued_hashes.contains(hash)
-          && !autocache_currently_caching_hashes_.contains(hash)) {
-        // Don't render any hash more than once
-        queued_hashes.append(hash);
+  while (autocache_video_tasks_.size() < max_tickets
+         && autocache_planner_.TakeNext(&t)) {
+    QByteArray hash = cache->GetHash(t);
 
-        RenderTicketWatcher* watcher = new RenderTicketWatcher();
-        connect(watcher, &RenderTicketWatcher::Finished, this, &RenderBackend::AutoCacheVideoRendered);
-        autocache_video_tasks_.insert(watcher, hash);
+    // Frames without a hash will be planned again once they're hashed. Don't render any hash more
+    // than once, the other frames using it will be validated when it's done.
+    if (hash.isEmpty()
+        || autocache_currently_caching_hashes_.contains(hash)
+        || autocache_video_tasks_.values().contains(hash)) {
+      continue;
+    }
 
-        watcher->SetTicket(RenderFrame(t, false, hash));
-      }
+    RenderTicketWatcher* watcher = new RenderTicketWatcher();
+    connect(watcher, &RenderTicketWatcher::Finished, this, &RenderBackend::AutoCacheVideoRendered);
+    autocache_video_tasks_.insert(watcher, hash);
+
+    watcher->SetTicket(RenderFrame(t, false, hash));
+  }
+}
+
+void RenderBackend::AutoCacheCancelQueuedFrames(const TimeRange &range)
+{
+  std::list<RenderTicketPtr> cancelled;
+  std::list<RenderTicketPtr>::iterator i = render_queue_.begin();
+
+  while (i != render_queue_.end()) {
+    if ((*i)->GetType() == RenderTicket::kTypeVideo
+        && !(*i)->property("hash").toByteArray().isEmpty()
+        && range.Contains((*i)->GetTime().value<rational>())) {
+      cancelled.push_back(*i);
+      i = render_queue_.erase(i);
+    } else {
+      i++;
     }
+  }
 
-    autocache_has_changed_ = false;
+  // Cancel after we're done with the queue since cancelling can queue more frames
+  foreach (RenderTicketPtr ticket, cancelled) {
+    ticket->Cancel();
   }
 }
 
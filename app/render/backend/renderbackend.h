@@ -23,6 +23,7 @@
 
 #include <QtConcurrent/QtConcurrent>
 
+#include "autocacheplanner.h"
 #include "config/config.h"
 #include "dialog/rendercancel/rendercancel.h"
 #include "decodercache.h"
@@ -35,6 +36,8 @@
 
 OLIVE_NAMESPACE_ENTER
 
+class DiskCacheFolder;
+
 class RenderBackend : public QObject
 {
   Q_OBJECT
@@ -77,18 +80,12 @@ public:
 
   void AutoCacheRange(const TimeRange& range);
 
+  /**
+   * @brief Resume handing planned frames to the workers after ClearVideoQueue() stopped it
+   */
   void AutoCacheRequeueFrames();
 
-  void SetAutoCachePlayhead(const rational& playhead)
-  {
-    autocache_range_ = TimeRange(playhead - Config::Current()["DiskCacheBehind"].value<rational>(),
-                                 playhead + Config::Current()["DiskCacheAhead"].value<rational>());
-
-    autocache_has_changed_ = true;
-    use_custom_autocache_range_ = false;
-
-    AutoCacheRequeueFrames();
-  }
+  void SetAutoCachePlayhead(const rational& playhead);
 
   void SetRenderMode(RenderMode::Mode e)
   {
@@ -143,7 +140,16 @@ public:
 
   void IgnoreNextMouseButton();
 
-  static std::list<TimeRange> SplitRangeIntoChunks(const TimeRange& r);
+  /**
+   * @brief Split an audio range into chunks that can be rendered separately
+   *
+   * Chunks are `chunk_length` long (usually the "AudioChunkLength" preference, which callers should
+   * read on the main thread), rounded down to whole samples of `params`. Their boundaries are always
+   * at multiples of that length from 0, so the same time is always part of the same chunk however
+   * the range was requested.
+   */
+  static std::list<TimeRange> SplitRangeIntoChunks(const TimeRange& r, const AudioParams& params,
+                                                   const rational& chunk_length);
 
 public slots:
   void NodeGraphChanged(NodeInput *source);
@@ -166,7 +172,49 @@ private:
 
   void ClearQueueOfType(RenderTicket::Type type);
 
-  void SetHashes(FrameHashCache* cache, const QVector<rational>& times, const QVector<QByteArray>& hashes, qint64 job_time);
+  void SetHashes(FrameHashCache* cache, DiskCacheFolder* folder, const QVector<rational>& times, const QVector<QByteArray>& hashes, qint64 job_time);
+
+  void AutoCacheSetWindow(const TimeRange& window, const rational& playhead);
+
+  /**
+   * @brief Add invalidated frames to the autocache plan
+   */
+  void AutoCachePlanFrames(const QVector<rational>& frames);
+
+  /**
+   * @brief Rebuild the autocache plan from scratch for the current window
+   */
+  void AutoCacheReplan();
+
+  /**
+   * @brief Queue planned frames, closest to the playhead first, until the autocache has enough in flight
+   */
+  void AutoCacheDispatchFrames();
+
+  /**
+   * @brief Cancel autocache frames that haven't started rendering yet and lie in this range
+   */
+  void AutoCacheCancelQueuedFrames(const TimeRange& range);
+
+  /**
+   * @brief Shared state for the chunks of a sharded Hash() request
+   */
+  struct HashChunkState {
+    QVector<QByteArray> hashes;
+    int remaining;
+    bool cancelled;
+    QMutex lock;
+  };
+
+  /**
+   * @brief Minimum number of frames each worker is given when a Hash() request is split up
+   */
+  static const int kMinimumHashChunkSize;
+
+  /**
+   * @brief Number of autocache frames queued or rendering at once for each worker
+   */
+  static const int kAutoCacheTicketsPerWorker;
 
   ViewerOutput* viewer_node_;
 
@@ -189,8 +237,16 @@ private:
   struct WorkerData {
     RenderWorker* worker;
     bool busy;
+
+    // Where the last audio this worker rendered ended
+    rational audio_out;
   };
 
+  /**
+   * @brief Returns the index of the best available worker for this ticket or -1 if all are busy
+   */
+  int GetWorkerForTicket(RenderTicketPtr ticket) const;
+
   QVector<WorkerData> workers_;
 
   bool autocache_enabled_;
@@ -200,12 +256,11 @@ private:
 
   RenderMode::Mode render_mode_;
 
-  TimeRange autocache_range_;
+  AutoCachePlanner autocache_planner_;
 
-  bool autocache_has_changed_;
+  bool autocache_halted_;
 
   bool use_custom_autocache_range_;
-  TimeRange custom_autocache_range_;
 
   static QVector<RenderBackend*> instances_;
   static QMutex instance_lock_;
@@ -215,7 +270,7 @@ private:
 
   QMap<RenderTicketWatcher*, QVector<rational> > autocache_hash_tasks_;
 
-  QList<QFutureWatcher<void>*> autocache_hash_process_tasks_;
+  QMap<QFutureWatcher<void>*, QVector<rational> > autocache_hash_process_tasks_;
 
   QMap<RenderTicketWatcher*, TimeRange> autocache_audio_tasks_;
 
@@ -223,7 +278,7 @@ private:
 
   QMap<QFutureWatcher<bool>*, QByteArray> autocache_video_download_tasks_;
 
-  QVector<QByteArray> autocache_currently_caching_hashes_;
+  QSet<QByteArray> autocache_currently_caching_hashes_;
 
   bool ignore_next_mouse_button_;
 
@@ -238,6 +293,10 @@ private slots:
 
   void AutoCacheVideoInvalidated(const OLIVE_NAMESPACE::TimeRange &range);
 
+  void AutoCacheVideoValidated(const OLIVE_NAMESPACE::TimeRange &range);
+
+  void AutoCacheVideoShifted();
+
   void AutoCacheAudioInvalidated(const OLIVE_NAMESPACE::TimeRange &range);
 
   void AutoCacheHashesGenerated();
@@ -20,15 +20,20 @@
 
 #include "renderworker.h"
 
+#include <algorithm>
+#include <cstring>
 #include <QDir>
 #include <QThread>
 #include <QTimer>
 
 #include "audio/audiovisualwaveform.h"
 #include "common/functiontimer.h"
-#include "config/config.h"
+#include "common/profiler.h"
 #include "node/block/clip/clip.h"
+#include "project/project.h"
+#include "stillcache.h"
 #include "task/conform/conform.h"
+#include "task/taskmanager.h"
 
 OLIVE_NAMESPACE_ENTER
 
@@ -38,6 +43,7 @@ const int RenderWorker::kMaxDecoderLife = 6000;
 
 RenderWorker::RenderWorker(RenderBackend* parent) :
   parent_(parent),
+  audio_speed_quality_(SampleBuffer::kSpeedQualityHigh),
   video_force_download_resolution_(false),
   available_(true),
   generate_audio_previews_(false),
@@ -58,14 +64,37 @@ RenderWorker::~RenderWorker()
 
 void RenderWorker::Hash(RenderTicketPtr ticket, ViewerOutput *viewer, const QVector<rational> &times)
 {
+  PROFILE_SCOPE_ID("ticket", "Hash", reinterpret_cast<quintptr>(ticket.get()), QString::number(times.size()));
+
   ticket_ = ticket;
 
   QVector<QByteArray> hashes(times.size());
 
+  Node* node = viewer->texture_input()->get_connected_node();
+
+  // Reuse the previous hash for as long as the graph reports it won't change, so that long stretches of
+  // stills, titles and generators are only traversed once
+  QByteArray invariant_hash;
+  TimeRange invariant_range;
+  bool has_invariant_hash = false;
+
   for (int i=0;i<hashes.size();i++) {
-    hashes[i] = HashNode(viewer->texture_input()->get_connected_node(),
-                         video_params_,
-                         times.at(i));
+    const rational& time = times.at(i);
+
+    if (has_invariant_hash
+        && time >= invariant_range.in()
+        && time < invariant_range.out()) {
+      hashes[i] = invariant_hash;
+      continue;
+    }
+
+    hashes[i] = HashNode(node, video_params_, time);
+
+    if (node) {
+      invariant_hash = hashes.at(i);
+      invariant_range = node->GetTimeInvariantRange(time);
+      has_invariant_hash = true;
+    }
   }
 
   ticket->Finish(QVariant::fromValue(hashes));
@@ -89,6 +118,106 @@ QByteArray RenderWorker::HashNode(const Node *n, const VideoParams &params, cons
   return hasher.result();
 }
 
+void RenderWorker::AddKeyField(QCryptographicHash &hasher, const QByteArray &data)
+{
+  int length = data.size();
+
+  hasher.addData(reinterpret_cast<const char*>(&length), sizeof(int));
+  hasher.addData(data);
+}
+
+FramePtr RenderWorker::ConformProxyFrame(FramePtr frame, const VideoParams &params)
+{
+  if (params.effective_width() == frame->width()
+      && params.effective_height() == frame->height()) {
+    frame->set_video_params(params);
+    return frame;
+  }
+
+  FramePtr conformed = Frame::Create();
+  conformed->set_video_params(params);
+  conformed->set_timestamp(frame->timestamp());
+  conformed->allocate();
+
+  if (!conformed->is_allocated()) {
+    return nullptr;
+  }
+
+  int bpp = PixelFormat::BytesPerPixel(params.format());
+  int copy_width = qMin(frame->width(), conformed->width());
+
+  for (int y=0;y<conformed->height();y++) {
+    const char* src = frame->const_data() + qMin(y, frame->height() - 1) * frame->linesize_bytes();
+    char* dst = conformed->data() + y * conformed->linesize_bytes();
+
+    memcpy(dst, src, copy_width * bpp);
+
+    for (int x=copy_width;x<conformed->width();x++) {
+      memcpy(dst + x * bpp, src + (copy_width - 1) * bpp, bpp);
+    }
+  }
+
+  return conformed;
+}
+
+QByteArray RenderWorker::GetStillCacheKey(VideoStreamPtr stream, const rational &time) const
+{
+  QCryptographicHash hasher(QCryptographicHash::Sha1);
+
+  // Source image
+  AddKeyField(hasher, stream->footage()->filename().toUtf8());
+  AddKeyField(hasher, QString::number(stream->footage()->timestamp()).toUtf8());
+  AddKeyField(hasher, QString::number(stream->index()).toUtf8());
+  hasher.addData(reinterpret_cast<const char*>(&time), sizeof(rational));
+
+  // Everything that affects how it's converted into a texture, colorspace names alone are ambiguous across configs
+  if (stream->footage()->project()) {
+    AddKeyField(hasher, stream->footage()->project()->color_manager()->GetConfigFilename().toUtf8());
+  }
+  AddKeyField(hasher, stream->get_colorspace_match_string().toUtf8());
+  AddKeyField(hasher, QString::number(stream->premultiplied_alpha()).toUtf8());
+  hasher.addData(reinterpret_cast<const char*>(&video_params_.divider()), sizeof(int));
+  hasher.addData(reinterpret_cast<const char*>(&video_params_.format()), sizeof(PixelFormat::Format));
+  hasher.addData(reinterpret_cast<const char*>(&render_mode_), sizeof(RenderMode::Mode));
+
+  return hasher.result();
+}
+
+QByteArray RenderWorker::GetGeneratedFrameCacheKey(const Node *node, const GenerateJob &job, PixelFormat::Format format) const
+{
+  QCryptographicHash hasher(QCryptographicHash::Sha1);
+
+  AddKeyField(hasher, node->id().toUtf8());
+
+  // Output frame
+  hasher.addData(reinterpret_cast<const char*>(&video_params_.effective_width()), sizeof(int));
+  hasher.addData(reinterpret_cast<const char*>(&video_params_.effective_height()), sizeof(int));
+  hasher.addData(reinterpret_cast<const char*>(&format), sizeof(PixelFormat::Format));
+
+  // Sort values so the key doesn't depend on hash table ordering
+  const NodeValueMap& values = job.GetValues();
+  QStringList inputs = values.keys();
+  std::sort(inputs.begin(), inputs.end());
+
+  foreach (const QString& input, inputs) {
+    const NodeValue& v = values[input];
+    QByteArray bytes = NodeParam::ValueToBytes(v.type(), v.data());
+
+    if (bytes.isEmpty()
+        && v.type() != NodeParam::kText
+        && v.type() != NodeParam::kFont
+        && v.type() != NodeParam::kFile) {
+      // This value has no persistent representation, so we can't tell whether the frame would be the same
+      return QByteArray();
+    }
+
+    AddKeyField(hasher, input.toUtf8());
+    AddKeyField(hasher, bytes);
+  }
+
+  return hasher.result();
+}
+
 void RenderWorker::ClearOldDecoders()
 {
   QMutexLocker locker(&decoder_lock_);
@@ -109,6 +238,8 @@ void RenderWorker::ClearOldDecoders()
 
 void RenderWorker::RenderFrame(RenderTicketPtr ticket, ViewerOutput* viewer, const rational &time)
 {
+  PROFILE_SCOPE_ID("ticket", "RenderFrame", reinterpret_cast<quintptr>(ticket.get()), time.toString());
+
   ticket_ = ticket;
 
   NodeValueTable table = ProcessInput(viewer->texture_input(),
@@ -135,13 +266,18 @@ void RenderWorker::RenderFrame(RenderTicketPtr ticket, ViewerOutput* viewer, con
                                         video_params_.pixel_aspect_ratio(),
                                         video_params_.interlacing(),
                                         video_params_.divider()));
-    frame->allocate();
+
+    if (texture.isNull()) {
+      // Blank frame out, all blank frames share the same zeroed memory
+      frame->allocate_blank();
+    } else {
+      frame->allocate();
+    }
   }
 
-  if (texture.isNull()) {
-    // Blank frame out
-    memset(frame->data(), 0, frame->allocated_size());
-  } else {
+  if (!texture.isNull()) {
+    PROFILE_SCOPE("render", "TextureToFrame");
+
     // Dump texture contents to frame
     TextureToFrame(texture, frame, video_download_matrix_);
   }
@@ -153,6 +289,8 @@ void RenderWorker::RenderFrame(RenderTicketPtr ticket, ViewerOutput* viewer, con
 
 void RenderWorker::RenderAudio(RenderTicketPtr ticket, ViewerOutput* viewer, const TimeRange &range)
 {
+  PROFILE_SCOPE_ID("ticket", "RenderAudio", reinterpret_cast<quintptr>(ticket.get()), range.in().toString());
+
   ticket_ = ticket;
 
   NodeValueTable table = ProcessInput(viewer->samples_input(), range);
@@ -176,9 +314,8 @@ NodeValueTable RenderWorker::GenerateBlockTable(const TrackOutput *track, const
     QList<Block*> active_blocks = track->BlocksAtTimeRange(range);
 
     // All these blocks will need to output to a buffer so we create one here
-    SampleBufferPtr block_range_buffer = SampleBuffer::CreateAllocated(audio_params_,
-                                                                       audio_params_.time_to_samples(range.length()));
-    block_range_buffer->fill(0);
+    SampleBufferPtr block_range_buffer = SampleBuffer::CreateSilence(audio_params_,
+                                                                     audio_params_.time_to_samples(range.length()));
 
     NodeValueTable merged_table;
 
@@ -207,10 +344,11 @@ NodeValueTable RenderWorker::GenerateBlockTable(const TrackOutput *track, const
 
         if (qIsNull(speed_value)) {
           // Just silence, don't think there's any other practical application of 0 speed audio
-          samples_from_this_block->fill(0);
+          samples_from_this_block = SampleBuffer::CreateSilence(samples_from_this_block->audio_params(),
+                                                                samples_from_this_block->sample_count());
         } else if (!qFuzzyCompare(speed_value, 1.0)) {
           // Multiply time
-          samples_from_this_block->speed(speed_value);
+          samples_from_this_block->speed(speed_value, audio_speed_quality_);
         }
       }
 
@@ -263,11 +401,27 @@ QVariant RenderWorker::ProcessSamples(const Node *node, const TimeRange &range,
   SampleBufferPtr output_buffer = SampleBuffer::CreateAllocated(job.samples()->audio_params(), job.samples()->sample_count());
   NodeValueDatabase value_db;
 
-  for (int i=0;i<job.samples()->sample_count();i++) {
-    // Calculate the exact rational time at this sample
+  // Calculate the exact rational time at each sample
+  QVector<rational> sample_times(job.samples()->sample_count());
+  for (int i=0;i<sample_times.size();i++) {
     double sample_to_second = static_cast<double>(i) / static_cast<double>(audio_params_.sample_rate());
 
-    rational this_sample_time = rational::fromDouble(range.in().toDouble() + sample_to_second);
+    sample_times[i] = rational::fromDouble(range.in().toDouble() + sample_to_second);
+  }
+
+  // Inputs that aren't connected only depend on their own keyframes, so we can build a lookup table
+  // of their values for the whole buffer at once rather than searching keyframes for every sample
+  QHash<QString, QVector<QVariant> > input_lookup_table;
+  for (NodeValueMap::const_iterator j=job.GetValues().constBegin(); j!=job.GetValues().constEnd(); j++) {
+    NodeInput* corresponding_input = node->GetInputWithID(j.key());
+
+    if (corresponding_input && !corresponding_input->is_connected() && !corresponding_input->IsArray()) {
+      input_lookup_table.insert(j.key(), corresponding_input->get_values_at_times(sample_times));
+    }
+  }
+
+  for (int i=0;i<job.samples()->sample_count();i++) {
+    const rational& this_sample_time = sample_times.at(i);
 
     // Update all non-sample and non-footage inputs
     NodeValueMap::const_iterator j;
@@ -275,7 +429,9 @@ QVariant RenderWorker::ProcessSamples(const Node *node, const TimeRange &range,
       NodeValueTable value;
       NodeInput* corresponding_input = node->GetInputWithID(j.key());
 
-      if (corresponding_input) {
+      if (input_lookup_table.contains(j.key())) {
+        value.Push(corresponding_input->data_type(), input_lookup_table.value(j.key()).at(i), node);
+      } else if (corresponding_input) {
         value = ProcessInput(corresponding_input, TimeRange(this_sample_time, this_sample_time));
       } else {
         value.Push(j.value());
@@ -313,11 +469,28 @@ QVariant RenderWorker::ProcessFrameGeneration(const Node* node, const GenerateJo
                                       video_params_.pixel_aspect_ratio(),
                                       video_params_.interlacing(),
                                       video_params_.divider()));
+  // Generated frames are usually the same for long stretches (e.g. a title), so share them between workers
+  QByteArray cache_key = StillCache::instance() ? GetGeneratedFrameCacheKey(node, job, output_fmt) : QByteArray();
+
+  if (!cache_key.isEmpty()) {
+    QVariant cached = StillCache::instance()->Get(cache_key);
+
+    if (!cached.isNull()) {
+      return cached;
+    }
+  }
+
   frame->allocate();
 
   node->GenerateFrame(frame, job);
 
-  return CachedFrameToTexture(frame);
+  QVariant value = CachedFrameToTexture(frame);
+
+  if (!cache_key.isEmpty() && !value.isNull()) {
+    StillCache::instance()->Insert(cache_key, value, frame->allocated_size());
+  }
+
+  return value;
 }
 
 QVariant RenderWorker::GetCachedFrame(const Node* node, const rational& time)
@@ -381,6 +554,38 @@ QVariant RenderWorker::ProcessVideoFootage(StreamPtr stream, const rational &inp
   QVariant value;
   bool found_cache = false;
 
+  if (video_stream->video_type() != VideoStream::kVideoTypeVideo && StillCache::instance()) {
+    // Stills and image sequence frames are shared between all workers
+    QByteArray cache_key = GetStillCacheKey(video_stream, time_match);
+
+    value = StillCache::instance()->Get(cache_key);
+
+    if (value.isNull()) {
+      DecoderPtr decoder = ResolveDecoderFromInput(stream);
+
+      if (decoder) {
+        FramePtr frame;
+
+        {
+          PROFILE_SCOPE_DETAIL("decoder", "RetrieveVideo", stream->footage()->name());
+
+          frame = decoder->RetrieveVideo(input_time,
+                                         video_params().divider());
+        }
+
+        if (frame) {
+          value = FootageFrameToTexture(stream, frame);
+
+          if (!value.isNull()) {
+            StillCache::instance()->Insert(cache_key, value, frame->allocated_size());
+          }
+        }
+      }
+    }
+
+    return value;
+  }
+
   if (still_image_cache_.contains(stream.get())) {
     const CachedStill& cs = still_image_cache_[stream.get()];
 
@@ -397,11 +602,46 @@ QVariant RenderWorker::ProcessVideoFootage(StreamPtr stream, const rational &inp
 
   if (!found_cache) {
 
-    DecoderPtr decoder = ResolveDecoderFromInput(stream);
+    // Offline renders can decode from a low resolution proxy instead, which is cheaper to decode
+    // and already close to the size we're going to display it at
+    VideoStreamPtr proxy_stream = nullptr;
+    int proxy_divider = 1;
+
+    if (render_mode_ == RenderMode::kOffline
+        && video_stream->video_type() == VideoStream::kVideoTypeVideo) {
+      proxy_stream = video_stream->proxy_stream();
+
+      if (proxy_stream) {
+        proxy_divider = video_stream->proxy_divider();
+      }
+    }
+
+    DecoderPtr decoder = ResolveDecoderFromInput(proxy_stream ? proxy_stream : stream);
 
     if (decoder) {
-      FramePtr frame = decoder->RetrieveVideo(input_time,
-                                              video_params().divider());
+      int decode_divider = qMax(1, video_params().divider() / proxy_divider);
+
+      FramePtr frame;
+
+      {
+        PROFILE_SCOPE_DETAIL("decoder", "RetrieveVideo", stream->footage()->name());
+
+        frame = decoder->RetrieveVideo(input_time,
+                                       decode_divider);
+      }
+
+      if (frame && proxy_stream) {
+        // Present the proxy frame as the original stream at a larger divider so the rest of the
+        // pipeline sizes it the same as a full resolution frame
+        int total_divider = decode_divider * proxy_divider;
+
+        frame = ConformProxyFrame(frame, VideoParams(video_stream->width(),
+                                                     video_stream->height(),
+                                                     frame->video_params().format(),
+                                                     video_stream->pixel_aspect_ratio(),
+                                                     video_stream->interlacing(),
+                                                     total_divider));
+      }
 
       if (frame) {
         // Return a texture from the derived class
@@ -433,35 +673,35 @@ QVariant RenderWorker::ProcessAudioFootage(StreamPtr stream, const TimeRange &in
     // See if we have a conformed version of this audio
     if (!decoder->HasConformedVersion(audio_params())) {
 
-      // If not, the audio needs to be conformed
-      // For online rendering/export, it's a waste of time to render the audio until we have
-      // all we need, so we try to handle the conform ourselves
+      // If not, start conforming it in the background (unless something else already is). In the
+      // meantime, the decoder will decode the ranges we ask for straight from the file so we
+      // don't have to wait for the whole file to conform before playing it.
       AudioStreamPtr as = std::static_pointer_cast<AudioStream>(stream);
 
-      // Check if any other threads are conforming this audio
       if (as->try_start_conforming(audio_params())) {
+        ConformTask* conform_task = new ConformTask(as, audio_params());
+
+        // TaskManager is only safe to use from the main thread
+        conform_task->moveToThread(TaskManager::instance()->thread());
+        QMetaObject::invokeMethod(TaskManager::instance(),
+                                  "AddTask",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(Task*, conform_task));
+      }
 
-        // If not, conform it ourselves
-        decoder->ConformAudio(&IsCancelled(), audio_params());
-
-      } else {
+    }
 
-        // If another thread is conforming already, hackily try to wait until it's done.
-        do {
-          QThread::msleep(1000);
-        } while (!as->has_conformed_version(audio_params()) && !IsCancelled());
+    SampleBufferPtr frame;
 
-      }
+    {
+      PROFILE_SCOPE_DETAIL("decoder", "RetrieveAudio", stream->footage()->name());
 
+      frame = decoder->RetrieveAudio(input_time.in(), input_time.length(),
+                                     audio_params());
     }
 
-    if (decoder->HasConformedVersion(audio_params())) {
-      SampleBufferPtr frame = decoder->RetrieveAudio(input_time.in(), input_time.length(),
-                                                     audio_params());
-
-      if (frame) {
-        value = QVariant::fromValue(frame);
-      }
+    if (frame) {
+      value = QVariant::fromValue(frame);
     }
   }
 
@@ -21,6 +21,7 @@
 #ifndef RENDERWORKER_H
 #define RENDERWORKER_H
 
+#include <QCryptographicHash>
 #include <QMatrix4x4>
 
 #include "decodercache.h"
@@ -60,6 +61,11 @@ public:
     audio_params_ = params;
   }
 
+  void SetAudioSpeedQuality(SampleBuffer::SpeedQuality quality)
+  {
+    audio_speed_quality_ = quality;
+  }
+
   void SetForceDownloadResolution(bool e)
   {
     video_force_download_resolution_ = e;
@@ -158,6 +164,35 @@ private:
 
   static QByteArray HashNode(const Node* n, const VideoParams& params, const rational& time);
 
+  /**
+   * @brief Add variable-length data to a cache key preceded by its length
+   *
+   * Without the length, different sequences of fields could produce the same bytes and therefore the same key.
+   */
+  static void AddKeyField(QCryptographicHash& hasher, const QByteArray& data);
+
+  /**
+   * @brief Present a frame decoded from a proxy as if it came from the original stream
+   *
+   * The proxy's dimensions were rounded when it was transcoded, so it may be a pixel or two off the
+   * size the original would be at the same divider. In that case, the frame is copied into one of
+   * the expected size, cropping or repeating the edge pixels.
+   */
+  static FramePtr ConformProxyFrame(FramePtr frame, const VideoParams& params);
+
+  /**
+   * @brief Key for a still image or image sequence frame in the shared StillCache
+   */
+  QByteArray GetStillCacheKey(VideoStreamPtr stream, const rational& time) const;
+
+  /**
+   * @brief Key for a generated frame in the shared StillCache
+   *
+   * Returns an empty array if the job depends on values that can't be hashed (e.g. textures), in which case the
+   * frame shouldn't be cached.
+   */
+  QByteArray GetGeneratedFrameCacheKey(const Node* node, const GenerateJob& job, PixelFormat::Format format) const;
+
   RenderBackend* parent_;
 
   RenderTicketPtr ticket_;
@@ -166,6 +201,11 @@ private:
 
   AudioParams audio_params_;
 
+  SampleBuffer::SpeedQuality audio_speed_quality_;
+
+  /**
+   * @brief Most recent video frame for each stream (stills and image sequences go in the shared StillCache instead)
+   */
   struct CachedStill {
     QVariant texture;
     QString colorspace;
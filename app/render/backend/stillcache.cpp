@@ -0,0 +1,132 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "stillcache.h"
+
+OLIVE_NAMESPACE_ENTER
+
+StillCache* StillCache::instance_ = nullptr;
+
+// Default to 512 MB, enough for a few dozen UHD RGBA float stills
+const qint64 StillCache::kDefaultLimit = 536870912;
+
+StillCache::StillCache() :
+  total_size_(0),
+  limit_(kDefaultLimit),
+  access_counter_(0)
+{
+}
+
+void StillCache::CreateInstance()
+{
+  instance_ = new StillCache();
+}
+
+void StillCache::DestroyInstance()
+{
+  delete instance_;
+  instance_ = nullptr;
+}
+
+StillCache *StillCache::instance()
+{
+  return instance_;
+}
+
+QVariant StillCache::Get(const QByteArray &key)
+{
+  QMutexLocker locker(&lock_);
+
+  QHash<QByteArray, Entry>::iterator i = entries_.find(key);
+
+  if (i == entries_.end()) {
+    return QVariant();
+  }
+
+  i->last_access = ++access_counter_;
+
+  return i->value;
+}
+
+void StillCache::Insert(const QByteArray &key, const QVariant &value, qint64 size)
+{
+  QMutexLocker locker(&lock_);
+
+  if (size > limit_) {
+    // Would evict everything else and still not fit
+    return;
+  }
+
+  QHash<QByteArray, Entry>::iterator existing = entries_.find(key);
+
+  if (existing != entries_.end()) {
+    // Another worker got here first, keep theirs
+    existing->last_access = ++access_counter_;
+    return;
+  }
+
+  entries_.insert(key, {value, size, ++access_counter_});
+  total_size_ += size;
+
+  EvictToLimit();
+}
+
+void StillCache::Clear()
+{
+  QMutexLocker locker(&lock_);
+
+  entries_.clear();
+  total_size_ = 0;
+}
+
+qint64 StillCache::GetLimit()
+{
+  QMutexLocker locker(&lock_);
+
+  return limit_;
+}
+
+void StillCache::SetLimit(qint64 limit)
+{
+  QMutexLocker locker(&lock_);
+
+  limit_ = limit;
+
+  EvictToLimit();
+}
+
+void StillCache::EvictToLimit()
+{
+  while (total_size_ > limit_ && !entries_.isEmpty()) {
+    // Find least recently used entry
+    QHash<QByteArray, Entry>::iterator oldest = entries_.begin();
+
+    for (QHash<QByteArray, Entry>::iterator i=entries_.begin(); i!=entries_.end(); i++) {
+      if (i->last_access < oldest->last_access) {
+        oldest = i;
+      }
+    }
+
+    total_size_ -= oldest->size;
+    entries_.erase(oldest);
+  }
+}
+
+OLIVE_NAMESPACE_EXIT
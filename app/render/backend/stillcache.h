@@ -0,0 +1,103 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef STILLCACHE_H
+#define STILLCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVariant>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Process-wide cache of rendered still images and generated frames
+ *
+ * Every RenderWorker previously kept its own still image, so each worker decoded and uploaded the same still
+ * separately. This cache is shared by all workers and keyed by a hash of everything that determines the frame's
+ * content, so changing a node's inputs changes the key and stale entries simply age out.
+ *
+ * Entries are evicted least-recently-used first once the total size exceeds the memory budget. All functions are
+ * thread-safe.
+ */
+class StillCache
+{
+public:
+  static void CreateInstance();
+
+  static void DestroyInstance();
+
+  static StillCache* instance();
+
+  DISABLE_COPY_MOVE(StillCache)
+
+  /**
+   * @brief Retrieve a cached value, or a null QVariant if there is none for this key
+   */
+  QVariant Get(const QByteArray& key);
+
+  /**
+   * @brief Store a value along with the number of bytes it occupies
+   */
+  void Insert(const QByteArray& key, const QVariant& value, qint64 size);
+
+  /**
+   * @brief Remove all entries
+   *
+   * Entries hold backend resources (e.g. textures), so this must be called before the backend is torn down.
+   */
+  void Clear();
+
+  qint64 GetLimit();
+
+  void SetLimit(qint64 limit);
+
+private:
+  StillCache();
+
+  void EvictToLimit();
+
+  struct Entry {
+    QVariant value;
+    qint64 size;
+    quint64 last_access;
+  };
+
+  static StillCache* instance_;
+
+  static const qint64 kDefaultLimit;
+
+  QMutex lock_;
+
+  QHash<QByteArray, Entry> entries_;
+
+  qint64 total_size_;
+
+  qint64 limit_;
+
+  quint64 access_counter_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // STILLCACHE_H
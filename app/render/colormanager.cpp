@@ -118,6 +118,9 @@ void ColorManager::SetConfigInternal(const QString &filename)
   }
 
   config_ = cfg;
+
+  // Processors for the old config are keyed by its cache ID, so they'd never be looked up again
+  ColorProcessor::ClearCache();
 }
 
 void ColorManager::SetDefaultInputColorSpaceInternal(const QString &s)
@@ -20,12 +20,59 @@
 
 #include "colorprocessor.h"
 
+#include <QtConcurrent/QtConcurrent>
+
 #include "common/define.h"
 #include "colormanager.h"
 
 OLIVE_NAMESPACE_ENTER
 
+// Below this many rows per band, the overhead of dispatching outweighs the conversion itself
+const int ColorProcessor::kMinimumRowsPerBand = 32;
+
+// Far more than a project uses at once, but each config, colorspace, display, view and look is its own processor
+const int ColorProcessor::kMaximumCachedProcessors = 128;
+
+QMutex ColorProcessor::processor_cache_lock_;
+QCache<QString, OCIO::ConstProcessorRcPtr> ColorProcessor::processor_cache_(kMaximumCachedProcessors);
+
 ColorProcessor::ColorProcessor(ColorManager *config, const QString &input, const ColorTransform &transform)
+{
+  processor_ = GetCachedProcessor(config, input, transform);
+}
+
+OCIO::ConstProcessorRcPtr ColorProcessor::GetCachedProcessor(ColorManager *config, const QString &input, const ColorTransform &transform)
+{
+  // The config's cache ID changes whenever its contents do, so a reloaded config never picks up stale processors
+  QString key = QStringLiteral("%1:%2:%3:%4:%5:%6").arg(QString::fromUtf8(config->GetConfig()->getCacheID()),
+                                                        input,
+                                                        QString::number(transform.is_display()),
+                                                        transform.output(),
+                                                        transform.view(),
+                                                        transform.look());
+
+  QMutexLocker locker(&processor_cache_lock_);
+
+  OCIO::ConstProcessorRcPtr* cached = processor_cache_.object(key);
+
+  if (cached) {
+    return *cached;
+  }
+
+  OCIO::ConstProcessorRcPtr processor = CreateProcessor(config, input, transform);
+  processor_cache_.insert(key, new OCIO::ConstProcessorRcPtr(processor));
+
+  return processor;
+}
+
+void ColorProcessor::ClearCache()
+{
+  QMutexLocker locker(&processor_cache_lock_);
+
+  processor_cache_.clear();
+}
+
+OCIO::ConstProcessorRcPtr ColorProcessor::CreateProcessor(ColorManager *config, const QString &input, const ColorTransform &transform)
 {
   const QString& output = (transform.output().isEmpty()) ? config->GetDefaultDisplay() : transform.output();
 
@@ -45,28 +92,56 @@ ColorProcessor::ColorProcessor(ColorManager *config, const QString &input, const
     }
 
     OCIO_SET_C_LOCALE_FOR_SCOPE;
-    processor_ = config->GetConfig()->getProcessor(display_transform);
+    return config->GetConfig()->getProcessor(display_transform);
 
   } else {
 
     OCIO_SET_C_LOCALE_FOR_SCOPE;
-    processor_ = config->GetConfig()->getProcessor(input.toUtf8(),
-                                                   output.toUtf8());
+    return config->GetConfig()->getProcessor(input.toUtf8(),
+                                             output.toUtf8());
 
   }
 }
 
 void ColorProcessor::ConvertFrame(Frame *f)
 {
-  OCIO::PackedImageDesc img(reinterpret_cast<float*>(f->data()),
+  int band_count = qMin(QThread::idealThreadCount(), f->height() / kMinimumRowsPerBand);
+
+  if (band_count <= 1) {
+    ConvertRows(f, 0, f->height(), processor_);
+    return;
+  }
+
+  // OCIO processors are safe to apply from several threads at once, so split the frame into bands of
+  // scanlines and convert them in parallel
+  QVector<int> band_starts(band_count);
+  int rows_per_band = f->height() / band_count;
+
+  for (int i=0;i<band_count;i++) {
+    band_starts[i] = i * rows_per_band;
+  }
+
+  OCIO::ConstProcessorRcPtr processor = processor_;
+
+  QtConcurrent::blockingMap(band_starts, [f, rows_per_band, band_count, processor](const int& start) {
+    // Last band picks up any remainder
+    int end = (start == (band_count - 1) * rows_per_band) ? f->height() : start + rows_per_band;
+
+    ConvertRows(f, start, end, processor);
+  });
+}
+
+void ColorProcessor::ConvertRows(Frame *f, int start, int end, OCIO::ConstProcessorRcPtr processor)
+{
+  OCIO::PackedImageDesc img(reinterpret_cast<float*>(f->data() + start * f->linesize_bytes()),
                             f->width(),
-                            f->height(),
+                            end - start,
                             PixelFormat::ChannelCount(f->format()),
                             OCIO::AutoStride,
                             OCIO::AutoStride,
                             f->linesize_bytes());
 
-  processor_->apply(img);
+  processor->apply(img);
 }
 
 Color ColorProcessor::ConvertColor(Color in)
@@ -21,6 +21,9 @@
 #ifndef COLORPROCESSOR_H
 #define COLORPROCESSOR_H
 
+#include <QCache>
+#include <QMutex>
+
 #include "codec/frame.h"
 #include "render/color.h"
 #include "render/colortransform.h"
@@ -48,12 +51,43 @@ public:
 
   OCIO::ConstProcessorRcPtr GetProcessor();
 
+  /**
+   * @brief Convert a float frame in place
+   *
+   * Large frames are split into bands of scanlines that are converted in parallel.
+   */
   void ConvertFrame(FramePtr f);
   void ConvertFrame(Frame* f);
 
   Color ConvertColor(Color in);
 
+  /**
+   * @brief Drop every cached OCIO processor, called when a config is replaced since its processors won't be used again
+   */
+  static void ClearCache();
+
 private:
+  /**
+   * @brief Retrieve a previously built OCIO processor for this transform or build (and store) a new one
+   *
+   * OCIO processors are immutable and expensive to build, so every ColorProcessor for the same transform shares
+   * one.
+   */
+  static OCIO::ConstProcessorRcPtr GetCachedProcessor(ColorManager* config, const QString& input, const ColorTransform& transform);
+
+  static OCIO::ConstProcessorRcPtr CreateProcessor(ColorManager* config, const QString& input, const ColorTransform& transform);
+
+  static void ConvertRows(Frame* f, int start, int end, OCIO::ConstProcessorRcPtr processor);
+
+  static const int kMinimumRowsPerBand;
+
+  static const int kMaximumCachedProcessors;
+
+  static QMutex processor_cache_lock_;
+
+  // Least recently used processors are dropped once there are more than kMaximumCachedProcessors
+  static QCache<QString, OCIO::ConstProcessorRcPtr> processor_cache_;
+
   OCIO::ConstProcessorRcPtr processor_;
 
 };
@@ -210,6 +210,7 @@ bool DiskCacheFolder::ClearCache()
     // We return a false result if any of the files fail to delete, but still try to delete as many as we can
     if (QFile::remove(i->file_name) || !QFileInfo::exists(i->file_name)) {
       emit DeletedFrame(path_, i->hash);
+      RemoveFromIndex(i->hash);
       i = disk_data_.erase(i);
     } else {
       qWarning() << "Failed to delete" << i->file_name;
@@ -247,6 +248,7 @@ void DiskCacheFolder::CreatedFile(const QString &file_name, const QByteArray &ha
   qint64 file_size = QFile(file_name).size();
 
   disk_data_.push_back({file_name, hash, file_size});
+  AddToIndex(hash);
 
   consumption_ += file_size;
 
@@ -272,6 +274,9 @@ void DiskCacheFolder::SetPath(const QString &path)
       emit DeletedFrame(path_, h.hash);
     }
     disk_data_.clear();
+
+    QMutexLocker locker(&hash_index_lock_);
+    hash_index_.clear();
   }
 
   // Set defaults
@@ -307,6 +312,7 @@ void DiskCacheFolder::SetPath(const QString &path)
       if (QFileInfo::exists(h.file_name)) {
         consumption_ += h.file_size;
         disk_data_.push_back(h);
+        AddToIndex(h.hash);
       }
     }
 
@@ -318,6 +324,7 @@ QByteArray DiskCacheFolder::DeleteLeastRecent()
 {
   HashTime h = disk_data_.front();
   disk_data_.pop_front();
+  RemoveFromIndex(h.hash);
 
   QFile::remove(h.file_name);
 
@@ -326,6 +333,37 @@ QByteArray DiskCacheFolder::DeleteLeastRecent()
   return h.hash;
 }
 
+QVector<bool> DiskCacheFolder::ContainsHashes(const QVector<QByteArray> &hashes)
+{
+  QVector<bool> exists(hashes.size());
+
+  QMutexLocker locker(&hash_index_lock_);
+
+  for (int i=0;i<hashes.size();i++) {
+    exists[i] = hash_index_.contains(hashes.at(i));
+  }
+
+  return exists;
+}
+
+void DiskCacheFolder::AddToIndex(const QByteArray &hash)
+{
+  QMutexLocker locker(&hash_index_lock_);
+
+  hash_index_[hash]++;
+}
+
+void DiskCacheFolder::RemoveFromIndex(const QByteArray &hash)
+{
+  QMutexLocker locker(&hash_index_lock_);
+
+  QHash<QByteArray, int>::iterator i = hash_index_.find(hash);
+
+  if (i != hash_index_.end() && --i.value() == 0) {
+    hash_index_.erase(i);
+  }
+}
+
 void DiskCacheFolder::CloseCacheFolder()
 {
   if (path_.isEmpty()) {
@@ -21,6 +21,7 @@
 #ifndef DISKMANAGER_H
 #define DISKMANAGER_H
 
+#include <QHash>
 #include <QMap>
 #include <QMutex>
 #include <QObject>
@@ -45,6 +46,14 @@ public:
 
   void CreatedFile(const QString& file_name, const QByteArray& hash);
 
+  /**
+   * @brief Check which of a list of hashes have a frame in this cache folder
+   *
+   * Uses the in-memory index rather than the filesystem, so it's fast enough to call for thousands of frames.
+   * Thread-safe.
+   */
+  QVector<bool> ContainsHashes(const QVector<QByteArray>& hashes);
+
   const QString& GetPath() const
   {
     return path_;
@@ -78,6 +87,10 @@ signals:
 private:
   QByteArray DeleteLeastRecent();
 
+  void AddToIndex(const QByteArray& hash);
+
+  void RemoveFromIndex(const QByteArray& hash);
+
   void CloseCacheFolder();
 
   QString path_;
@@ -92,6 +105,13 @@ private:
 
   std::list<HashTime> disk_data_;
 
+  /**
+   * @brief Number of entries in disk_data_ for each hash, for fast lookups from other threads
+   */
+  QHash<QByteArray, int> hash_index_;
+
+  QMutex hash_index_lock_;
+
   qint64 consumption_;
 
   qint64 limit_;
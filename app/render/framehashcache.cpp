@@ -29,6 +29,7 @@
 
 #include "codec/frame.h"
 #include "common/filefunctions.h"
+#include "common/profiler.h"
 #include "common/timecodefunctions.h"
 #include "render/diskmanager.h"
 
@@ -97,6 +98,11 @@ void FrameHashCache::ValidateFramesWithHash(const QByteArray &hash)
   }
 }
 
+bool FrameHashCache::IsFrameInvalidated(const rational &time)
+{
+  return GetInvalidatedRanges().ContainsTimeRange(TimeRange(time, time + timebase_));
+}
+
 QList<rational> FrameHashCache::GetFramesWithHash(const QByteArray &hash)
 {
   QList<rational> times;
@@ -213,7 +219,8 @@ bool FrameHashCache::SaveCacheFrame(const QByteArray& hash,
 bool FrameHashCache::SaveCacheFrame(const QByteArray &hash, FramePtr frame) const
 {
   if (frame) {
-    return SaveCacheFrame(hash, frame->data(), frame->video_params(), frame->linesize_bytes());
+    // Saving only reads the data, so use const_data() to avoid giving blank frames a buffer of their own
+    return SaveCacheFrame(hash, const_cast<char*>(frame->const_data()), frame->video_params(), frame->linesize_bytes());
   } else {
     qWarning() << "Attempted to save a NULL frame to the cache. This may or may not be desirable.";
     return false;
@@ -232,6 +239,8 @@ FramePtr FrameHashCache::LoadCacheFrame(const QByteArray &hash) const
 
 FramePtr FrameHashCache::LoadCacheFrame(const QString &fn)
 {
+  PROFILE_SCOPE_DETAIL("cache", "LoadCacheFrame", QFileInfo(fn).fileName());
+
   FramePtr frame = nullptr;
 
   if (!fn.isEmpty() && QFileInfo::exists(fn)) {
@@ -406,6 +415,8 @@ QString FrameHashCache::CachePathName(const QString &cache_path, const QByteArra
 
 bool FrameHashCache::SaveCacheFrame(const QString &filename, char *data, const VideoParams &vparam, int linesize_bytes) const
 {
+  PROFILE_SCOPE_DETAIL("cache", "SaveCacheFrame", QFileInfo(filename).fileName());
+
   Q_ASSERT(PixelFormat::FormatIsFloat(vparam.format()));
 
   // Floating point types are stored in EXR
@@ -43,6 +43,11 @@ public:
 
   void ValidateFramesWithHash(const QByteArray& hash);
 
+  /**
+   * @brief Returns whether the frame at this time is invalidated and still needs to be rendered
+   */
+  bool IsFrameInvalidated(const rational& time);
+
   /**
    * @brief Returns a list of frames that use a particular hash
    */
@@ -49,7 +49,7 @@ public:
     return invalidated_.isEmpty();
   }
 
-  const TimeRangeList& GetInvalidatedRanges()
+  const TimeRangeList& GetInvalidatedRanges() const
   {
     return invalidated_;
   }
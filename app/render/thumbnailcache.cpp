@@ -0,0 +1,505 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "thumbnailcache.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QtConcurrent/QtConcurrent>
+
+#include "common/filefunctions.h"
+#include "common/timecodefunctions.h"
+#include "project/item/footage/footage.h"
+#include "project/project.h"
+#include "render/pixelformat.h"
+
+OLIVE_NAMESPACE_ENTER
+
+ThumbnailCache* ThumbnailCache::instance_ = nullptr;
+
+const int ThumbnailCache::kThumbnailHeight = 72;
+
+// Scrolling through a long timeline can ask for far more than we can decode, only the most recent requests matter
+const int ThumbnailCache::kMaximumQueueSize = 256;
+
+const int ThumbnailCache::kMaximumOpenDecoders = 4;
+
+// Spacing of thumbnails in media time, requests are snapped to this so zooming in doesn't create new tiles
+const rational ThumbnailCache::kTileInterval = rational(1, 2);
+
+// Each atlas holds every tile generated for a stream, so only keep the ones that are being looked at in memory
+const int ThumbnailCache::kMaximumLoadedAtlases = 32;
+
+// Per project cache folder
+const qint64 ThumbnailCache::kMaximumDiskUsage = Q_INT64_C(256) * 1024 * 1024;
+
+// "OTHB", followed by a version number
+const quint32 kAtlasMagic = 0x4F544842;
+const quint32 kAtlasVersion = 1;
+
+ThumbnailCache::ThumbnailCache() :
+  // Roughly 1700 decoded thumbnails (cost is in KB)
+  decoded_tiles_(65536),
+  worker_running_(false)
+{
+  // Thumbnails are a low priority, one thread is plenty and leaves the rest for rendering
+  thread_pool_.setMaxThreadCount(1);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+  {
+    QMutexLocker locker(&lock_);
+
+    queue_.clear();
+    queued_keys_.clear();
+  }
+
+  thread_pool_.waitForDone();
+
+  foreach (DecoderPtr d, decoders_) {
+    d->Close();
+  }
+}
+
+void ThumbnailCache::CreateInstance()
+{
+  instance_ = new ThumbnailCache();
+}
+
+void ThumbnailCache::DestroyInstance()
+{
+  delete instance_;
+  instance_ = nullptr;
+}
+
+ThumbnailCache *ThumbnailCache::instance()
+{
+  return instance_;
+}
+
+QImage ThumbnailCache::GetThumbnail(VideoStreamPtr stream, const rational &time)
+{
+  QString atlas_filename = GetAtlasFilename(stream);
+
+  if (atlas_filename.isEmpty()) {
+    return QImage();
+  }
+
+  int64_t timestamp = 0;
+
+  if (stream->video_type() != VideoStream::kVideoTypeStill) {
+    timestamp = qMax(int64_t(0), Timecode::time_to_timestamp(time, stream->frame_rate().flipped()));
+
+    // Snap to the tile grid
+    int64_t interval = qMax(int64_t(1), Timecode::time_to_timestamp(kTileInterval, stream->frame_rate().flipped()));
+    timestamp -= timestamp % interval;
+  }
+
+  QMutexLocker locker(&lock_);
+
+  if (atlases_.contains(atlas_filename)) {
+    // Done before looking up the atlas since this may unload others
+    TouchAtlas(atlas_filename);
+  }
+
+  QHash<QString, Atlas>::iterator atlas = atlases_.find(atlas_filename);
+
+  if (atlas == atlases_.end() || !atlas->loaded || !atlas->tiles.contains(timestamp)) {
+    QString key = GetTileKey(atlas_filename, timestamp);
+
+    if (!queued_keys_.contains(key)
+        && !failed_keys_.contains(key)
+        && !failed_atlases_.contains(atlas_filename)) {
+      queue_.append({stream, atlas_filename, timestamp});
+      queued_keys_.insert(key);
+
+      if (queue_.size() > kMaximumQueueSize) {
+        Request dropped = queue_.takeFirst();
+        queued_keys_.remove(GetTileKey(dropped.atlas_filename, dropped.timestamp));
+      }
+
+      if (!worker_running_) {
+        worker_running_ = true;
+        QtConcurrent::run(&thread_pool_, this, &ThumbnailCache::ProcessQueue);
+      }
+    }
+  }
+
+  if (atlas == atlases_.end() || !atlas->loaded || atlas->tiles.isEmpty()) {
+    return QImage();
+  }
+
+  // Use the closest thumbnail we have until the exact one is ready
+  QMap<int64_t, QByteArray>::const_iterator tile = atlas->tiles.lowerBound(timestamp);
+
+  if (tile == atlas->tiles.constEnd()
+      || (tile.key() != timestamp && tile != atlas->tiles.constBegin())) {
+    tile--;
+  }
+
+  QString key = GetTileKey(atlas_filename, tile.key());
+
+  QImage* cached = decoded_tiles_.object(key);
+
+  if (cached) {
+    return *cached;
+  }
+
+  QImage decoded = QImage::fromData(tile.value(), "JPG");
+  decoded_tiles_.insert(key, new QImage(decoded), decoded.byteCount() / 1024);
+
+  return decoded;
+}
+
+QImage ThumbnailCache::GetPosterFrame(VideoStreamPtr stream)
+{
+  return GetThumbnail(stream, 0);
+}
+
+QString ThumbnailCache::GetAtlasFilename(VideoStreamPtr stream)
+{
+  Footage* footage = stream->footage();
+
+  if (!footage->project()) {
+    return QString();
+  }
+
+  QString stream_key = QStringLiteral("%1:%2:%3").arg(footage->project()->cache_path(),
+                                                      footage->filename(),
+                                                      QString::number(stream->index()));
+
+  {
+    QMutexLocker locker(&lock_);
+
+    QHash<QString, QString>::const_iterator existing = atlas_filenames_.constFind(stream_key);
+
+    if (existing != atlas_filenames_.constEnd()) {
+      return existing.value();
+    }
+  }
+
+  QString id = FileFunctions::GetUniqueFileIdentifier(footage->filename());
+
+  // If the file is missing this caches an empty filename, so painting a missing clip doesn't hit the disk every time
+  QString atlas_filename;
+
+  if (!id.isEmpty()) {
+    QDir thumbnail_dir(QDir(footage->project()->cache_path()).filePath(QStringLiteral("thumbnails")));
+
+    atlas_filename = thumbnail_dir.filePath(QStringLiteral("%1.%2.thumbs").arg(id, QString::number(stream->index())));
+  }
+
+  QMutexLocker locker(&lock_);
+  atlas_filenames_.insert(stream_key, atlas_filename);
+
+  return atlas_filename;
+}
+
+void ThumbnailCache::TouchAtlas(const QString &atlas_filename)
+{
+  atlas_lru_.removeOne(atlas_filename);
+  atlas_lru_.append(atlas_filename);
+
+  while (atlas_lru_.size() > kMaximumLoadedAtlases) {
+    // Tiles are still on disk, so this atlas will just be loaded again if it's needed
+    atlases_.remove(atlas_lru_.takeFirst());
+  }
+}
+
+void ThumbnailCache::PruneAtlasFolder(const QString &folder, const QString &keep)
+{
+  // Newest first
+  QFileInfoList entries = QDir(folder).entryInfoList({QStringLiteral("*.thumbs")}, QDir::Files, QDir::Time);
+
+  qint64 total = 0;
+
+  foreach (const QFileInfo& info, entries) {
+    total += info.size();
+
+    if (total > kMaximumDiskUsage && info.absoluteFilePath() != QFileInfo(keep).absoluteFilePath()) {
+      QFile::remove(info.absoluteFilePath());
+      total -= info.size();
+    }
+  }
+}
+
+QString ThumbnailCache::GetTileKey(const QString &atlas_filename, int64_t timestamp)
+{
+  return QStringLiteral("%1:%2").arg(atlas_filename, QString::number(timestamp));
+}
+
+void ThumbnailCache::ProcessQueue()
+{
+  forever {
+    Request r;
+
+    {
+      QMutexLocker locker(&lock_);
+
+      if (queue_.isEmpty()) {
+        worker_running_ = false;
+        return;
+      }
+
+      // Newest requests are most likely what's currently on screen
+      r = queue_.takeLast();
+    }
+
+    QString key = GetTileKey(r.atlas_filename, r.timestamp);
+
+    LoadAtlas(r.atlas_filename);
+
+    bool exists;
+
+    {
+      QMutexLocker locker(&lock_);
+
+      exists = atlases_.value(r.atlas_filename).tiles.contains(r.timestamp);
+
+      if (exists) {
+        queued_keys_.remove(key);
+      }
+    }
+
+    if (!exists) {
+      bool stream_failed = false;
+      QByteArray tile = GenerateTile(r, &stream_failed);
+
+      if (!tile.isEmpty()) {
+        AppendTileToAtlas(r.atlas_filename, r.timestamp, tile);
+      }
+
+      QMutexLocker locker(&lock_);
+
+      if (!tile.isEmpty()) {
+        atlases_[r.atlas_filename].tiles.insert(r.timestamp, tile);
+        TouchAtlas(r.atlas_filename);
+      } else if (stream_failed) {
+        failed_atlases_.insert(r.atlas_filename);
+      } else {
+        failed_keys_.insert(key);
+      }
+
+      queued_keys_.remove(key);
+
+      if (tile.isEmpty()) {
+        // Nothing changed, so there's nothing to repaint
+        continue;
+      }
+    }
+
+    emit ThumbnailsUpdated();
+  }
+}
+
+void ThumbnailCache::LoadAtlas(const QString &atlas_filename)
+{
+  {
+    QMutexLocker locker(&lock_);
+
+    if (atlases_.value(atlas_filename).loaded) {
+      return;
+    }
+  }
+
+  QMap<int64_t, QByteArray> tiles;
+
+  QFile file(atlas_filename);
+
+  if (file.open(QFile::ReadOnly)) {
+    QDataStream ds(&file);
+    ds.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version;
+    ds >> magic >> version;
+
+    if (magic == kAtlasMagic && version == kAtlasVersion) {
+      while (!ds.atEnd()) {
+        qint64 timestamp;
+        QByteArray tile;
+
+        ds >> timestamp >> tile;
+
+        if (ds.status() != QDataStream::Ok) {
+          // Last record was only partially written, keep everything before it
+          break;
+        }
+
+        tiles.insert(timestamp, tile);
+      }
+    }
+
+    file.close();
+  }
+
+  QMutexLocker locker(&lock_);
+
+  Atlas& atlas = atlases_[atlas_filename];
+
+  TouchAtlas(atlas_filename);
+
+  // Keep any tiles that were added while we were reading
+  for (QMap<int64_t, QByteArray>::const_iterator i=atlas.tiles.constBegin(); i!=atlas.tiles.constEnd(); i++) {
+    tiles.insert(i.key(), i.value());
+  }
+
+  atlas.tiles = tiles;
+  atlas.loaded = true;
+}
+
+QByteArray ThumbnailCache::GenerateTile(const Request &r, bool *stream_failed)
+{
+  // A proxy is already small and cheap to decode, so prefer it
+  VideoStreamPtr source = r.stream->proxy_stream();
+
+  if (!source) {
+    source = r.stream;
+  }
+
+  DecoderPtr decoder = GetDecoder(source);
+
+  if (!decoder) {
+    *stream_failed = true;
+    return QByteArray();
+  }
+
+  // Decode at the coarsest divider that's still at least as tall as the thumbnail
+  int divider = qMax(1, source->height() / kThumbnailHeight);
+
+  rational time = 0;
+
+  if (r.stream->video_type() != VideoStream::kVideoTypeStill) {
+    time = Timecode::timestamp_to_time(r.timestamp, r.stream->frame_rate().flipped());
+  }
+
+  FramePtr frame = decoder->RetrieveVideo(time, divider);
+
+  if (!frame) {
+    return QByteArray();
+  }
+
+  // Treat the divided frame as full size so it can be converted like any other
+  frame->set_video_params(VideoParams(frame->width(),
+                                      frame->height(),
+                                      frame->format()));
+
+  frame = PixelFormat::ConvertPixelFormat(frame, PixelFormat::PIX_FMT_RGBA8);
+
+  if (!frame) {
+    return QByteArray();
+  }
+
+  QImage image(reinterpret_cast<const uchar*>(frame->const_data()),
+               frame->width(),
+               frame->height(),
+               frame->linesize_bytes(),
+               QImage::Format_RGBA8888);
+
+  int thumbnail_width = qMax(1, qRound(static_cast<double>(frame->width())
+                                       * r.stream->pixel_aspect_ratio().toDouble()
+                                       * kThumbnailHeight / frame->height()));
+
+  // JPEG has no alpha channel anyway
+  QImage thumbnail = image.scaled(thumbnail_width,
+                                  kThumbnailHeight,
+                                  Qt::IgnoreAspectRatio,
+                                  Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB888);
+
+  QByteArray tile;
+  QBuffer buffer(&tile);
+  buffer.open(QBuffer::WriteOnly);
+  thumbnail.save(&buffer, "JPG", 80);
+
+  // Save the GUI thread from decoding the tile we just encoded
+  QMutexLocker locker(&lock_);
+  decoded_tiles_.insert(GetTileKey(r.atlas_filename, r.timestamp),
+                        new QImage(thumbnail),
+                        thumbnail.byteCount() / 1024);
+
+  return tile;
+}
+
+void ThumbnailCache::AppendTileToAtlas(const QString &atlas_filename, int64_t timestamp, const QByteArray &tile)
+{
+  QDir().mkpath(QFileInfo(atlas_filename).path());
+
+  QFile file(atlas_filename);
+
+  if (!file.open(QFile::Append)) {
+    qWarning() << "Failed to write thumbnail atlas" << atlas_filename;
+    return;
+  }
+
+  QDataStream ds(&file);
+  ds.setVersion(QDataStream::Qt_5_6);
+
+  bool new_atlas = (file.size() == 0);
+
+  if (new_atlas) {
+    ds << kAtlasMagic << kAtlasVersion;
+  }
+
+  ds << static_cast<qint64>(timestamp) << tile;
+
+  file.close();
+
+  if (new_atlas) {
+    // Starting a new atlas is rare, so it's a good time to make room for it
+    PruneAtlasFolder(QFileInfo(atlas_filename).path(), atlas_filename);
+  }
+}
+
+DecoderPtr ThumbnailCache::GetDecoder(VideoStreamPtr stream)
+{
+  for (int i=0; i<decoders_.size(); i++) {
+    if (decoders_.at(i)->stream() == stream) {
+      // Move to the back so the least recently used is always first
+      DecoderPtr d = decoders_.takeAt(i);
+      decoders_.append(d);
+      return d;
+    }
+  }
+
+  DecoderPtr decoder = Decoder::CreateFromID(stream->footage()->decoder());
+
+  if (!decoder) {
+    return nullptr;
+  }
+
+  decoder->set_stream(stream);
+
+  if (!decoder->Open()) {
+    qWarning() << "Failed to open decoder for thumbnails of" << stream->footage()->filename();
+    return nullptr;
+  }
+
+  if (decoders_.size() == kMaximumOpenDecoders) {
+    decoders_.takeFirst()->Close();
+  }
+
+  decoders_.append(decoder);
+
+  return decoder;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,176 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+
+#include "codec/decoder.h"
+#include "project/item/footage/videostream.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Background service providing small preview images of footage
+ *
+ * Thumbnails are decoded at a coarse divider on a dedicated thread so neither the GUI thread nor the render workers
+ * ever wait on them. Each stream's thumbnails are stored in a compact atlas file in the project's cache folder, keyed
+ * by the source file and the frame's timestamp, so they only need to be decoded once.
+ *
+ * Thumbnails are generated on a fixed grid (see kTileInterval) regardless of how they're requested, so the number of
+ * tiles per stream is bounded no matter how far the timeline is zoomed in. Only the most recently used atlases are
+ * kept in memory and on disk.
+ *
+ * Requesting a thumbnail that isn't ready yet queues it and returns the nearest thumbnail that is, or a null image.
+ * ThumbnailsUpdated() is emitted whenever new thumbnails become available. All functions are thread-safe.
+ */
+class ThumbnailCache : public QObject
+{
+  Q_OBJECT
+public:
+  static void CreateInstance();
+
+  static void DestroyInstance();
+
+  static ThumbnailCache* instance();
+
+  /**
+   * @brief Get a thumbnail of a stream at a given time (in the stream's own time)
+   */
+  QImage GetThumbnail(VideoStreamPtr stream, const rational& time);
+
+  /**
+   * @brief Get the thumbnail used to represent a stream as a whole (e.g. in the project explorer)
+   */
+  QImage GetPosterFrame(VideoStreamPtr stream);
+
+  /**
+   * @brief Height in pixels that all thumbnails are generated at
+   */
+  static const int kThumbnailHeight;
+
+signals:
+  void ThumbnailsUpdated();
+
+private:
+  ThumbnailCache();
+
+  virtual ~ThumbnailCache() override;
+
+  struct Atlas {
+    Atlas() :
+      loaded(false)
+    {
+    }
+
+    bool loaded;
+    QMap<int64_t, QByteArray> tiles;
+  };
+
+  struct Request {
+    VideoStreamPtr stream;
+    QString atlas_filename;
+    int64_t timestamp;
+  };
+
+  QString GetAtlasFilename(VideoStreamPtr stream);
+
+  /**
+   * @brief Mark an atlas as most recently used, unloading the least recently used ones if there are too many
+   *
+   * Must be called with the lock held.
+   */
+  void TouchAtlas(const QString& atlas_filename);
+
+  /**
+   * @brief Delete the least recently written atlases in a folder until it's back under kMaximumDiskUsage
+   */
+  static void PruneAtlasFolder(const QString& folder, const QString& keep);
+
+  static QString GetTileKey(const QString& atlas_filename, int64_t timestamp);
+
+  void ProcessQueue();
+
+  void LoadAtlas(const QString& atlas_filename);
+
+  /**
+   * @brief Decode and compress a tile, returning an empty QByteArray if it couldn't be generated
+   *
+   * `stream_failed` is set if nothing can be generated for this stream at all (e.g. its decoder won't open).
+   */
+  QByteArray GenerateTile(const Request& r, bool* stream_failed);
+
+  void AppendTileToAtlas(const QString& atlas_filename, int64_t timestamp, const QByteArray& tile);
+
+  DecoderPtr GetDecoder(VideoStreamPtr stream);
+
+  static ThumbnailCache* instance_;
+
+  static const int kMaximumQueueSize;
+
+  static const int kMaximumOpenDecoders;
+
+  static const rational kTileInterval;
+
+  static const int kMaximumLoadedAtlases;
+
+  static const qint64 kMaximumDiskUsage;
+
+  QMutex lock_;
+
+  QHash<QString, Atlas> atlases_;
+
+  // Loaded atlases, least recently used first
+  QList<QString> atlas_lru_;
+
+  // Identifying a file means hitting the disk, so we only do it once per file, even if it's missing (an empty
+  // filename). Keys include the footage's filename so relinking is picked up.
+  QHash<QString, QString> atlas_filenames_;
+
+  QCache<QString, QImage> decoded_tiles_;
+
+  QList<Request> queue_;
+
+  QSet<QString> queued_keys_;
+
+  // Tiles and atlases that failed to generate, these aren't queued again so broken clips don't keep the worker
+  // decoding and the GUI repainting forever
+  QSet<QString> failed_keys_;
+  QSet<QString> failed_atlases_;
+
+  bool worker_running_;
+
+  QThreadPool thread_pool_;
+
+  // Only accessed from the worker, of which there's only ever one at a time
+  QList<DecoderPtr> decoders_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // THUMBNAILCACHE_H
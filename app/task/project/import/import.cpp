@@ -22,6 +22,7 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QtConcurrent/QtConcurrent>
 
 #include "config/config.h"
 #include "core.h"
@@ -67,6 +68,8 @@ bool ProjectImportTask::Run()
 
 void ProjectImportTask::Import(Folder *folder, QFileInfoList import, int &counter, QUndoCommand* parent_command)
 {
+  QHash<QString, FootagePtr> probed = ProbeFilesInParallel(import);
+
   for (int i=0; i<import.size(); i++) {
     if (IsCancelled()) {
       break;
@@ -110,8 +113,16 @@ void ProjectImportTask::Import(Folder *folder, QFileInfoList import, int &counte
 
     } else {
 
-      FootagePtr item = Decoder::ProbeMedia(model_->project(), file_info.absoluteFilePath(),
-                                            &IsCancelled());
+      FootagePtr item;
+
+      QHash<QString, FootagePtr>::const_iterator probed_item = probed.constFind(file_info.absoluteFilePath());
+
+      if (probed_item != probed.constEnd()) {
+        item = probed_item.value();
+      } else {
+        item = Decoder::ProbeMedia(model_->project(), file_info.absoluteFilePath(),
+                                   &IsCancelled());
+      }
 
       if (item) {
         // See if this footage is an image sequence
@@ -135,6 +146,45 @@ void ProjectImportTask::Import(Folder *folder, QFileInfoList import, int &counte
   }
 }
 
+QHash<QString, FootagePtr> ProjectImportTask::ProbeFilesInParallel(const QFileInfoList &import)
+{
+  struct ProbeJob {
+    QString filename;
+    FootagePtr footage;
+  };
+
+  QVector<ProbeJob> jobs;
+
+  foreach (const QFileInfo& file_info, import) {
+    // Files that may be part of an image sequence are probed when they're reached instead, since
+    // most of them will be folded into the sequence and never need probing
+    if (!file_info.isDir()
+        && Decoder::GetImageSequenceDigitCount(file_info.absoluteFilePath()) == 0) {
+      jobs.append({file_info.absoluteFilePath(), nullptr});
+    }
+  }
+
+  QHash<QString, FootagePtr> results;
+
+  if (jobs.size() < 2) {
+    return results;
+  }
+
+  Project* project = model_->project();
+  const QAtomicInt* cancelled = &IsCancelled();
+
+  // ProbeMedia() moves the streams it creates off the pool threads to the main thread
+  QtConcurrent::blockingMap(jobs, [project, cancelled](ProbeJob& job){
+    job.footage = Decoder::ProbeMedia(project, job.filename, cancelled);
+  });
+
+  foreach (const ProbeJob& job, jobs) {
+    results.insert(job.filename, job.footage);
+  }
+
+  return results;
+}
+
 void ProjectImportTask::ValidateImageSequence(ItemPtr item, QFileInfoList& info_list, int index)
 {
   // Heuristically determine whether this file is part of an image sequence or not
@@ -59,6 +59,11 @@ protected:
 private:
   void Import(Folder* folder, QFileInfoList import, int& counter, QUndoCommand *parent_command);
 
+  /**
+   * @brief Probe every file in a directory listing at once rather than one at a time
+   */
+  QHash<QString, FootagePtr> ProbeFilesInParallel(const QFileInfoList& import);
+
   void ValidateImageSequence(ItemPtr item, QFileInfoList &info_list, int index);
 
   static bool ItemIsStillImageFootageOnly(ItemPtr item);
@@ -22,6 +22,7 @@
 
 #include <QApplication>
 #include <QFile>
+#include <QtConcurrent/QtConcurrent>
 #include <QXmlStreamReader>
 
 #include "common/xmlutils.h"
@@ -35,6 +36,15 @@ ProjectLoadTask::ProjectLoadTask(const QString &filename) :
 }
 
 bool ProjectLoadTask::Run()
+{
+  if (ProjectContainer::IsContainer(GetFilename())) {
+    return LoadBinary();
+  } else {
+    return LoadXml();
+  }
+}
+
+bool ProjectLoadTask::LoadXml()
 {
   QFile project_file(GetFilename());
 
@@ -45,15 +55,7 @@ bool ProjectLoadTask::Run()
       if (reader.name() == QStringLiteral("olive")) {
         while(XMLReadNextStartElement(&reader)) {
           if (reader.name() == QStringLiteral("version")) {
-            uint project_version = reader.readElementText().toUInt();
-
-            if (project_version > Core::kProjectVersion) {
-              // Project is newer than we support
-              SetError(tr("This project is newer than this version of Olive and cannot be opened."));
-              return false;
-            } else if (project_version < 201003) { // Change this if we drop support for a project version
-              // Project is older than we support
-              SetError(tr("This project is from a version of Olive that is no longer supported in this version."));
+            if (!CheckProjectVersion(reader.readElementText().toUInt())) {
               return false;
             }
           } else if (reader.name() == QStringLiteral("url")) {
@@ -99,4 +101,151 @@ bool ProjectLoadTask::Run()
   }
 }
 
+bool ProjectLoadTask::LoadBinary()
+{
+  ProjectContainer::Header header;
+
+  {
+    QFile project_file(GetFilename());
+
+    if (!project_file.open(QFile::ReadOnly)) {
+      SetError(tr("Failed to read file \"%1\" for reading.").arg(GetFilename()));
+      return false;
+    }
+
+    if (!ProjectContainer::ReadHeader(&project_file, &header)) {
+      SetError(tr("Failed to read the header of \"%1\".").arg(GetFilename()));
+      return false;
+    }
+  }
+
+  if (!CheckProjectVersion(header.project_version)) {
+    return false;
+  }
+
+  project_saved_url_ = header.url;
+
+  int project_section = -1;
+
+  for (int i=0;i<header.sections.size();i++) {
+    if (header.sections.at(i).type == ProjectContainer::kProjectSection) {
+      project_section = i;
+      break;
+    }
+  }
+
+  if (project_section == -1) {
+    SetError(tr("\"%1\" does not contain a project.").arg(GetFilename()));
+    return false;
+  }
+
+  // Sequences' graphs are independent of each other, so they can all be parsed at once
+  QList<QFuture<LoadedSequence> > sequence_futures;
+
+  foreach (const ProjectContainer::Section& section, header.sections) {
+    if (section.type == ProjectContainer::kSequenceSection) {
+      sequence_futures.append(QtConcurrent::run(&ProjectLoadTask::LoadSequence,
+                                                GetFilename(),
+                                                section,
+                                                &IsCancelled()));
+    }
+  }
+
+  // Sequences are placed in the tree by the project section, which also connects their footage
+  XMLNodeData xml_node_data;
+  QString sequence_error;
+
+  for (int i=0;i<sequence_futures.size();i++) {
+    // Wait for every sequence even if one fails since they all reference our cancelled flag
+    LoadedSequence loaded = sequence_futures.at(i).result();
+
+    if (loaded.error.isEmpty()) {
+      xml_node_data.preloaded_items.insert(loaded.id, loaded.sequence);
+      xml_node_data.footage_connections.append(loaded.footage_connections);
+    } else if (sequence_error.isEmpty()) {
+      sequence_error = loaded.error;
+    }
+
+    emit ProgressChanged(double(i + 1) / double(sequence_futures.size() + 1));
+  }
+
+  if (!sequence_error.isEmpty()) {
+    SetError(sequence_error);
+    return false;
+  }
+
+  QByteArray project_xml = ProjectContainer::ReadSection(GetFilename(), header.sections.at(project_section));
+  QXmlStreamReader reader(project_xml);
+
+  while (XMLReadNextStartElement(&reader)) {
+    if (reader.name() == QStringLiteral("project")) {
+      project_ = std::make_shared<Project>();
+
+      project_->set_filename(GetFilename());
+
+      project_->Load(&reader, xml_node_data, &layout_info_, &IsCancelled());
+
+      // Ensure project is in main thread
+      project_->moveToThread(qApp->thread());
+    } else {
+      reader.skipCurrentElement();
+    }
+  }
+
+  emit ProgressChanged(1);
+
+  if (reader.hasError()) {
+    SetError(reader.errorString());
+    return false;
+  } else {
+    return true;
+  }
+}
+
+bool ProjectLoadTask::CheckProjectVersion(uint project_version)
+{
+  if (project_version > Core::kProjectVersion) {
+    // Project is newer than we support
+    SetError(tr("This project is newer than this version of Olive and cannot be opened."));
+    return false;
+  } else if (project_version < 201003) { // Change this if we drop support for a project version
+    // Project is older than we support
+    SetError(tr("This project is from a version of Olive that is no longer supported in this version."));
+    return false;
+  }
+
+  return true;
+}
+
+ProjectLoadTask::LoadedSequence ProjectLoadTask::LoadSequence(const QString &filename, const ProjectContainer::Section &section, const QAtomicInt *cancelled)
+{
+  LoadedSequence loaded;
+
+  loaded.id = section.id;
+
+  QByteArray xml = ProjectContainer::ReadSection(filename, section);
+  QXmlStreamReader reader(xml);
+
+  while (XMLReadNextStartElement(&reader)) {
+    if (reader.name() == QStringLiteral("sequence")) {
+      XMLNodeData xml_node_data;
+
+      loaded.sequence = std::make_shared<Sequence>();
+      loaded.sequence->Load(&reader, xml_node_data, cancelled);
+
+      loaded.footage_connections = xml_node_data.footage_connections;
+    } else {
+      reader.skipCurrentElement();
+    }
+  }
+
+  if (reader.hasError()) {
+    loaded.error = reader.errorString();
+  } else if (!loaded.sequence) {
+    loaded.error = tr("Failed to read a sequence from \"%1\".").arg(filename);
+  }
+
+  return loaded;
+}
+
 OLIVE_NAMESPACE_EXIT
@@ -22,6 +22,8 @@
 #define PROJECTLOADMANAGER_H
 
 #include "loadbasetask.h"
+#include "project/item/sequence/sequence.h"
+#include "project/projectcontainer.h"
 #include "window/mainwindow/mainwindowlayoutinfo.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -35,6 +37,28 @@ public:
 protected:
   virtual bool Run() override;
 
+private:
+  bool LoadXml();
+
+  /**
+   * @brief Load a ProjectContainer, parsing every sequence's section in parallel
+   */
+  bool LoadBinary();
+
+  bool CheckProjectVersion(uint project_version);
+
+  struct LoadedSequence {
+    quint64 id;
+    SequencePtr sequence;
+    QList<XMLNodeData::FootageConnection> footage_connections;
+    QString error;
+  };
+
+  /**
+   * @brief Parse a single sequence section, thread-safe so sequences can be loaded in parallel
+   */
+  static LoadedSequence LoadSequence(const QString& filename, const ProjectContainer::Section& section, const QAtomicInt* cancelled);
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -20,72 +20,173 @@
 
 #include "save.h"
 
-#include <QDir>
-#include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrent>
 #include <QXmlStreamWriter>
 
-#include "common/filefunctions.h"
+#include "config/config.h"
 #include "core.h"
+#include "project/projectcontainer.h"
 
 OLIVE_NAMESPACE_ENTER
 
 ProjectSaveTask::ProjectSaveTask(ProjectPtr project) :
-  project_(project)
+  project_(project),
+  binary_(Config::Current()["BinaryProjects"].toBool())
 {
   SetTitle(tr("Saving '%1'").arg(project->filename()));
 }
 
 bool ProjectSaveTask::Run()
 {
-  // File to temporarily save to (ensures we can't half-write the user's main file and crash)
-  QString temp_save = QDir(FileFunctions::GetTempFilePath()).filePath(QStringLiteral("tempsv"));
+  // Writes to a temporary file next to the original and renames it over the original once it's
+  // complete, so we can't half-write the user's main file and crash
+  QSaveFile project_file(project_->filename());
 
-  QFile project_file(temp_save);
+  QIODevice::OpenMode mode = QIODevice::WriteOnly;
+  if (!binary_) {
+    mode |= QIODevice::Text;
+  }
+
+  if (!project_file.open(mode)) {
+    SetError(tr("Failed to open file \"%1\" for writing.").arg(project_->filename()));
+    return false;
+  }
 
-  if (project_file.open(QFile::WriteOnly | QFile::Text)) {
-    QXmlStreamWriter writer(&project_file);
-    writer.setAutoFormatting(true);
+  if (!(binary_ ? WriteBinary(&project_file) : WriteXml(&project_file))) {
+    project_file.cancelWriting();
+    return false;
+  }
 
-    writer.writeStartDocument();
+  if (!project_file.commit()) {
+    SetError(tr("Failed to write to \"%1\".").arg(project_->filename()));
+    return false;
+  }
+
+  return true;
+}
+
+bool ProjectSaveTask::WriteXml(QIODevice *device)
+{
+  QXmlStreamWriter writer(device);
+  writer.setAutoFormatting(true);
+
+  writer.writeStartDocument();
+
+  writer.writeStartElement("olive");
 
-    writer.writeStartElement("olive");
+  // Version is stored in YYMMDD from whenever the project format was last changed
+  // Allows easy integer math for checking project versions.
+  writer.writeTextElement("version", QString::number(Core::kProjectVersion));
 
-    // Version is stored in YYMMDD from whenever the project format was last changed
-    // Allows easy integer math for checking project versions.
-    writer.writeTextElement("version", QString::number(Core::kProjectVersion));
+  writer.writeTextElement("url", project_->filename());
+
+  writer.writeStartElement(QStringLiteral("project"));
+
+  project_->Save(&writer);
+
+  writer.writeEndElement(); // project
+
+  writer.writeEndElement(); // olive
+
+  writer.writeEndDocument();
+
+  if (writer.hasError()) {
+    SetError(tr("Failed to write XML data"));
+    return false;
+  }
+
+  return true;
+}
+
+bool ProjectSaveTask::WriteBinary(QIODevice *device)
+{
+  QList<ItemPtr> sequences = project_->get_items_of_type(Item::kSequence);
+
+  // Sequences' graphs are independent of each other so they can be serialized in parallel
+  QList<QFuture<QByteArray> > sequence_futures;
+
+  foreach (ItemPtr item, sequences) {
+    sequence_futures.append(QtConcurrent::run(&ProjectSaveTask::SerializeSequence,
+                                              static_cast<const Sequence*>(item.get())));
+  }
 
-    writer.writeTextElement("url", project_->filename());
+  // Everything else goes in the project section, with sequences only placed in the tree
+  QByteArray project_xml;
+  bool project_failed;
+
+  {
+    QXmlStreamWriter writer(&project_xml);
+
+    writer.writeStartDocument();
 
     writer.writeStartElement(QStringLiteral("project"));
 
-    project_->Save(&writer);
+    project_->Save(&writer, false);
 
     writer.writeEndElement(); // project
 
-    writer.writeEndElement(); // olive
-
     writer.writeEndDocument();
 
-    project_file.close();
+    project_failed = writer.hasError();
+  }
 
-    if (writer.hasError()) {
-      SetError(tr("Failed to write XML data"));
-      return false;
-    }
+  QVector<ProjectContainer::Section> sections;
+  QVector<QByteArray> section_data;
+
+  sections.append({ProjectContainer::kProjectSection, 0, 0, 0});
+  section_data.append(ProjectContainer::PackSection(project_xml));
+
+  bool sequences_failed = false;
 
-    // Save was successful, we can now rewrite the original file
-    QFile original(project_->filename());
-    if ((!original.exists() || original.remove())
-        && QFile::copy(temp_save, project_->filename())) {
-      return true;
-    } else {
-      SetError(tr("Failed to write to \"%1\".").arg(project_->filename()));
-      return false;
+  for (int i=0;i<sequences.size();i++) {
+    quint64 id = reinterpret_cast<quintptr>(static_cast<const Sequence*>(sequences.at(i).get()));
+
+    // Always wait for every future, the sequences are still being read from
+    QByteArray data = sequence_futures.at(i).result();
+
+    if (data.isEmpty()) {
+      sequences_failed = true;
     }
-  } else {
-    SetError(tr("Failed to open file \"%1\" for writing.").arg(project_->filename()));
+
+    sections.append({ProjectContainer::kSequenceSection, id, 0, 0});
+    section_data.append(data);
+  }
+
+  if (project_failed || sequences_failed) {
+    SetError(tr("Failed to write XML data"));
+    return false;
+  }
+
+  if (!ProjectContainer::Write(device, Core::kProjectVersion, project_->filename(), sections, section_data)) {
+    SetError(tr("Failed to write to \"%1\".").arg(project_->filename()));
     return false;
   }
+
+  return true;
+}
+
+QByteArray ProjectSaveTask::SerializeSequence(const Sequence *sequence)
+{
+  QByteArray xml;
+
+  QXmlStreamWriter writer(&xml);
+
+  writer.writeStartDocument();
+
+  writer.writeStartElement(QStringLiteral("sequence"));
+
+  sequence->Save(&writer);
+
+  writer.writeEndElement(); // sequence
+
+  writer.writeEndDocument();
+
+  if (writer.hasError()) {
+    return QByteArray();
+  }
+
+  return ProjectContainer::PackSection(xml);
 }
 
 OLIVE_NAMESPACE_EXIT
@@ -21,6 +21,7 @@
 #ifndef PROJECTSAVEMANAGER_H
 #define PROJECTSAVEMANAGER_H
 
+#include "project/item/sequence/sequence.h"
 #include "project/project.h"
 #include "task/task.h"
 
@@ -41,8 +42,25 @@ protected:
   virtual bool Run() override;
 
 private:
+  bool WriteXml(QIODevice* device);
+
+  /**
+   * @brief Write the project as a ProjectContainer
+   */
+  bool WriteBinary(QIODevice* device);
+
+  /**
+   * @brief Serialize and pack a sequence's section, thread-safe so sequences can be done in parallel
+   *
+   * Returns an empty QByteArray on failure.
+   */
+  static QByteArray SerializeSequence(const Sequence* sequence);
+
   ProjectPtr project_;
 
+  // Read from the config when the task is created, since Run() happens on another thread
+  bool binary_;
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,176 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "proxy.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "codec/decoder.h"
+#include "codec/encoder.h"
+#include "common/filefunctions.h"
+#include "common/timecodefunctions.h"
+#include "project/project.h"
+
+OLIVE_NAMESPACE_ENTER
+
+ProxyTask::ProxyTask(VideoStreamPtr stream, int divider) :
+  stream_(stream),
+  divider_(divider)
+{
+  SetTitle(tr("Creating Proxy %1:%2").arg(stream_->footage()->filename(), QString::number(stream_->index())));
+}
+
+QString ProxyTask::GetProxyFilename(VideoStreamPtr stream, int divider)
+{
+  QString name = QStringLiteral("%1.%2.proxy%3.mov").arg(FileFunctions::GetUniqueFileIdentifier(stream->footage()->filename()),
+                                                          QString::number(stream->index()),
+                                                          QString::number(divider));
+
+  return QDir(stream->footage()->project()->cache_path()).filePath(name);
+}
+
+bool ProxyTask::Run()
+{
+  if (stream_->footage()->decoder().isEmpty()) {
+    SetError(tr("Failed to find decoder to create proxy"));
+    return false;
+  }
+
+  DecoderPtr decoder = Decoder::CreateFromID(stream_->footage()->decoder());
+
+  decoder->set_stream(stream_);
+
+  if (!decoder->Open()) {
+    SetError(tr("Failed to open decoder"));
+    return false;
+  }
+
+  QString proxy_filename = GetProxyFilename(stream_, divider_);
+
+  // Write somewhere else first so a cancelled or failed proxy never replaces a good one
+  QString temp_filename = proxy_filename;
+  temp_filename.append(QStringLiteral(".tmp.mov"));
+
+  QDir(QFileInfo(proxy_filename).path()).mkpath(QStringLiteral("."));
+
+  rational frame_timebase = stream_->frame_rate().flipped();
+
+  int64_t frame_count = Timecode::time_to_timestamp(Timecode::timestamp_to_time(stream_->duration(),
+                                                                                stream_->timebase()),
+                                                    frame_timebase);
+
+  Encoder* encoder = nullptr;
+  bool success = true;
+
+  for (int64_t i=0; i<frame_count; i++) {
+    if (IsCancelled()) {
+      success = false;
+      break;
+    }
+
+    rational time = Timecode::timestamp_to_time(i, frame_timebase);
+
+    FramePtr frame = decoder->RetrieveVideo(time, divider_);
+
+    if (!frame) {
+      SetError(tr("Failed to decode frame %1").arg(i));
+      success = false;
+      break;
+    }
+
+    if (!encoder) {
+      // We don't know what format the decoder will give us until the first frame, so we open the
+      // encoder lazily
+      EncodingParams params;
+
+      params.SetFilename(temp_filename);
+
+      // ProRes is intra-only, and the Proxy profile is about as cheap to decode as it gets
+      params.EnableVideo(VideoParams(frame->width(),
+                                     frame->height(),
+                                     frame_timebase,
+                                     frame->format(),
+                                     stream_->pixel_aspect_ratio(),
+                                     stream_->interlacing()),
+                         ExportCodec::kCodecProRes);
+
+      if (PixelFormat::FormatHasAlphaChannel(frame->format())) {
+        // Proxy profile can't store alpha, 4444 is the cheapest one that can
+        params.set_video_option(QStringLiteral("profile"), QStringLiteral("4444"));
+        params.set_video_pix_fmt(QStringLiteral("yuva444p10le"));
+      } else {
+        params.set_video_option(QStringLiteral("profile"), QStringLiteral("proxy"));
+        params.set_video_pix_fmt(QStringLiteral("yuv422p10le"));
+      }
+
+      params.SetExportLength(Timecode::timestamp_to_time(frame_count, frame_timebase));
+
+      encoder = Encoder::CreateFromID(QStringLiteral("ffmpeg"), params);
+
+      if (!encoder->Open()) {
+        SetError(tr("Failed to open file"));
+        success = false;
+        break;
+      }
+    }
+
+    if (!encoder->WriteFrame(frame, time)) {
+      SetError(tr("Failed to write frame %1").arg(i));
+      success = false;
+      break;
+    }
+
+    emit ProgressChanged(static_cast<double>(i + 1) / static_cast<double>(frame_count));
+  }
+
+  decoder->Close();
+
+  if (encoder) {
+    encoder->Close();
+    delete encoder;
+  }
+
+  if (success && frame_count == 0) {
+    SetError(tr("Stream has no frames"));
+    success = false;
+  }
+
+  if (success) {
+    // Swap the finished file into place
+    QFile::remove(proxy_filename);
+
+    if (!QFile::rename(temp_filename, proxy_filename)) {
+      SetError(tr("Failed to move proxy into place"));
+      success = false;
+    }
+  }
+
+  if (success) {
+    stream_->set_proxy(proxy_filename, divider_);
+  } else {
+    QFile::remove(temp_filename);
+  }
+
+  return success;
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,58 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROXYTASK_H
+#define PROXYTASK_H
+
+#include "project/item/footage/videostream.h"
+#include "task/task.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Transcodes a video stream into a low resolution intra-only proxy
+ *
+ * Every frame of a proxy can be decoded on its own, so offline playback of it doesn't pay for
+ * decoding the rest of the GOP when seeking. Once the proxy is written it's linked to the stream
+ * with VideoStream::set_proxy().
+ */
+class ProxyTask : public Task
+{
+public:
+  ProxyTask(VideoStreamPtr stream, int divider);
+
+  /**
+   * @brief Returns the filename the proxy for this stream at this divider is written to
+   */
+  static QString GetProxyFilename(VideoStreamPtr stream, int divider);
+
+protected:
+  virtual bool Run() override;
+
+private:
+  VideoStreamPtr stream_;
+
+  int divider_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // PROXYTASK_H
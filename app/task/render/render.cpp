@@ -21,15 +21,23 @@
 #include "render.h"
 
 #include "common/timecodefunctions.h"
+#include "config/config.h"
 
 OLIVE_NAMESPACE_ENTER
 
+// Enough to keep several workers busy without holding much of a long export's audio in memory
+const int RenderTask::kAudioLaneCount = 4;
+
 RenderTask::RenderTask(ViewerOutput* viewer, const VideoParams &vparams, const AudioParams &aparams)
 {
   backend_ = new OpenGLBackend();
   backend_->SetViewerNode(viewer);
   backend_->SetVideoParams(vparams);
   backend_->SetAudioParams(aparams);
+
+  disk_cache_folder_ = DiskManager::instance()->GetOpenFolder(viewer->video_frame_cache()->GetCacheDirectory());
+
+  audio_chunk_length_ = Config::Current()["AudioChunkLength"].value<rational>();
 }
 
 RenderTask::~RenderTask()
@@ -52,11 +60,23 @@ struct HashFrameFuturePair {
   RenderTicketPtr frame_future;
 };
 
-struct RangeSampleFuturePair {
+struct AudioLane {
+  std::list<TimeRange> chunks;
   TimeRange range;
   RenderTicketPtr sample_future;
 };
 
+bool AudioLanesBusy(const std::vector<AudioLane>& lanes)
+{
+  for (const AudioLane& lane : lanes) {
+    if (lane.sample_future || !lane.chunks.empty()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 struct HashDownloadFuturePair {
   QByteArray hash;
   QFuture<void> download_future;
@@ -71,14 +91,26 @@ void RenderTask::Render(const TimeRangeList& video_range,
   double total_length = 0;
   double video_frame_sz = video_params().time_base().toDouble();
 
-  std::list<TimeRange> audio_queue;
-  std::list<RangeSampleFuturePair> audio_lookup_table;
+  // Audio is split into a few lanes of consecutive chunks and each lane only has one chunk in
+  // flight at a time. Memory use stays flat however long the range is, and since each chunk a lane
+  // requests follows on from the last, the backend can give it to the worker whose decoders are
+  // already at the right position.
+  std::vector<AudioLane> audio_lanes;
   if (!audio_range.isEmpty()) {
+    std::vector<TimeRange> chunks;
+
     foreach (const TimeRange& r, audio_range) {
       total_length += r.length().toDouble();
 
-      std::list<TimeRange> ranges = RenderBackend::SplitRangeIntoChunks(r);
-      audio_queue.insert(audio_queue.end(), ranges.begin(), ranges.end());
+      std::list<TimeRange> ranges = RenderBackend::SplitRangeIntoChunks(r, audio_params(), audio_chunk_length());
+      chunks.insert(chunks.end(), ranges.begin(), ranges.end());
+    }
+
+    int lane_count = qMin(kAudioLaneCount, static_cast<int>(chunks.size()));
+    audio_lanes.resize(lane_count);
+
+    for (size_t i=0; i<chunks.size(); i++) {
+      audio_lanes[(i * lane_count) / chunks.size()].chunks.push_back(chunks.at(i));
     }
   }
 
@@ -110,17 +142,37 @@ void RenderTask::Render(const TimeRangeList& video_range,
   // Iterators
   std::list<HashFrameFuturePair>::iterator i;
   std::list<HashDownloadFuturePair>::iterator j;
-  std::list<RangeSampleFuturePair>::iterator k;
 
-  std::list<QByteArray> running_hashes;
-  std::list<QByteArray> existing_hashes;
+  QSet<QByteArray> running_hashes;
+  QSet<QByteArray> existing_hashes;
+
+  if (use_disk_cache && !hashes.isEmpty()) {
+    // Long stretches of the timeline usually share a hash, so only check each unique hash once
+    QVector<QByteArray> unique_hashes;
+    QSet<QByteArray> seen_hashes;
+
+    foreach (const QByteArray& hash, hashes) {
+      if (!seen_hashes.contains(hash)) {
+        seen_hashes.insert(hash);
+        unique_hashes.append(hash);
+      }
+    }
+
+    // Query the disk cache's index in one go rather than hitting the filesystem for every frame
+    QVector<bool> unique_exists = disk_cache_folder_->ContainsHashes(unique_hashes);
+
+    for (int k=0; k<unique_hashes.size(); k++) {
+      if (unique_exists.at(k)) {
+        existing_hashes.insert(unique_hashes.at(k));
+      }
+    }
+  }
 
   while (!IsCancelled()
          && (!render_lookup_table.empty()
              || !frame_queue.empty()
-             || !audio_queue.empty()
              || !download_futures.empty()
-             || !audio_lookup_table.empty())) {
+             || AudioLanesBusy(audio_lanes))) {
 
     while (!IsCancelled() && !frame_queue.empty()) {
 
@@ -128,7 +180,7 @@ void RenderTask::Render(const TimeRangeList& video_range,
       const HashTimePair& p = frame_queue.front();
 
       // Check if we're already rendering this hash
-      bool rendering_hash = (std::find(running_hashes.begin(), running_hashes.end(), p.hash) != running_hashes.end());
+      bool rendering_hash = running_hashes.contains(p.hash);
 
       // Skip this hash if we're already rendering it
       if (!rendering_hash) {
@@ -136,18 +188,8 @@ void RenderTask::Render(const TimeRangeList& video_range,
         bool hash_exists = false;
 
         if (use_disk_cache) {
-          // Check if this hash is in our "existing hashes" list
-          hash_exists = (std::find(existing_hashes.begin(), existing_hashes.end(), p.hash) != existing_hashes.end());
-
-          // If not, check if it's in the filesystem
-          if (!hash_exists) {
-            hash_exists = QFileInfo::exists(viewer()->video_frame_cache()->CachePathName(p.hash));
-
-            // If so, add it to the list so we don't have to check the filesystem again later
-            if (hash_exists) {
-              existing_hashes.push_back(p.hash);
-            }
-          }
+          // Check if this hash was already in the disk cache or has been rendered during this job
+          hash_exists = existing_hashes.contains(p.hash);
 
           if (hash_exists) {
             // Already exists, no need to render it again
@@ -160,7 +202,7 @@ void RenderTask::Render(const TimeRangeList& video_range,
         // If no existing disk cache was found, queue it now
         if (!hash_exists) {
           render_lookup_table.push_back({p.hash, backend_->RenderFrame(p.time)});
-          running_hashes.push_back(p.hash);
+          running_hashes.insert(p.hash);
         }
       }
 
@@ -168,9 +210,16 @@ void RenderTask::Render(const TimeRangeList& video_range,
       frame_queue.pop_front();
     }
 
-    while (!IsCancelled() && !audio_queue.empty()) {
-      audio_lookup_table.push_back({audio_queue.front(), backend_->RenderAudio(audio_queue.front())});
-      audio_queue.pop_front();
+    for (AudioLane& lane : audio_lanes) {
+      if (IsCancelled()) {
+        break;
+      }
+
+      if (!lane.sample_future && !lane.chunks.empty()) {
+        lane.range = lane.chunks.front();
+        lane.sample_future = backend_->RenderAudio(lane.range);
+        lane.chunks.pop_front();
+      }
     }
 
     i = render_lookup_table.begin();
@@ -205,7 +254,7 @@ void RenderTask::Render(const TimeRangeList& video_range,
 
         FrameDownloaded(j->hash, times_with_hash, j->job_time);
 
-        existing_hashes.push_back(j->hash);
+        existing_hashes.insert(j->hash);
 
         // Signal process
         progress_counter += times_with_hash.size() * video_frame_sz;
@@ -218,20 +267,21 @@ void RenderTask::Render(const TimeRangeList& video_range,
       }
     }
 
-    k = audio_lookup_table.begin();
+    for (AudioLane& lane : audio_lanes) {
+      if (IsCancelled()) {
+        break;
+      }
 
-    while (!IsCancelled() && k != audio_lookup_table.end()) {
-      if (k->sample_future->IsFinished()) {
-        AudioDownloaded(k->range,
-                        k->sample_future->Get().value<SampleBufferPtr>(),
-                        k->sample_future->GetJobTime());
+      if (lane.sample_future && lane.sample_future->IsFinished()) {
+        AudioDownloaded(lane.range,
+                        lane.sample_future->Get().value<SampleBufferPtr>(),
+                        lane.sample_future->GetJobTime());
 
-        progress_counter += k->range.length().toDouble();
+        progress_counter += lane.range.length().toDouble();
         emit ProgressChanged(progress_counter / total_length);
 
-        k = audio_lookup_table.erase(k);
-      } else {
-        k++;
+        // Frees the lane to request its next chunk
+        lane.sample_future = nullptr;
       }
     }
   }
@@ -25,6 +25,7 @@
 
 #include "node/output/viewer/viewer.h"
 #include "render/backend/opengl/openglbackend.h"
+#include "render/diskmanager.h"
 #include "task/task.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -67,9 +68,31 @@ protected:
     return backend_;
   }
 
+  const rational& audio_chunk_length() const
+  {
+    return audio_chunk_length_;
+  }
+
 private:
+  /**
+   * @brief Maximum number of audio chunks being rendered at once
+   */
+  static const int kAudioLaneCount;
+
   RenderBackend* backend_;
 
+  /**
+   * @brief Disk cache folder of the viewer, resolved on construction since DiskManager must be
+   * accessed from the main thread
+   */
+  DiskCacheFolder* disk_cache_folder_;
+
+  /**
+   * @brief Length of audio chunks, read from the config on construction since Config must be
+   * accessed from the main thread
+   */
+  rational audio_chunk_length_;
+
 };
 
 OLIVE_NAMESPACE_EXIT
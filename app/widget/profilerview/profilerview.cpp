@@ -0,0 +1,216 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "profilerview.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QVBoxLayout>
+
+OLIVE_NAMESPACE_ENTER
+
+const int ProfilerView::kSlowestFrameCount = 10;
+
+ProfilerView::ProfilerView(QWidget *parent) :
+  QWidget(parent)
+{
+  QVBoxLayout* layout = new QVBoxLayout(this);
+
+  QHBoxLayout* toolbar = new QHBoxLayout();
+  layout->addLayout(toolbar);
+
+  record_btn_ = new QPushButton(tr("Record"));
+  record_btn_->setCheckable(true);
+  record_btn_->setChecked(Profiler::IsEnabled());
+  connect(record_btn_, &QPushButton::toggled, this, &ProfilerView::SetRecording);
+  toolbar->addWidget(record_btn_);
+
+  QPushButton* clear_btn = new QPushButton(tr("Clear"));
+  connect(clear_btn, &QPushButton::clicked, this, &ProfilerView::ClearEvents);
+  toolbar->addWidget(clear_btn);
+
+  QPushButton* export_btn = new QPushButton(tr("Export Trace..."));
+  connect(export_btn, &QPushButton::clicked, this, &ProfilerView::ExportTrace);
+  toolbar->addWidget(export_btn);
+
+  status_lbl_ = new QLabel();
+  toolbar->addWidget(status_lbl_);
+
+  toolbar->addStretch();
+
+  tree_ = new QTreeWidget();
+  tree_->setHeaderLabels({tr("Name"), tr("Count"), tr("Total"), tr("Average"), tr("Maximum")});
+  layout->addWidget(tree_);
+
+  // Refresh while recording so the numbers can be watched during playback
+  refresh_timer_.setInterval(1000);
+  connect(&refresh_timer_, &QTimer::timeout, this, &ProfilerView::Refresh);
+
+  Refresh();
+}
+
+void ProfilerView::Refresh()
+{
+  QVector<Profiler::Event> events = Profiler::Collect();
+
+  SummaryMap totals;
+  QVector<Profiler::Event> frames;
+
+  foreach (const Profiler::Event& e, events) {
+    AddEventToSummary(totals, e);
+
+    if (!strcmp(e.category, "ticket") && !strcmp(e.name, "RenderFrame")) {
+      frames.append(e);
+    }
+  }
+
+  std::sort(frames.begin(), frames.end(), [](const Profiler::Event& a, const Profiler::Event& b){
+    return a.duration > b.duration;
+  });
+
+  if (frames.size() > kSlowestFrameCount) {
+    frames.resize(kSlowestFrameCount);
+  }
+
+  tree_->clear();
+
+  QTreeWidgetItem* totals_item = new QTreeWidgetItem({tr("Totals")});
+  tree_->addTopLevelItem(totals_item);
+  AddSummaryToItem(totals_item, totals);
+  totals_item->setExpanded(true);
+
+  QTreeWidgetItem* frames_item = new QTreeWidgetItem({tr("Slowest Frames")});
+  tree_->addTopLevelItem(frames_item);
+
+  foreach (const Profiler::Event& frame, frames) {
+    QTreeWidgetItem* frame_item = new QTreeWidgetItem({tr("Frame at %1").arg(QString::fromUtf8(frame.detail)),
+                                                       QString(),
+                                                       NanosecondsToString(frame.duration)});
+    frames_item->addChild(frame_item);
+
+    // Everything that happened on the same thread while this frame rendered was part of it
+    SummaryMap breakdown;
+
+    foreach (const Profiler::Event& e, events) {
+      if (e.thread == frame.thread
+          && e.start >= frame.start
+          && e.start + e.duration <= frame.start + frame.duration
+          && strcmp(e.category, "ticket")) {
+        AddEventToSummary(breakdown, e);
+      }
+    }
+
+    AddSummaryToItem(frame_item, breakdown);
+  }
+
+  status_lbl_->setText(tr("%n event(s)", nullptr, events.size()));
+
+  for (int i=0; i<tree_->columnCount(); i++) {
+    tree_->resizeColumnToContents(i);
+  }
+}
+
+void ProfilerView::AddEventToSummary(ProfilerView::SummaryMap &map, const Profiler::Event &e)
+{
+  QString key = QStringLiteral("%1: %2").arg(QString::fromLatin1(e.category), QString::fromLatin1(e.name));
+
+  if (e.detail[0] && strcmp(e.category, "ticket")) {
+    // Tickets are summed regardless of their detail (the time they're for)
+    key.append(QStringLiteral(" (%1)").arg(QString::fromUtf8(e.detail)));
+  }
+
+  SummaryMap::iterator i = map.find(key);
+
+  if (i == map.end()) {
+    map.insert(key, {1, e.duration, e.duration});
+  } else {
+    i->count++;
+    i->total += e.duration;
+    i->max = qMax(i->max, e.duration);
+  }
+}
+
+void ProfilerView::AddSummaryToItem(QTreeWidgetItem *parent, const ProfilerView::SummaryMap &map)
+{
+  // Sort by total time, most expensive first
+  QList<SummaryMap::const_iterator> sorted;
+
+  for (SummaryMap::const_iterator i=map.constBegin(); i!=map.constEnd(); i++) {
+    sorted.append(i);
+  }
+
+  std::sort(sorted.begin(), sorted.end(), [](const SummaryMap::const_iterator& a, const SummaryMap::const_iterator& b){
+    return a->total > b->total;
+  });
+
+  foreach (const SummaryMap::const_iterator& i, sorted) {
+    parent->addChild(new QTreeWidgetItem({i.key(),
+                                          QString::number(i->count),
+                                          NanosecondsToString(i->total),
+                                          NanosecondsToString(i->total / i->count),
+                                          NanosecondsToString(i->max)}));
+  }
+}
+
+QString ProfilerView::NanosecondsToString(qint64 ns)
+{
+  return tr("%1 ms").arg(static_cast<double>(ns) / 1000000.0, 0, 'f', 3);
+}
+
+void ProfilerView::SetRecording(bool e)
+{
+  Profiler::SetEnabled(e);
+
+  if (e) {
+    refresh_timer_.start();
+  } else {
+    refresh_timer_.stop();
+    Refresh();
+  }
+}
+
+void ProfilerView::ClearEvents()
+{
+  Profiler::Clear();
+  Refresh();
+}
+
+void ProfilerView::ExportTrace()
+{
+  QString filename = QFileDialog::getSaveFileName(this,
+                                                  tr("Export Trace"),
+                                                  QString(),
+                                                  tr("Chrome Trace (*.json)"));
+
+  if (filename.isEmpty()) {
+    return;
+  }
+
+  if (!Profiler::ExportChromeTrace(filename)) {
+    QMessageBox::critical(this,
+                          tr("Export Trace"),
+                          tr("Failed to write \"%1\".").arg(filename));
+  }
+}
+
+OLIVE_NAMESPACE_EXIT
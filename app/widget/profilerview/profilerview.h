@@ -0,0 +1,85 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROFILERVIEW_H
+#define PROFILERVIEW_H
+
+#include <QLabel>
+#include <QMap>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+
+#include "common/profiler.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Shows a summary of what the Profiler has recorded
+ *
+ * Events are totalled per category, name and detail (e.g. per node), and the slowest rendered frames are listed with a
+ * breakdown of where each one's time went.
+ */
+class ProfilerView : public QWidget
+{
+  Q_OBJECT
+public:
+  ProfilerView(QWidget* parent = nullptr);
+
+public slots:
+  void Refresh();
+
+private:
+  struct Summary {
+    int count;
+    qint64 total;
+    qint64 max;
+  };
+
+  using SummaryMap = QMap<QString, Summary>;
+
+  static void AddEventToSummary(SummaryMap& map, const Profiler::Event& e);
+
+  static void AddSummaryToItem(QTreeWidgetItem* parent, const SummaryMap& map);
+
+  static QString NanosecondsToString(qint64 ns);
+
+  static const int kSlowestFrameCount;
+
+  QPushButton* record_btn_;
+
+  QLabel* status_lbl_;
+
+  QTreeWidget* tree_;
+
+  QTimer refresh_timer_;
+
+private slots:
+  void SetRecording(bool e);
+
+  void ClearEvents();
+
+  void ExportTrace();
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // PROFILERVIEW_H
@@ -33,7 +33,9 @@
 #include "dialog/footageproperties/footageproperties.h"
 #include "dialog/sequence/sequence.h"
 #include "projectexplorerundo.h"
+#include "render/thumbnailcache.h"
 #include "task/precache/precachetask.h"
+#include "task/proxy/proxy.h"
 #include "task/taskmanager.h"
 #include "widget/menu/menu.h"
 #include "widget/menu/menushared.h"
@@ -90,6 +92,11 @@ ProjectExplorer::ProjectExplorer(QWidget *parent) :
   connect(tree_view_, &ProjectExplorerTreeView::customContextMenuRequested, this, &ProjectExplorer::ShowContextMenu);
   connect(list_view_, &ProjectExplorerListView::customContextMenuRequested, this, &ProjectExplorer::ShowContextMenu);
   connect(icon_view_, &ProjectExplorerIconView::customContextMenuRequested, this, &ProjectExplorer::ShowContextMenu);
+
+  // Repaint as poster frames become available
+  if (ThumbnailCache::instance()) {
+    connect(ThumbnailCache::instance(), &ThumbnailCache::ThumbnailsUpdated, this, &ProjectExplorer::ThumbnailsUpdated);
+  }
 }
 
 const ProjectToolbar::ViewType &ProjectExplorer::view_type() const
@@ -337,6 +344,16 @@ void ProjectExplorer::ShowContextMenu()
 
         connect(proxy_menu, &Menu::triggered, this, &ProjectExplorer::ContextMenuStartProxy);
       }
+
+      Menu* create_proxy_menu = new Menu(tr("Create Proxy"), &menu);
+      menu.addMenu(create_proxy_menu);
+
+      for (int divider=2; divider<=8; divider*=2) {
+        QAction* a = create_proxy_menu->addAction(tr("1/%1 Resolution").arg(divider));
+        a->setData(divider);
+      }
+
+      connect(create_proxy_menu, &Menu::triggered, this, &ProjectExplorer::ContextMenuCreateProxy);
     }
 
     Q_UNUSED(all_items_are_footage_or_sequence)
@@ -436,6 +453,27 @@ void ProjectExplorer::ContextMenuStartProxy(QAction *a)
   }
 }
 
+void ProjectExplorer::ThumbnailsUpdated()
+{
+  CurrentView()->viewport()->update();
+}
+
+void ProjectExplorer::ContextMenuCreateProxy(QAction *a)
+{
+  int divider = a->data().toInt();
+
+  // To get here, the `context_menu_items_` must be all kFootage
+  foreach (Item* i, context_menu_items_) {
+    VideoStreamPtr s = std::static_pointer_cast<VideoStream>(static_cast<Footage*>(i)->get_first_stream_of_type(Stream::kVideo));
+
+    // Stills decode once and stay cached, so only proper video benefits from a proxy
+    if (s && s->video_type() == VideoStream::kVideoTypeVideo) {
+      ProxyTask* proxy_task = new ProxyTask(s, divider);
+      TaskManager::instance()->AddTask(proxy_task);
+    }
+  }
+}
+
 Project *ProjectExplorer::project() const
 {
   return model_.project();
@@ -184,6 +184,10 @@ private slots:
 
   void ContextMenuStartProxy(QAction* a);
 
+  void ContextMenuCreateProxy(QAction* a);
+
+  void ThumbnailsUpdated();
+
 };
 
 OLIVE_NAMESPACE_EXIT
@@ -47,6 +47,11 @@ void ScopeBase::SetBuffer(Frame *frame)
   UploadTextureFromBuffer();
 }
 
+void ScopeBase::SetTexture(OpenGLTexture *texture)
+{
+  shared_texture_ = texture;
+}
+
 void ScopeBase::showEvent(QShowEvent* e)
 {
   ManagedDisplayWidget::showEvent(e);
@@ -77,7 +82,18 @@ void ScopeBase::UploadTextureFromBuffer()
   if (buffer_) {
     makeCurrent();
 
-    if (!texture_.IsCreated()
+    if (IsUsingSharedTexture()) {
+      // Nothing to upload, just make sure we have somewhere to convert it into
+      texture_.Destroy();
+
+      if (!managed_tex_.IsCreated()
+          || managed_tex_.width() != buffer_->width()
+          || managed_tex_.height() != buffer_->height()
+          || managed_tex_.format() != buffer_->format()) {
+        managed_tex_.Destroy();
+        managed_tex_.Create(context(), buffer_->video_params());
+      }
+    } else if (!texture_.IsCreated()
         || texture_.width() != buffer_->width()
         || texture_.height() != buffer_->height()
         || texture_.format() != buffer_->format()) {
@@ -96,6 +112,18 @@ void ScopeBase::UploadTextureFromBuffer()
   update();
 }
 
+bool ScopeBase::IsUsingSharedTexture() const
+{
+  return buffer_
+      && shared_texture_
+      && shared_texture_->IsCreated()
+      && shared_texture_->width() == buffer_->width()
+      && shared_texture_->height() == buffer_->height()
+      && shared_texture_->format() == buffer_->format()
+      && context()
+      && QOpenGLContext::areSharing(context(), shared_texture_->context());
+}
+
 void ScopeBase::CleanUp()
 {
   makeCurrent();
@@ -128,18 +156,20 @@ void ScopeBase::paintGL()
   f->glClearColor(0, 0, 0, 0);
   f->glClear(GL_COLOR_BUFFER_BIT);
 
-  if (buffer_ && pipeline() && texture_.IsCreated()) {
+  bool shared = IsUsingSharedTexture();
+
+  if (buffer_ && pipeline() && (shared || texture_.IsCreated())) {
     // Convert reference frame to display space
     framebuffer_.Attach(&managed_tex_);
     framebuffer_.Bind();
 
-    texture_.Bind();
+    f->glBindTexture(GL_TEXTURE_2D, shared ? shared_texture_->texture() : texture_.texture());
 
-    f->glViewport(0, 0, texture_.width(), texture_.height());
+    f->glViewport(0, 0, managed_tex_.width(), managed_tex_.height());
 
     color_service()->ProcessOpenGL();
 
-    texture_.Release();
+    f->glBindTexture(GL_TEXTURE_2D, 0);
 
     framebuffer_.Release();
     framebuffer_.Detach();
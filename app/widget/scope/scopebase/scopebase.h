@@ -21,6 +21,8 @@
 #ifndef SCOPEBASE_H
 #define SCOPEBASE_H
 
+#include <QPointer>
+
 #include "codec/frame.h"
 #include "render/backend/opengl/openglcolorprocessor.h"
 #include "render/backend/opengl/openglframebuffer.h"
@@ -40,6 +42,14 @@ public:
 public slots:
   void SetBuffer(Frame* frame);
 
+  /**
+   * @brief Draw from a texture that already contains the buffer instead of uploading it again
+   *
+   * The texture must belong to a context that shares with this one. If it doesn't match the buffer set with
+   * SetBuffer(), the buffer is uploaded as normal.
+   */
+  void SetTexture(OpenGLTexture* texture);
+
 protected:
   virtual void initializeGL() override;
 
@@ -69,6 +79,8 @@ protected:
 private:
   void UploadTextureFromBuffer();
 
+  bool IsUsingSharedTexture() const;
+
   OpenGLShaderPtr pipeline_;
 
   OpenGLTexture texture_;
@@ -79,6 +91,8 @@ private:
 
   Frame* buffer_;
 
+  QPointer<OpenGLTexture> shared_texture_;
+
 private slots:
   void CleanUp();
 
@@ -32,6 +32,7 @@
 #include "common/timecodefunctions.h"
 #include "node/input/media/media.h"
 #include "project/item/footage/footage.h"
+#include "render/thumbnailcache.h"
 
 OLIVE_NAMESPACE_ENTER
 
@@ -49,6 +50,12 @@ TimelineView::TimelineView(Qt::Alignment vertical_alignment, QWidget *parent) :
   setBackgroundRole(QPalette::Window);
   setContextMenuPolicy(Qt::CustomContextMenu);
   viewport()->setMouseTracking(true);
+
+  // Redraw filmstrips as their thumbnails arrive
+  if (ThumbnailCache::instance()) {
+    connect(ThumbnailCache::instance(), &ThumbnailCache::ThumbnailsUpdated,
+            viewport(), static_cast<void(QWidget::*)()>(&QWidget::update));
+  }
 }
 
 void TimelineView::mousePressEvent(QMouseEvent *event)
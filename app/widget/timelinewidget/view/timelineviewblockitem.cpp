@@ -28,11 +28,14 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QtMath>
 
 #include "common/qtutils.h"
 #include "config/config.h"
 #include "core.h"
 #include "node/block/transition/transition.h"
+#include "node/input/media/media.h"
+#include "render/thumbnailcache.h"
 #include "widget/viewer/audiowaveformview.h"
 
 OLIVE_NAMESPACE_ENTER
@@ -86,6 +89,8 @@ void TimelineViewBlockItem::paint(QPainter *painter, const QStyleOptionGraphicsI
 
     painter->fillRect(rect(), grad);
 
+    DrawFilmstrip(painter, option->exposedRect);
+
     if (option->state & QStyle::State_Selected) {
       painter->fillRect(rect(), QColor(0, 0, 0, 64));
     }
@@ -194,4 +199,60 @@ void TimelineViewBlockItem::paint(QPainter *painter, const QStyleOptionGraphicsI
   }
 }
 
+void TimelineViewBlockItem::DrawFilmstrip(QPainter *painter, const QRectF &exposed)
+{
+  if (!ThumbnailCache::instance()) {
+    return;
+  }
+
+  VideoStreamPtr stream = nullptr;
+
+  foreach (MediaInput* media, block_->FindInputNodes<MediaInput>()) {
+    if (media->type() == Stream::kVideo && media->stream()) {
+      stream = std::static_pointer_cast<VideoStream>(media->stream());
+      break;
+    }
+  }
+
+  if (!stream || stream->height() == 0) {
+    return;
+  }
+
+  // Leave the label visible above the filmstrip
+  QRectF strip_rect = rect().adjusted(1, TrackOutput::GetMinimumTrackHeightInPixels(), 0, -1);
+
+  if (strip_rect.height() < 8) {
+    return;
+  }
+
+  double tile_width = strip_rect.height() * stream->width() * stream->pixel_aspect_ratio().toDouble() / stream->height();
+  if (tile_width < 1) {
+    return;
+  }
+
+  QRectF visible_rect = strip_rect.intersected(exposed);
+
+  if (visible_rect.isEmpty()) {
+    return;
+  }
+
+  painter->save();
+  painter->setClipRect(strip_rect);
+
+  // Align tiles to the start of the clip so they don't shift while scrolling
+  double x = strip_rect.left() + qFloor((visible_rect.left() - strip_rect.left()) / tile_width) * tile_width;
+
+  for (; x<visible_rect.right(); x+=tile_width) {
+    rational media_time = block_->SequenceToMediaTime(block_->in() + SceneToTime(x - rect().left()));
+
+    QImage thumbnail = ThumbnailCache::instance()->GetThumbnail(stream, media_time);
+
+    if (!thumbnail.isNull()) {
+      painter->drawImage(QRectF(x, strip_rect.top(), tile_width, strip_rect.height()), thumbnail);
+    }
+  }
+
+  painter->restore();
+}
+
 OLIVE_NAMESPACE_EXIT
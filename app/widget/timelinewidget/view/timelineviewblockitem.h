@@ -42,6 +42,11 @@ protected:
   virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
 
 private:
+  /**
+   * @brief Draws thumbnails of the clip's video below its label, only within the exposed area
+   */
+  void DrawFilmstrip(QPainter* painter, const QRectF& exposed);
+
   Block* block_;
 
 };
@@ -387,6 +387,9 @@ FramePtr ViewerWidget::DecodeCachedImage(const QString &fn, const rational& time
 
   if (frame) {
     frame->set_timestamp(time);
+
+    // Copy into a pixel buffer now so the GUI thread doesn't have to when this frame is shown
+    display_widget_->upload_ring()->Stage(frame);
   } else {
     qWarning() << "Tried to load cached frame from file but it was null";
   }
@@ -525,6 +528,8 @@ void ViewerWidget::PauseInternal()
 
     playback_queue_.clear();
     playback_backup_timer_.stop();
+
+    prefetcher_.Clear();
   }
 
   prequeuing_ = false;
@@ -604,6 +609,8 @@ void ViewerWidget::SetDisplayImage(FramePtr frame, bool main_only)
     }
   }
 
+  // Emitted first so receivers can use the texture rather than uploading the buffer themselves
+  emit LoadedTexture(display_widget_->texture());
   emit LoadedBuffer(frame.get());
 }
 
@@ -617,6 +624,34 @@ void ViewerWidget::RequestNextFrameForQueue()
   RenderTicketWatcher* watcher = new RenderTicketWatcher();
   connect(watcher, &RenderTicketWatcher::Finished, this, &ViewerWidget::RendererGeneratedFrameForQueue);
   watcher->SetTicket(GetFrame(next_time, false));
+
+  ReadAheadFromQueue();
+}
+
+void ViewerWidget::ReadAheadFromQueue()
+{
+  FrameHashCache* cache = GetConnectedNode()->video_frame_cache();
+
+  int64_t end_ts = Timecode::time_to_timestamp(cache->GetLength(), timebase());
+
+  QStringList read_ahead;
+
+  // Walk past the frames already queued for decoding in the direction and speed of playback
+  for (int i=0; i<ViewerPrefetcher::kReadAheadLength; i++) {
+    int64_t ts = playback_queue_next_frame_ + i * playback_speed_;
+
+    if (ts < 0 || ts >= end_ts) {
+      break;
+    }
+
+    QByteArray hash = cache->GetHash(Timecode::timestamp_to_time(ts, timebase()));
+
+    if (!hash.isEmpty()) {
+      read_ahead.append(cache->CachePathName(hash));
+    }
+  }
+
+  prefetcher_.ReadAhead(read_ahead);
 }
 
 PixelFormat::Format ViewerWidget::GetCurrentPixelFormat() const
@@ -641,7 +676,7 @@ RenderTicketPtr ViewerWidget::GetFrame(const rational &t, bool clear_render_queu
     // Frame has been cached, grab the frame
     RenderTicketPtr ticket = std::make_shared<RenderTicket>(RenderTicket::kTypeVideo,
                                                             QVariant::fromValue(t));
-    QtConcurrent::run(this, &ViewerWidget::DecodeCachedImage, ticket, cache_fn, t);
+    QtConcurrent::run(prefetcher_.decode_pool(), this, &ViewerWidget::DecodeCachedImage, ticket, cache_fn, t);
 
     return ticket;
   }
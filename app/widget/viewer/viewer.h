@@ -36,6 +36,7 @@
 #include "render/backend/renderticketwatcher.h"
 #include "viewerdisplay.h"
 #include "viewerplaybacktimer.h"
+#include "viewerprefetcher.h"
 #include "viewerqueue.h"
 #include "viewersizer.h"
 #include "viewerwindow.h"
@@ -137,6 +138,11 @@ signals:
    */
   void LoadedBuffer(Frame* load_buffer);
 
+  /**
+   * @brief Signal emitted alongside LoadedBuffer() with the texture the frame was uploaded into
+   */
+  void LoadedTexture(OLIVE_NAMESPACE::OpenGLTexture* texture);
+
   /**
    * @brief Request a scope panel
    *
@@ -196,6 +202,8 @@ private:
 
   void RequestNextFrameForQueue();
 
+  void ReadAheadFromQueue();
+
   PixelFormat::Format GetCurrentPixelFormat() const;
 
   RenderTicketPtr GetFrame(const rational& t, bool clear_render_queue);
@@ -246,6 +254,8 @@ private:
   ViewerQueue playback_queue_;
   int64_t playback_queue_next_frame_;
 
+  ViewerPrefetcher prefetcher_;
+
   RenderBackend* renderer_;
 
   bool prequeuing_;
@@ -108,11 +108,21 @@ void ViewerDisplayWidget::SetImage(FramePtr in_buffer)
         || texture_.width() != in_buffer->width()
         || texture_.height() != in_buffer->height()
         || texture_.format() != in_buffer->format()) {
-      texture_.Create(context(), in_buffer->video_params(), in_buffer->data(), in_buffer->linesize_pixels());
-    } else {
+      texture_.Create(context(), in_buffer->video_params());
+    }
+
+    // Prefer uploading from a buffer a decode thread already copied this frame into
+    if (!upload_ring_.Upload(&texture_, in_buffer.get())) {
       texture_.Upload(in_buffer);
     }
 
+    upload_ring_.Prepare(in_buffer->allocated_size());
+
+    // Make sure other contexts sharing this texture see the new frame
+    if (context()) {
+      context()->functions()->glFlush();
+    }
+
     doneCurrent();
   }
 
@@ -289,6 +299,8 @@ void ViewerDisplayWidget::initializeGL()
 {
   ManagedDisplayWidget::initializeGL();
 
+  upload_ring_.Create(context());
+
   connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &ViewerDisplayWidget::ContextCleanup, Qt::DirectConnection);
 }
 
@@ -430,6 +442,7 @@ void ViewerDisplayWidget::ContextCleanup()
 {
   makeCurrent();
 
+  upload_ring_.Destroy();
   texture_.Destroy();
 
   doneCurrent();
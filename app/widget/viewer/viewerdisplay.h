@@ -28,6 +28,7 @@
 #include "render/backend/opengl/openglframebuffer.h"
 #include "render/backend/opengl/openglshader.h"
 #include "render/backend/opengl/opengltexture.h"
+#include "render/backend/opengl/opengluploadring.h"
 #include "render/color.h"
 #include "render/colormanager.h"
 #include "tool/tool.h"
@@ -87,6 +88,25 @@ public:
 
   FramePtr last_loaded_buffer() const;
 
+  /**
+   * @brief Texture containing the last loaded buffer
+   *
+   * All widget contexts share resources, so other widgets (e.g. scopes) can draw this directly instead of
+   * uploading the same frame again.
+   */
+  OpenGLTexture* texture()
+  {
+    return &texture_;
+  }
+
+  /**
+   * @brief Buffers that decode threads can stage upcoming frames into, see OpenGLUploadRing::Stage()
+   */
+  OpenGLUploadRing* upload_ring()
+  {
+    return &upload_ring_;
+  }
+
   /**
    * @brief Transform a point from viewer space to the buffer space.
    * Multiplies by the inverted transform matrix to undo the scaling and translation.
@@ -213,6 +233,11 @@ private:
    */
   OpenGLTexture texture_;
 
+  /**
+   * @brief Mapped pixel buffers used to upload frames into texture_ without copying on this thread
+   */
+  OpenGLUploadRing upload_ring_;
+
   /**
    * @brief Translation only matrix (defaults to identity).
    */
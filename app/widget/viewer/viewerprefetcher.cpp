@@ -0,0 +1,134 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "viewerprefetcher.h"
+
+#include <QFile>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(Q_OS_MAC)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+OLIVE_NAMESPACE_ENTER
+
+const int ViewerPrefetcher::kReadAheadLength = 32;
+
+ViewerPrefetcher::ViewerPrefetcher()
+{
+  decode_pool_.setMaxThreadCount(QThread::idealThreadCount());
+
+  // Hints are mostly waiting on I/O, so a couple of threads are enough to keep the disk busy
+  hint_pool_.setMaxThreadCount(2);
+}
+
+ViewerPrefetcher::~ViewerPrefetcher()
+{
+  Clear();
+
+  hint_pool_.waitForDone();
+  decode_pool_.waitForDone();
+}
+
+void ViewerPrefetcher::ReadAhead(const QStringList &filenames)
+{
+  QMutexLocker locker(&hinted_lock_);
+
+  int generation = generation_;
+
+  QSet<QString> window;
+
+  foreach (const QString& fn, filenames) {
+    if (window.contains(fn)) {
+      continue;
+    }
+
+    window.insert(fn);
+
+    if (!hinted_.contains(fn)) {
+      QtConcurrent::run(&hint_pool_, this, &ViewerPrefetcher::HintFile, fn, generation);
+    }
+  }
+
+  // Drop anything that's no longer ahead of the playhead
+  hinted_ = window;
+}
+
+void ViewerPrefetcher::Clear()
+{
+  QMutexLocker locker(&hinted_lock_);
+
+  // Any hint that's already running will see the generation change and stop early
+  generation_++;
+
+  hint_pool_.clear();
+  hinted_.clear();
+}
+
+void ViewerPrefetcher::HintFile(const QString &filename, int generation)
+{
+  if (generation != generation_) {
+    return;
+  }
+
+#if defined(Q_OS_LINUX)
+  int fd = open(filename.toUtf8().constData(), O_RDONLY);
+
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+  }
+#elif defined(Q_OS_MAC)
+  int fd = open(filename.toUtf8().constData(), O_RDONLY);
+
+  if (fd >= 0) {
+    struct stat st;
+
+    if (fstat(fd, &st) == 0) {
+      struct radvisory advice;
+      advice.ra_offset = 0;
+      advice.ra_count = static_cast<int>(st.st_size);
+      fcntl(fd, F_RDADVISE, &advice);
+    }
+
+    close(fd);
+  }
+#else
+  // No asynchronous read-ahead hint available, so read the file ourselves to pull it into the
+  // system cache
+  QFile f(filename);
+
+  if (f.open(QFile::ReadOnly)) {
+    QByteArray buffer(1048576, Qt::Uninitialized);
+
+    while (generation == generation_ && f.read(buffer.data(), buffer.size()) > 0) {}
+
+    f.close();
+  }
+#endif
+}
+
+OLIVE_NAMESPACE_EXIT
@@ -0,0 +1,94 @@
+/***
+
+  Olive - Non-Linear Video Editor
+  Copyright (C) 2019 Olive Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef VIEWERPREFETCHER_H
+#define VIEWERPREFETCHER_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "common/define.h"
+
+OLIVE_NAMESPACE_ENTER
+
+/**
+ * @brief Read-ahead pipeline for playing back frames from the disk cache
+ *
+ * Decoding cached frames happens on a dedicated thread pool so playback isn't starved by render
+ * jobs on the global pool. Frames further ahead than the decode queue are hinted to the OS so
+ * their data is already in the page cache by the time they're decoded, which keeps playback
+ * at frame rate on slow (spinning or network) storage.
+ */
+class ViewerPrefetcher
+{
+public:
+  ViewerPrefetcher();
+
+  ~ViewerPrefetcher();
+
+  /**
+   * @brief Thread pool that cached frames should be decoded on
+   */
+  QThreadPool* decode_pool()
+  {
+    return &decode_pool_;
+  }
+
+  /**
+   * @brief Asynchronously ask the OS to start reading these files into memory
+   *
+   * `filenames` should be the whole read-ahead window. Files that were already hinted in the
+   * previous window are skipped, and anything that has fallen out of the window (i.e. is now behind
+   * the playhead) is forgotten so the set of hinted files never grows beyond the window.
+   */
+  void ReadAhead(const QStringList& filenames);
+
+  /**
+   * @brief Discard any hints that haven't been processed yet
+   */
+  void Clear();
+
+  /**
+   * @brief Number of frames beyond the decode queue to read ahead of
+   */
+  static const int kReadAheadLength;
+
+private:
+  void HintFile(const QString& filename, int generation);
+
+  QThreadPool decode_pool_;
+
+  QThreadPool hint_pool_;
+
+  QMutex hinted_lock_;
+
+  // Files in the last read-ahead window
+  QSet<QString> hinted_;
+
+  QAtomicInt generation_;
+
+};
+
+OLIVE_NAMESPACE_EXIT
+
+#endif // VIEWERPREFETCHER_H
@@ -22,11 +22,15 @@
 
 #include <QDesktopServices>
 #include <QEvent>
+#include <QMessageBox>
 #include <QStyleFactory>
 
+#include "codec/ffmpeg/ffmpegdecodebudget.h"
+#include "common/bufferpool.h"
 #include "common/timecodefunctions.h"
 #include "config/config.h"
 #include "core.h"
+#include "render/audioplaybackcache.h"
 #include "dialog/actionsearch/actionsearch.h"
 #include "dialog/task/task.h"
 #include "panel/panelmanager.h"
@@ -252,6 +256,7 @@ MainMenu::MainMenu(MainWindow *parent) :
   help_action_search_item_ = help_menu_->AddItem("actionsearch", this, &MainMenu::ActionSearchTriggered, "/");
   help_menu_->addSeparator();
   help_feedback_item_ = help_menu_->AddItem("feedback", this, &MainMenu::HelpFeedbackTriggered);
+  help_memory_statistics_item_ = help_menu_->AddItem("memorystats", this, &MainMenu::HelpMemoryStatisticsTriggered);
   help_menu_->addSeparator();
   help_about_item_ = help_menu_->AddItem("about", Core::instance(), &Core::DialogAboutShow);
 
@@ -587,6 +592,55 @@ void MainMenu::HelpFeedbackTriggered()
   QDesktopServices::openUrl(QStringLiteral("https://github.com/olive-editor/olive/issues"));
 }
 
+void MainMenu::HelpMemoryStatisticsTriggered()
+{
+  QVector<BufferPool::Statistics> stats = BufferPool::instance()->GetStatistics();
+
+  QString table = QStringLiteral("<table cellpadding=\"4\"><tr><th>%1</th><th>%2</th><th>%3</th></tr>").arg(
+        tr("Buffer Size"), tr("In Use"), tr("Allocated"));
+
+  size_t total = 0;
+
+  foreach (const BufferPool::Statistics& s, stats) {
+    table.append(QStringLiteral("<tr><td>%1 KB</td><td>%2 / %3</td><td>%4 MB</td></tr>").arg(
+                   QString::number(s.buffer_size / 1024),
+                   QString::number(s.used),
+                   QString::number(s.capacity),
+                   QString::number(static_cast<double>(s.allocated_size) / 1048576.0, 'f', 1)));
+
+    total += s.allocated_size;
+  }
+
+  table.append(QStringLiteral("</table>"));
+
+  QVector<FFmpegDecodeBudget::StreamStatistics> decode_stats = FFmpegDecodeBudget::GetStatistics();
+
+  if (!decode_stats.isEmpty()) {
+    table.append(QStringLiteral("<p><table cellpadding=\"4\"><tr><th>%1</th><th>%2</th><th>%3</th><th>%4</th></tr>").arg(
+                   tr("Stream"), tr("Decoders"), tr("Decode FPS"), tr("Queued Frames")));
+
+    foreach (const FFmpegDecodeBudget::StreamStatistics& s, decode_stats) {
+      table.append(QStringLiteral("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td></tr>").arg(
+                     s.name.toHtmlEscaped(),
+                     QString::number(s.instance_count),
+                     QString::number(s.decode_fps, 'f', 1),
+                     QString::number(s.queue_depth)));
+    }
+
+    table.append(QStringLiteral("</table></p>"));
+  }
+
+  QMessageBox b(parentWidget());
+  b.setIcon(QMessageBox::Information);
+  b.setWindowTitle(tr("Memory Statistics"));
+  b.setText(tr("Frame and audio buffer pool: %1 MB allocated\n"
+               "Audio playback underruns: %2").arg(
+              QString::number(static_cast<double>(total) / 1048576.0, 'f', 1),
+              QString::number(AudioPlaybackCache::PlaybackDevice::GetTotalXrunCount())));
+  b.setInformativeText(table);
+  b.exec();
+}
+
 void MainMenu::Retranslate()
 {
   // MenuShared is not a QWidget and therefore does not receive a LanguageEvent, we use MainMenu's to update it
@@ -681,6 +735,7 @@ void MainMenu::Retranslate()
   help_menu_->setTitle(tr("&Help"));
   help_action_search_item_->setText(tr("A&ction Search"));
   help_feedback_item_->setText(tr("Send &Feedback..."));
+  help_memory_statistics_item_->setText(tr("&Memory Statistics..."));
   help_about_item_->setText(tr("&About..."));
 }
 
@@ -174,6 +174,8 @@ private slots:
 
   void HelpFeedbackTriggered();
 
+  void HelpMemoryStatisticsTriggered();
+
 private:
   /**
    * @brief Set strings based on the current application language.
@@ -266,6 +268,7 @@ private:
   Menu* help_menu_;
   QAction* help_action_search_item_;
   QAction* help_feedback_item_;
+  QAction* help_memory_statistics_item_;
   QAction* help_about_item_;
 
 };
@@ -81,6 +81,7 @@ MainWindow::MainWindow(QWidget *parent) :
   task_man_panel_ = PanelManager::instance()->CreatePanel<TaskManagerPanel>(this);
   AppendTimelinePanel();
   audio_monitor_panel_ = PanelManager::instance()->CreatePanel<AudioMonitorPanel>(this);
+  profiler_panel_ = PanelManager::instance()->CreatePanel<ProfilerPanel>(this);
 
   // Make node-related connections
   connect(node_panel_, &NodePanel::NodesSelected, param_panel_, &ParamPanel::SelectNodes);
@@ -610,6 +611,10 @@ void MainWindow::SetDefaultLayout()
   task_man_panel_->setFloating(true);
   addDockWidget(Qt::BottomDockWidgetArea, task_man_panel_);
 
+  profiler_panel_->hide();
+  profiler_panel_->setFloating(true);
+  addDockWidget(Qt::BottomDockWidgetArea, profiler_panel_);
+
   audio_monitor_panel_->show();
   addDockWidget(Qt::BottomDockWidgetArea, audio_monitor_panel_);
 
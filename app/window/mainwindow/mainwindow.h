@@ -38,6 +38,7 @@
 #include "panel/footageviewer/footageviewer.h"
 #include "panel/sequenceviewer/sequenceviewer.h"
 #include "panel/pixelsampler/pixelsamplerpanel.h"
+#include "panel/profiler/profiler.h"
 #include "project/project.h"
 
 #ifdef Q_OS_WINDOWS
@@ -146,6 +147,7 @@ private:
   AudioMonitorPanel* audio_monitor_panel_;
   TaskManagerPanel* task_man_panel_;
   PixelSamplerPanel* pixel_sampler_panel_;
+  ProfilerPanel* profiler_panel_;
   QList<ScopePanel*> scope_panels_;
   NodeTablePanel* table_panel_;
 